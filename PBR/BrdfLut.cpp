@@ -0,0 +1,300 @@
+#include "BrdfLut.h"
+#include "HalfFloat.h"
+#include "ImportanceSampling.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__AVX2__)
+#define BRDF_LUT_AVX2 1
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BRDF_LUT_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// Entries evaluated together by the vector paths.
+	const int BlockSize = 8;
+
+	// The parts of a half vector the integral needs. V has no y component, so H.y never contributes.
+	struct HalfVector
+	{
+		float x;
+		float z;
+	};
+
+	// Per roughness data shared by every entry in a row.
+	struct RowContext
+	{
+		std::vector<HalfVector> Samples;
+		float K;
+		float InvSampleCount;
+	};
+
+	void PrepareRow(const float roughness, const int sampleCount, RowContext& row)
+	{
+		row.Samples.resize(sampleCount);
+		for (int i = 0; i < sampleCount; ++i)
+		{
+			// With N = +Z the shader's tangent frame maps (x, y, z) to (y, -x, z).
+			float x, y, z;
+			ImportanceSampleGGX(i, sampleCount, roughness, x, y, z);
+			const float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+			row.Samples[i].x = y * invLength;
+			row.Samples[i].z = z * invLength;
+		}
+
+		row.K = roughness * roughness / 2.0f;
+		row.InvSampleCount = 1.0f / float(sampleCount);
+	}
+
+	void IntegrateScalar(const RowContext& row, const float NdotV, float* scaleBias)
+	{
+		const float Vx = std::sqrt(1.0f - NdotV * NdotV);
+		const float geometryV = NdotV / (NdotV * (1.0f - row.K) + row.K);
+
+		float A = 0.0f;
+		float B = 0.0f;
+		for (size_t i = 0; i < row.Samples.size(); ++i)
+		{
+			const HalfVector& H = row.Samples[i];
+			const float VdotH = Vx * H.x + NdotV * H.z;
+			const float NdotL = 2.0f * VdotH * H.z - NdotV;
+
+			if (NdotL > 0.0f)
+			{
+				const float clampedVdotH = std::max(VdotH, 0.0f);
+				const float geometryL = NdotL / (NdotL * (1.0f - row.K) + row.K);
+				const float visibility = geometryV * geometryL * clampedVdotH / (H.z * NdotV);
+				const float t = 1.0f - clampedVdotH;
+				const float Fc = t * t * t * t * t;
+
+				A += (1.0f - Fc) * visibility;
+				B += Fc * visibility;
+			}
+		}
+
+		scaleBias[0] = A * row.InvSampleCount;
+		scaleBias[1] = B * row.InvSampleCount;
+	}
+
+#if defined(BRDF_LUT_AVX2)
+	// Eight consecutive NdotV values in one register.
+	void IntegrateBlock(const RowContext& row, const float* NdotVs, float* scaleBias)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 k = _mm256_set1_ps(row.K);
+		const __m256 oneMinusK = _mm256_set1_ps(1.0f - row.K);
+
+		const __m256 NdotV = _mm256_loadu_ps(NdotVs);
+		const __m256 Vx = _mm256_sqrt_ps(_mm256_sub_ps(one, _mm256_mul_ps(NdotV, NdotV)));
+		const __m256 geometryV = _mm256_div_ps(NdotV, _mm256_add_ps(_mm256_mul_ps(NdotV, oneMinusK), k));
+
+		__m256 A = zero;
+		__m256 B = zero;
+		for (size_t i = 0; i < row.Samples.size(); ++i)
+		{
+			const __m256 Hx = _mm256_set1_ps(row.Samples[i].x);
+			const __m256 Hz = _mm256_set1_ps(row.Samples[i].z);
+
+			const __m256 VdotH = _mm256_add_ps(_mm256_mul_ps(Vx, Hx), _mm256_mul_ps(NdotV, Hz));
+			const __m256 NdotL = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(VdotH, VdotH), Hz), NdotV);
+			const __m256 mask = _mm256_cmp_ps(NdotL, zero, _CMP_GT_OQ);
+
+			const __m256 clampedVdotH = _mm256_max_ps(VdotH, zero);
+			const __m256 geometryL = _mm256_div_ps(NdotL, _mm256_add_ps(_mm256_mul_ps(NdotL, oneMinusK), k));
+			const __m256 visibility = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(geometryV, geometryL), clampedVdotH),
+			                                        _mm256_mul_ps(Hz, NdotV));
+
+			const __m256 t = _mm256_sub_ps(one, clampedVdotH);
+			const __m256 t2 = _mm256_mul_ps(t, t);
+			const __m256 Fc = _mm256_mul_ps(_mm256_mul_ps(t2, t2), t);
+			const __m256 maskedVisibility = _mm256_and_ps(mask, visibility);
+
+			A = _mm256_add_ps(A, _mm256_mul_ps(_mm256_sub_ps(one, Fc), maskedVisibility));
+			B = _mm256_add_ps(B, _mm256_mul_ps(Fc, maskedVisibility));
+		}
+
+		const __m256 scale = _mm256_set1_ps(row.InvSampleCount);
+		float a[BlockSize];
+		float b[BlockSize];
+		_mm256_storeu_ps(a, _mm256_mul_ps(A, scale));
+		_mm256_storeu_ps(b, _mm256_mul_ps(B, scale));
+
+		for (int i = 0; i < BlockSize; ++i)
+		{
+			scaleBias[i * 2 + 0] = a[i];
+			scaleBias[i * 2 + 1] = b[i];
+		}
+	}
+#elif defined(BRDF_LUT_SSE)
+	// Eight consecutive NdotV values as two registers of four, sharing each sample's loads.
+	void IntegrateBlock(const RowContext& row, const float* NdotVs, float* scaleBias)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 k = _mm_set1_ps(row.K);
+		const __m128 oneMinusK = _mm_set1_ps(1.0f - row.K);
+
+		__m128 NdotV[2];
+		__m128 Vx[2];
+		__m128 geometryV[2];
+		__m128 A[2];
+		__m128 B[2];
+		for (int half = 0; half < 2; ++half)
+		{
+			NdotV[half] = _mm_loadu_ps(NdotVs + half * 4);
+			Vx[half] = _mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(NdotV[half], NdotV[half])));
+			geometryV[half] = _mm_div_ps(NdotV[half], _mm_add_ps(_mm_mul_ps(NdotV[half], oneMinusK), k));
+			A[half] = zero;
+			B[half] = zero;
+		}
+
+		for (size_t i = 0; i < row.Samples.size(); ++i)
+		{
+			const __m128 Hx = _mm_set1_ps(row.Samples[i].x);
+			const __m128 Hz = _mm_set1_ps(row.Samples[i].z);
+
+			for (int half = 0; half < 2; ++half)
+			{
+				const __m128 VdotH = _mm_add_ps(_mm_mul_ps(Vx[half], Hx), _mm_mul_ps(NdotV[half], Hz));
+				const __m128 NdotL = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(VdotH, VdotH), Hz), NdotV[half]);
+				const __m128 mask = _mm_cmpgt_ps(NdotL, zero);
+
+				const __m128 clampedVdotH = _mm_max_ps(VdotH, zero);
+				const __m128 geometryL = _mm_div_ps(NdotL, _mm_add_ps(_mm_mul_ps(NdotL, oneMinusK), k));
+				const __m128 visibility = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(geometryV[half], geometryL), clampedVdotH),
+				                                     _mm_mul_ps(Hz, NdotV[half]));
+
+				const __m128 t = _mm_sub_ps(one, clampedVdotH);
+				const __m128 t2 = _mm_mul_ps(t, t);
+				const __m128 Fc = _mm_mul_ps(_mm_mul_ps(t2, t2), t);
+				const __m128 maskedVisibility = _mm_and_ps(mask, visibility);
+
+				A[half] = _mm_add_ps(A[half], _mm_mul_ps(_mm_sub_ps(one, Fc), maskedVisibility));
+				B[half] = _mm_add_ps(B[half], _mm_mul_ps(Fc, maskedVisibility));
+			}
+		}
+
+		const __m128 scale = _mm_set1_ps(row.InvSampleCount);
+		float a[BlockSize];
+		float b[BlockSize];
+		for (int half = 0; half < 2; ++half)
+		{
+			_mm_storeu_ps(a + half * 4, _mm_mul_ps(A[half], scale));
+			_mm_storeu_ps(b + half * 4, _mm_mul_ps(B[half], scale));
+		}
+
+		for (int i = 0; i < BlockSize; ++i)
+		{
+			scaleBias[i * 2 + 0] = a[i];
+			scaleBias[i * 2 + 1] = b[i];
+		}
+	}
+#else
+	void IntegrateBlock(const RowContext& row, const float* NdotVs, float* scaleBias)
+	{
+		for (int i = 0; i < BlockSize; ++i)
+		{
+			IntegrateScalar(row, NdotVs[i], scaleBias + i * 2);
+		}
+	}
+#endif
+
+	void GenerateRow(const int size, const int sampleCount, const int y, const std::vector<float>& NdotVs,
+	                 RowContext& row, float* scaleBias)
+	{
+		PrepareRow((float(y) + 0.5f) / float(size), sampleCount, row);
+
+		int x = 0;
+		for (; x + BlockSize <= size; x += BlockSize)
+		{
+			IntegrateBlock(row, NdotVs.data() + x, scaleBias + size_t(x) * 2);
+		}
+
+		for (; x < size; ++x)
+		{
+			IntegrateScalar(row, NdotVs[x], scaleBias + size_t(x) * 2);
+		}
+	}
+}
+
+BrdfLut::BrdfLut()
+{
+}
+
+BrdfLut::~BrdfLut()
+{
+}
+
+void BrdfLut::Generate(const int size, const int sampleCount, JobSystem& jobs, std::vector<float>& scaleBias)
+{
+	scaleBias.assign(size_t(size) * size * 2, 0.0f);
+
+	std::vector<float> NdotVs(size);
+	for (int x = 0; x < size; ++x)
+	{
+		NdotVs[x] = (float(x) + 0.5f) / float(size);
+	}
+
+	// Every row costs the same whatever its roughness, so each is a job of its own.
+	jobs.ParallelFor(size, 1, [&](const int first, const int last)
+	{
+		RowContext row;
+		for (int y = first; y < last; ++y)
+		{
+			GenerateRow(size, sampleCount, y, NdotVs, row, scaleBias.data() + size_t(y) * size * 2);
+		}
+	});
+}
+
+void BrdfLut::ToHalf(const std::vector<float>& scaleBias, std::vector<uint16_t>& texels)
+{
+	texels.resize(scaleBias.size());
+	for (size_t i = 0; i < scaleBias.size(); ++i)
+	{
+		texels[i] = FloatToHalf(scaleBias[i]);
+	}
+}
+
+bool BrdfLut::WriteHeader(const char* fileName, const int size, const int sampleCount,
+                          const std::vector<float>& scaleBias)
+{
+	FILE* file = std::fopen(fileName, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	std::vector<uint16_t> texels;
+	ToHalf(scaleBias, texels);
+
+	std::fprintf(file, "#pragma once\n\n");
+	std::fprintf(file, "#include <cstdint>\n\n");
+	std::fprintf(file, "// Generated by PBRBake --brdf-header with %d samples per texel. Do not edit.\n", sampleCount);
+	std::fprintf(file, "// Split sum scale and bias as R16G16_FLOAT pairs, rows by roughness and columns by NdotV.\n\n");
+	std::fprintf(file, "constexpr int BrdfLutTableSize = %d;\n\n", size);
+	std::fprintf(file, "constexpr uint16_t BrdfLutTable[BrdfLutTableSize * BrdfLutTableSize * 2] =\n{\n");
+
+	for (int y = 0; y < size; ++y)
+	{
+		const uint16_t* row = texels.data() + size_t(y) * size * 2;
+		for (int i = 0; i < size * 2; ++i)
+		{
+			std::fprintf(file, "%s0x%04x,", i % 16 == 0 ? "\t" : " ", unsigned(row[i]));
+			if (i % 16 == 15 || i == size * 2 - 1)
+			{
+				std::fprintf(file, "\n");
+			}
+		}
+	}
+
+	std::fprintf(file, "};\n");
+
+	const bool success = std::ferror(file) == 0;
+	return std::fclose(file) == 0 && success;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// CPU version of IntegrateBRDF.shader, the split sum scale and bias lookup table.
+// The table only depends on NdotV and roughness, so it can be generated anywhere, including at build time.
+// Entries are evaluated eight at a time with AVX2 when the compiler targets it, otherwise as two groups of four with
+// SSE, and with plain scalar code everywhere else.
+class BrdfLut
+{
+	BrdfLut();
+	~BrdfLut();
+
+public:
+	// Fills scaleBias with size * size pairs. Rows are roughness and columns NdotV, the way PBR.shader samples the LUT.
+	static void Generate(int size, int sampleCount, JobSystem& jobs, std::vector<float>& scaleBias);
+
+	// Converts pairs to the R16G16_FLOAT texels the LUT texture is created with.
+	static void ToHalf(const std::vector<float>& scaleBias, std::vector<uint16_t>& texels);
+
+	// Writes a header holding the table as a constexpr array, so the runtime can skip generating it.
+	static bool WriteHeader(const char* fileName, int size, int sampleCount, const std::vector<float>& scaleBias);
+};
@@ -6,7 +6,15 @@ using namespace DirectX;
 
 struct ID3D11Device;
 struct ID3D11Buffer;
-struct ID3D11DeviceContext;
+class StateCache;
+
+// Uploads made by a constant buffer, and those skipped because nothing in it had changed.
+struct CBufferStats
+{
+	unsigned long long Uploads;
+	unsigned long long SkippedUploads;
+	unsigned long long UploadBytes;
+};
 
 class CBuffer
 {
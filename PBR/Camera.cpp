@@ -1,8 +1,8 @@
 #include "Camera.h"
 #include <cmath>
 #include "Input.h"
-#include <d3d11.h>
-#include "FrameCBuffer.h"
+#include "ViewCBuffer.h"
+#include "Profiler.h"
 
 using namespace DirectX;
 
@@ -14,6 +14,11 @@ Camera::Camera()
 	_fov = XMConvertToRadians(45.0f);
 	_camNear = 0.1f;
 	_camFar = 1000.0f;
+	_version = 1;
+	_viewDirty = true;
+	_viewMatrix = XMMatrixIdentity();
+	_rotationMatrix = XMMatrixIdentity();
+	_projectionMatrix = XMMatrixPerspectiveFovLH(_fov, _aspectRatio, _camNear, _camFar);
 	_worldMatrix = XMMatrixIdentity();
 }
 
@@ -31,21 +36,43 @@ void Camera::Initialise(const int width, const int height, const float camNear,
 
 void Camera::SetAspectRatio(const float aspectRatio)
 {
-	_aspectRatio = aspectRatio;
-	_projectionMatrix = XMMatrixPerspectiveFovLH(_fov, _aspectRatio, _camNear, _camFar);
+	if (aspectRatio != _aspectRatio)
+	{
+		_aspectRatio = aspectRatio;
+		UpdateProjectionMatrix();
+	}
 }
 
 void Camera::SetNearFar(const float camNear, const float camFar)
 {
-	_camNear = camNear;
-	_camFar = camFar;
-	_projectionMatrix = XMMatrixPerspectiveFovLH(_fov, _aspectRatio, _camNear, _camFar);
+	if (camNear != _camNear || camFar != _camFar)
+	{
+		_camNear = camNear;
+		_camFar = camFar;
+		UpdateProjectionMatrix();
+	}
 }
 
 void Camera::SetFOV(const float degrees)
 {
-	_fov = XMConvertToRadians(degrees);
+	const float fov = XMConvertToRadians(degrees);
+	if (fov != _fov)
+	{
+		_fov = fov;
+		UpdateProjectionMatrix();
+	}
+}
+
+void Camera::UpdateProjectionMatrix()
+{
 	_projectionMatrix = XMMatrixPerspectiveFovLH(_fov, _aspectRatio, _camNear, _camFar);
+	++_version;
+}
+
+void Camera::MarkViewDirty()
+{
+	_viewDirty = true;
+	++_version;
 }
 
 float Camera::GetFOV() const
@@ -60,16 +87,24 @@ float Camera::GetAspectRatio() const
 
 void Camera::SetPosition(const float x, const float y, const float z)
 {
-	_position.x = x;
-	_position.y = y;
-	_position.z = z;
+	if (x != _position.x || y != _position.y || z != _position.z)
+	{
+		_position.x = x;
+		_position.y = y;
+		_position.z = z;
+		MarkViewDirty();
+	}
 }
 
 void Camera::SetRotation(const float pitch, const float yaw, const float roll)
 {
-	_eulerAngles.x = pitch;
-	_eulerAngles.y = yaw;
-	_eulerAngles.z = roll;
+	if (pitch != _eulerAngles.x || yaw != _eulerAngles.y || roll != _eulerAngles.z)
+	{
+		_eulerAngles.x = pitch;
+		_eulerAngles.y = yaw;
+		_eulerAngles.z = roll;
+		MarkViewDirty();
+	}
 }
 
 XMFLOAT3 Camera::GetPosition() const
@@ -82,7 +117,19 @@ XMFLOAT3 Camera::GetRotation() const
 	return XMFLOAT3(_eulerAngles);
 }
 
-bool Camera::Render(ID3D11DeviceContext* deviceContext, FrameCBuffer* frameBuffer)
+bool Camera::Render(StateCache* stateCache, ViewCBuffer* viewBuffer)
+{
+	PROFILE_ZONE("Camera::Render");
+
+	if (_viewDirty)
+	{
+		UpdateViewMatrix();
+	}
+
+	return viewBuffer->Update(stateCache, _viewMatrix, _projectionMatrix, GetPosition(), _version);
+}
+
+void Camera::UpdateViewMatrix()
 {
 	// Setup the vector that points upwards.
 	XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
@@ -110,9 +157,7 @@ bool Camera::Render(ID3D11DeviceContext* deviceContext, FrameCBuffer* frameBuffe
 
 	// Finally create the view matrix from the three updated vectors.
 	_viewMatrix = XMMatrixLookAtLH(position, lookAt, up);
-
-	const HRESULT result = frameBuffer->Update(deviceContext, _viewMatrix, _projectionMatrix, GetPosition());
-	return !FAILED(result);
+	_viewDirty = false;
 }
 
 void Camera::GetViewMatrix(XMMATRIX& viewMatrix) const
@@ -130,6 +175,23 @@ void Camera::GetWorldMatrix(XMMATRIX& worldMatrix) const
 	worldMatrix = _worldMatrix;
 }
 
+float Camera::GetScreenSize(const XMFLOAT3 centre, const float radius) const
+{
+	const float dx = centre.x - _position.x;
+	const float dy = centre.y - _position.y;
+	const float dz = centre.z - _position.z;
+	const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+	if (distance <= radius)
+	{
+		return 1.0f;
+	}
+
+	// The projection's y scale is the cotangent of half the vertical FOV, so this is the projected radius over
+	// half the screen's height.
+	const float yScale = XMVectorGetY(_projectionMatrix.r[1]);
+	return radius * yScale / distance;
+}
+
 void Camera::UpdateInput(Input* input)
 {
 	int x, y;
@@ -139,8 +201,12 @@ void Camera::UpdateInput(Input* input)
 	const float xScaled = x * sensitivity;
 	const float yScaled = y * sensitivity;
 
-	_eulerAngles.x += yScaled;
-	_eulerAngles.y += xScaled;
+	if (x != 0 || y != 0)
+	{
+		_eulerAngles.x += yScaled;
+		_eulerAngles.y += xScaled;
+		MarkViewDirty();
+	}
 
 	float forwardScale = 0.0f;
 	float sideScale = 0.0f;
@@ -171,5 +237,11 @@ void Camera::UpdateInput(Input* input)
 		translation = XMVectorAdd(translation, position);
 
 		XMStoreFloat3(&_position, translation);
+		MarkViewDirty();
 	}
 }
+
+unsigned long long Camera::GetVersion() const
+{
+	return _version;
+}
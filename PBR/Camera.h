@@ -2,9 +2,9 @@
 
 #include <DirectXMath.h>
 
-struct ID3D11DeviceContext;
+class StateCache;
 class Input;
-class FrameCBuffer;
+class ViewCBuffer;
 
 class Camera
 {
@@ -26,19 +26,31 @@ public:
 	float GetFOV() const;
 	float GetAspectRatio() const;
 
-	bool Render(ID3D11DeviceContext* deviceContext, FrameCBuffer* frameBuffer);
+	// Rebuilds the view matrix if the position or rotation changed since the last call, then updates viewBuffer,
+	// which skips its upload if this camera hasn't changed since it was last given it.
+	bool Render(StateCache* stateCache, ViewCBuffer* viewBuffer);
 	void GetViewMatrix(DirectX::XMMATRIX& viewMatrix) const;
 	void GetProjectionMatrix(DirectX::XMMATRIX& projectionMatrix) const;
 	void GetWorldMatrix(DirectX::XMMATRIX& worldMatrix) const;
+	// The fraction of the screen's height a sphere covers, 1 or more when the camera is inside it.
+	float GetScreenSize(DirectX::XMFLOAT3 centre, float radius) const;
 	void UpdateInput(Input* input);
+	// Changes whenever the position or either matrix does.
+	unsigned long long GetVersion() const;
 
 private:
+	void UpdateViewMatrix();
+	void UpdateProjectionMatrix();
+	void MarkViewDirty();
+
 	DirectX::XMFLOAT3 _position;
 	DirectX::XMFLOAT3 _eulerAngles;
 	float _camNear;
 	float _camFar;
 	float _aspectRatio;
 	float _fov;
+	unsigned long long _version;
+	bool _viewDirty;
 
 	DirectX::XMMATRIX _viewMatrix;
 	DirectX::XMMATRIX _rotationMatrix;
@@ -0,0 +1,60 @@
+#include "ConstantAllocator.h"
+
+ConstantAllocator::ConstantAllocator()
+{
+	_pData = nullptr;
+	_capacity = 0;
+	_used = 0;
+	_allocationCount = 0;
+}
+
+void ConstantAllocator::Begin(void* data, const unsigned int capacity)
+{
+	_pData = static_cast<unsigned char*>(data);
+	_capacity = capacity;
+	_used = 0;
+	_allocationCount = 0;
+}
+
+void* ConstantAllocator::Allocate(const unsigned int size, ConstantRange& range)
+{
+	const unsigned int allocationSize = GetAllocationSize(size);
+	if (!_pData || allocationSize > _capacity - _used)
+	{
+		return nullptr;
+	}
+
+	range.FirstConstant = _used / ConstantSize;
+	range.ConstantCount = allocationSize / ConstantSize;
+
+	void* data = _pData + _used;
+	_used += allocationSize;
+	++_allocationCount;
+	return data;
+}
+
+void ConstantAllocator::End()
+{
+	_pData = nullptr;
+}
+
+unsigned int ConstantAllocator::GetAllocationSize(const unsigned int size)
+{
+	const unsigned int allocationSize = (size + Alignment - 1) & ~(Alignment - 1);
+	return allocationSize > 0 ? allocationSize : Alignment;
+}
+
+unsigned int ConstantAllocator::GetCapacity() const
+{
+	return _capacity;
+}
+
+unsigned int ConstantAllocator::GetUsed() const
+{
+	return _used;
+}
+
+unsigned int ConstantAllocator::GetAllocationCount() const
+{
+	return _allocationCount;
+}
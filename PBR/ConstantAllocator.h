@@ -0,0 +1,40 @@
+#pragma once
+
+// A range of a constant buffer, in the 16 byte constants that offset binding counts in.
+struct ConstantRange
+{
+	unsigned int FirstConstant;
+	unsigned int ConstantCount;
+};
+
+// Hands out constant buffer ranges from memory mapped once per frame, bumping through it until the frame ends.
+// It has no graphics API dependency; ConstantRingBuffer drives it with a mapped D3D11 buffer, and it can equally be
+// given plain memory to check its offsets without a GPU.
+class ConstantAllocator
+{
+public:
+	// Offset bindings must start on, and span, a multiple of 16 constants.
+	static const unsigned int Alignment = 256;
+	static const unsigned int ConstantSize = 16;
+
+	ConstantAllocator();
+
+	// Starts handing out memory from data, which holds capacity bytes and is aligned to Alignment.
+	void Begin(void* data, unsigned int capacity);
+	// Returns nullptr if the frame's memory is used up.
+	void* Allocate(unsigned int size, ConstantRange& range);
+	void End();
+
+	// Rounds size up to the space an allocation of it takes.
+	static unsigned int GetAllocationSize(unsigned int size);
+
+	unsigned int GetCapacity() const;
+	unsigned int GetUsed() const;
+	unsigned int GetAllocationCount() const;
+
+private:
+	unsigned char* _pData;
+	unsigned int _capacity;
+	unsigned int _used;
+	unsigned int _allocationCount;
+};
@@ -0,0 +1,118 @@
+#include "ConstantRingBuffer.h"
+#include "StateCache.h"
+#include <d3d11.h>
+
+ConstantRingBuffer::ConstantRingBuffer()
+{
+	_pBuffer = nullptr;
+	_capacity = 0;
+	_mapCount = 0;
+}
+
+ConstantRingBuffer::~ConstantRingBuffer()
+{
+	if (_pBuffer)
+	{
+		_pBuffer->Release();
+		_pBuffer = nullptr;
+	}
+}
+
+bool ConstantRingBuffer::Initialise(ID3D11Device* device, const unsigned int capacity)
+{
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	const HRESULT result = device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if (FAILED(result) || !options.ConstantBufferOffsetting)
+	{
+		return false;
+	}
+
+	return CreateBuffer(device, capacity);
+}
+
+bool ConstantRingBuffer::CreateBuffer(ID3D11Device* device, const unsigned int capacity)
+{
+	if (_pBuffer)
+	{
+		_pBuffer->Release();
+		_pBuffer = nullptr;
+	}
+
+	D3D11_BUFFER_DESC bufferDesc;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = ConstantAllocator::GetAllocationSize(capacity);
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	const HRESULT result = device->CreateBuffer(&bufferDesc, nullptr, &_pBuffer);
+	if (FAILED(result))
+	{
+		_capacity = 0;
+		return false;
+	}
+
+	_capacity = bufferDesc.ByteWidth;
+	return true;
+}
+
+bool ConstantRingBuffer::BeginFrame(ID3D11Device* device, StateCache* stateCache, const unsigned int requiredBytes)
+{
+	// Grow geometrically, as InstanceBuffer does, so a slowly growing scene doesn't recreate the buffer every frame.
+	if (requiredBytes > _capacity)
+	{
+		unsigned int capacity = _capacity > 0 ? _capacity : ConstantAllocator::Alignment;
+		while (capacity < requiredBytes)
+		{
+			capacity *= 2;
+		}
+
+		if (!CreateBuffer(device, capacity))
+		{
+			return false;
+		}
+	}
+
+	// Discarding hands back fresh memory, so draws from the previous frame can still read their constants.
+	void* data = stateCache->Map(_pBuffer, _capacity);
+	if (!data)
+	{
+		return false;
+	}
+
+	++_mapCount;
+	_allocator.Begin(data, _capacity);
+	return true;
+}
+
+void* ConstantRingBuffer::Allocate(const unsigned int size, ConstantRange& range)
+{
+	return _allocator.Allocate(size, range);
+}
+
+void ConstantRingBuffer::EndFrame(StateCache* stateCache)
+{
+	_allocator.End();
+	stateCache->Unmap(_pBuffer);
+}
+
+void ConstantRingBuffer::BindVertexShader(StateCache* stateCache, const int slot, const ConstantRange& range) const
+{
+	stateCache->SetConstantBuffer(ShaderStage::Vertex, slot, _pBuffer, range.FirstConstant, range.ConstantCount);
+}
+
+void ConstantRingBuffer::BindPixelShader(StateCache* stateCache, const int slot, const ConstantRange& range) const
+{
+	stateCache->SetConstantBuffer(ShaderStage::Pixel, slot, _pBuffer, range.FirstConstant, range.ConstantCount);
+}
+
+unsigned long long ConstantRingBuffer::GetMapCount() const
+{
+	return _mapCount;
+}
+
+unsigned int ConstantRingBuffer::GetFrameBytes() const
+{
+	return _allocator.GetUsed();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ConstantAllocator.h"
+
+struct ID3D11Device;
+struct ID3D11Buffer;
+class StateCache;
+
+// One large dynamic constant buffer that every draw's constants for a frame are written into with a single map,
+// instead of mapping a small buffer before each draw. Draws then bind their own range of it by offset, which needs
+// the D3D11.1 runtime.
+// The buffer must be unmapped with EndFrame before any draw that reads it.
+class ConstantRingBuffer
+{
+public:
+	ConstantRingBuffer();
+	~ConstantRingBuffer();
+
+	// Returns false if the device can't bind constant buffers by offset.
+	bool Initialise(ID3D11Device* device, unsigned int capacity);
+
+	// Maps the buffer for the frame, growing it first if it can't hold requiredBytes.
+	bool BeginFrame(ID3D11Device* device, StateCache* stateCache, unsigned int requiredBytes);
+	// Returns nullptr if the frame has used up the space given to BeginFrame.
+	void* Allocate(unsigned int size, ConstantRange& range);
+	void EndFrame(StateCache* stateCache);
+
+	void BindVertexShader(StateCache* stateCache, int slot, const ConstantRange& range) const;
+	void BindPixelShader(StateCache* stateCache, int slot, const ConstantRange& range) const;
+
+	// Maps made so far, which should be one per frame.
+	unsigned long long GetMapCount() const;
+	// Bytes allocated since the last BeginFrame.
+	unsigned int GetFrameBytes() const;
+
+private:
+	bool CreateBuffer(ID3D11Device* device, unsigned int capacity);
+
+	ID3D11Buffer* _pBuffer;
+	unsigned int _capacity;
+	unsigned long long _mapCount;
+	ConstantAllocator _allocator;
+};
@@ -0,0 +1,67 @@
+#include "CpuTexture.h"
+
+CpuTexture::CpuTexture()
+{
+	_width = 0;
+	_height = 0;
+	_mipLevels = 0;
+	_arraySize = 0;
+}
+
+CpuTexture::~CpuTexture()
+{
+}
+
+void CpuTexture::Initialise(const int width, const int height, const int mipLevels, const int arraySize)
+{
+	_width = width;
+	_height = height;
+	_mipLevels = mipLevels;
+	_arraySize = arraySize;
+
+	// Work out where every subresource starts so lookups don't have to walk the mip chain.
+	_offsets.resize(size_t(mipLevels) * arraySize);
+	size_t offset = 0;
+	for (int slice = 0; slice < arraySize; ++slice)
+	{
+		for (int mip = 0; mip < mipLevels; ++mip)
+		{
+			_offsets[size_t(slice) * mipLevels + mip] = offset;
+			offset += size_t(GetWidth(mip)) * GetHeight(mip) * ChannelCount;
+		}
+	}
+
+	_data.assign(offset, 0.0f);
+}
+
+int CpuTexture::GetWidth(const int mip) const
+{
+	const int width = _width >> mip;
+	return width > 0 ? width : 1;
+}
+
+int CpuTexture::GetHeight(const int mip) const
+{
+	const int height = _height >> mip;
+	return height > 0 ? height : 1;
+}
+
+int CpuTexture::GetMipLevels() const
+{
+	return _mipLevels;
+}
+
+int CpuTexture::GetArraySize() const
+{
+	return _arraySize;
+}
+
+float* CpuTexture::GetPixels(const int slice, const int mip)
+{
+	return _data.data() + _offsets[size_t(slice) * _mipLevels + mip];
+}
+
+const float* CpuTexture::GetPixels(const int slice, const int mip) const
+{
+	return _data.data() + _offsets[size_t(slice) * _mipLevels + mip];
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// A system memory texture of RGBA 32-bit float texels.
+// Subresources are laid out the same way as D3D11 and DDS files: every mip of slice 0, then every mip of slice 1 and so on.
+class CpuTexture
+{
+public:
+	static const int ChannelCount = 4;
+
+	CpuTexture();
+	~CpuTexture();
+
+	void Initialise(int width, int height, int mipLevels, int arraySize);
+
+	int GetWidth(int mip = 0) const;
+	int GetHeight(int mip = 0) const;
+	int GetMipLevels() const;
+	int GetArraySize() const;
+
+	float* GetPixels(int slice, int mip);
+	const float* GetPixels(int slice, int mip) const;
+
+private:
+	int _width;
+	int _height;
+	int _mipLevels;
+	int _arraySize;
+	std::vector<size_t> _offsets;
+	std::vector<float> _data;
+};
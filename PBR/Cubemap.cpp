@@ -1,8 +1,18 @@
 #include "Cubemap.h"
 #include "RenderTexture.h"
+#include "Texture.h"
+#include "CpuTexture.h"
+#include "HalfFloat.h"
+#include "DDSTextureLoader.h"
 #include <d3d11.h>
+#include <cstdint>
 
-Cubemap::Cubemap() = default;
+Cubemap::Cubemap()
+{
+	_pTexture = nullptr;
+	_pShaderResourceView = nullptr;
+	_mipMaps = 0;
+}
 
 Cubemap::~Cubemap()
 {
@@ -20,14 +30,12 @@ Cubemap::~Cubemap()
 }
 
 bool Cubemap::Initialise(ID3D11Device* device, ID3D11DeviceContext* context, std::vector<RenderTexture*> faces,
-                         const int width, const int height, const int mipMaps)
+                         const int width, const int height, const int mipMaps, const bool generateMips)
 {
-	_mipMaps = mipMaps;
-
 	D3D11_TEXTURE2D_DESC texDesc;
 	texDesc.Width = width;
 	texDesc.Height = height;
-	texDesc.MipLevels = mipMaps;
+	texDesc.MipLevels = generateMips ? 0 : mipMaps;
 	texDesc.ArraySize = 6;
 	texDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
 	texDesc.SampleDesc.Count = 1;
@@ -37,12 +45,22 @@ bool Cubemap::Initialise(ID3D11Device* device, ID3D11DeviceContext* context, std
 	texDesc.CPUAccessFlags = 0;
 	texDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
 
+	// A full mip chain generated from the faces needs the texture to be a render target as well.
+	if (generateMips)
+	{
+		texDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+		texDesc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
+	}
+
 	HRESULT result = device->CreateTexture2D(&texDesc, nullptr, &_pTexture);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
+	_pTexture->GetDesc(&texDesc);
+	_mipMaps = texDesc.MipLevels;
+
 	if (!faces.empty())
 	{
 		Copy(context, faces, width, height, 0);
@@ -54,6 +72,103 @@ bool Cubemap::Initialise(ID3D11Device* device, ID3D11DeviceContext* context, std
 	srvDesc.TextureCube.MipLevels = texDesc.MipLevels;
 	srvDesc.TextureCube.MostDetailedMip = 0;
 
+	result = device->CreateShaderResourceView(_pTexture, &srvDesc, &_pShaderResourceView);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	if (generateMips)
+	{
+		context->GenerateMips(_pShaderResourceView);
+	}
+
+	return true;
+}
+
+bool Cubemap::Initialise(ID3D11Device* device, const wchar_t* fileName)
+{
+	const std::wstring fullPath = Texture::GetFullPath(fileName);
+	if (fullPath.empty())
+	{
+		return false;
+	}
+
+	// Load the texture in.
+	ID3D11Resource* texture;
+	const HRESULT result = DirectX::CreateDDSTextureFromFile(device, fullPath.c_str(), &texture, &_pShaderResourceView);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	_pTexture = static_cast<ID3D11Texture2D*>(texture);
+
+	// Make sure the file actually held a cubemap.
+	D3D11_TEXTURE2D_DESC texDesc;
+	_pTexture->GetDesc(&texDesc);
+	_mipMaps = texDesc.MipLevels;
+
+	return (texDesc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) != 0;
+}
+
+bool Cubemap::Initialise(ID3D11Device* device, const CpuTexture& source)
+{
+	_mipMaps = source.GetMipLevels();
+
+	D3D11_TEXTURE2D_DESC texDesc;
+	texDesc.Width = source.GetWidth();
+	texDesc.Height = source.GetHeight();
+	texDesc.MipLevels = _mipMaps;
+	texDesc.ArraySize = 6;
+	texDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+	// Convert to the same half float format the GPU bake renders into.
+	std::vector<uint16_t> texels;
+	std::vector<size_t> offsets;
+	for (int face = 0; face < 6; ++face)
+	{
+		for (int mip = 0; mip < _mipMaps; ++mip)
+		{
+			const float* pixels = source.GetPixels(face, mip);
+			const size_t count = size_t(source.GetWidth(mip)) * source.GetHeight(mip) * CpuTexture::ChannelCount;
+
+			offsets.push_back(texels.size());
+			for (size_t i = 0; i < count; ++i)
+			{
+				texels.push_back(FloatToHalf(pixels[i]));
+			}
+		}
+	}
+
+	// Faces and mips were appended in subresource order.
+	std::vector<D3D11_SUBRESOURCE_DATA> initialData(offsets.size());
+	for (size_t i = 0; i < initialData.size(); ++i)
+	{
+		const int mip = int(i) % _mipMaps;
+		initialData[i].pSysMem = texels.data() + offsets[i];
+		initialData[i].SysMemPitch = UINT(source.GetWidth(mip) * CpuTexture::ChannelCount * sizeof(uint16_t));
+		initialData[i].SysMemSlicePitch = 0;
+	}
+
+	HRESULT result = device->CreateTexture2D(&texDesc, initialData.data(), &_pTexture);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	srvDesc.Format = texDesc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+	srvDesc.TextureCube.MipLevels = texDesc.MipLevels;
+	srvDesc.TextureCube.MostDetailedMip = 0;
+
 	result = device->CreateShaderResourceView(_pTexture, &srvDesc, &_pShaderResourceView);
 	return !FAILED(result);
 }
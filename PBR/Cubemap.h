@@ -3,6 +3,7 @@
 #include <vector>
 
 class RenderTexture;
+class CpuTexture;
 struct ID3D11Device;
 struct ID3D11DeviceContext;
 struct ID3D11Texture2D;
@@ -15,7 +16,9 @@ public:
 	~Cubemap();
 
 	bool Initialise(ID3D11Device* device, ID3D11DeviceContext* context, std::vector<RenderTexture*> faces, int width,
-	                int height, int mipMaps);
+	                int height, int mipMaps, bool generateMips);
+	bool Initialise(ID3D11Device* device, const wchar_t* fileName);
+	bool Initialise(ID3D11Device* device, const CpuTexture& source);
 	void Copy(ID3D11DeviceContext* context, std::vector<RenderTexture*> faces, int width, int height, int mipSlice) const;
 
 	ID3D11Texture2D* GetTexture() const;
@@ -1,4 +1,8 @@
 #include "D3D.h"
+#include "RenderTargetPool.h"
+#include "StateCache.h"
+#include "D3D11StateTarget.h"
+#include "Profiler.h"
 #include <d3d11.h>
 
 D3D::D3D() = default;
@@ -10,6 +14,24 @@ D3D::~D3D()
 		_pSwapChain->SetFullscreenState(false, nullptr);
 	}
 
+	if (_pRenderTargetPool)
+	{
+		delete _pRenderTargetPool;
+		_pRenderTargetPool = nullptr;
+	}
+
+	if (_pStateCache)
+	{
+		delete _pStateCache;
+		_pStateCache = nullptr;
+	}
+
+	if (_pStateTarget)
+	{
+		delete _pStateTarget;
+		_pStateTarget = nullptr;
+	}
+
 	if (_pRasterState)
 	{
 		_pRasterState->Release();
@@ -225,6 +247,14 @@ bool D3D::Initialise(const int screenWidth, const int screenHeight, const bool v
 		return false;
 	}
 
+	_pRenderTargetPool = new RenderTargetPool;
+	_pRenderTargetPool->Initialise(_pDevice);
+
+	_pStateTarget = new D3D11StateTarget;
+	_pStateTarget->Initialise(_pDeviceContext);
+	_pStateCache = new StateCache;
+	_pStateCache->Initialise(_pStateTarget);
+
 #ifdef _DEBUG
 	result = _pDevice->QueryInterface(__uuidof(ID3D11Debug), reinterpret_cast<void**>(&_pDebug));
 	if (FAILED(result))
@@ -399,6 +429,8 @@ bool D3D::ResizeDepthBuffer(const int width, const int height)
 
 void D3D::BeginScene(const float red, const float green, const float blue, const float alpha) const
 {
+	PROFILE_ZONE("D3D::BeginScene");
+
 	float color[4];
 
 	color[0] = red;
@@ -415,6 +447,16 @@ ID3D11DepthStencilView* D3D::GetDepthStencilView() const
 	return _pDepthStencilView;
 }
 
+RenderTargetPool* D3D::GetRenderTargetPool() const
+{
+	return _pRenderTargetPool;
+}
+
+StateCache* D3D::GetStateCache() const
+{
+	return _pStateCache;
+}
+
 void D3D::SetBackBufferRenderTarget()
 {
 	if (!ResizeDepthBuffer(_renderWidth, _renderHeight))
@@ -424,10 +466,16 @@ void D3D::SetBackBufferRenderTarget()
 
 	ResizeViewport(_renderWidth, _renderHeight);
 	_pDeviceContext->OMSetRenderTargets(1, &_pRenderTargetView, _pDepthStencilView);
+
+	// Binding a render target unbinds it from any shader resource slot it was in.
+	_pStateCache->Invalidate();
 }
 
 void D3D::EndScene() const
 {
+	// Mostly time spent waiting on the GPU or vsync in Present.
+	PROFILE_ZONE("D3D::EndScene");
+
 	if (_vsyncEnabled)
 	{
 		// Lock to screen refresh rate.
@@ -438,6 +486,9 @@ void D3D::EndScene() const
 		// Present as fast as possible.
 		_pSwapChain->Present(0, 0);
 	}
+
+	// Offscreen targets that went unused for long enough are freed.
+	_pRenderTargetPool->EndFrame();
 }
 
 ID3D11Device* D3D::GetDevice() const
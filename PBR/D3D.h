@@ -14,6 +14,9 @@ struct ID3D11RenderTargetView;
 struct ID3D11Texture2D;
 struct ID3D11DepthStencilState;
 struct ID3D11RasterizerState;
+class RenderTargetPool;
+class StateCache;
+class D3D11StateTarget;
 
 class D3D
 {
@@ -30,6 +33,9 @@ public:
 	ID3D11Device* GetDevice() const;
 	ID3D11DeviceContext* GetDeviceContext() const;
 	ID3D11DepthStencilView* GetDepthStencilView() const;
+	RenderTargetPool* GetRenderTargetPool() const;
+	// Binds state for the immediate context. Code that sets state on the context directly must invalidate it.
+	StateCache* GetStateCache() const;
 	void SetBackBufferRenderTarget();
 
 	void GetVideoCardInfo(char*, int&) const;
@@ -52,4 +58,7 @@ private:
 	ID3D11DepthStencilState* _pDepthStencilState;
 	ID3D11DepthStencilView* _pDepthStencilView;
 	ID3D11RasterizerState* _pRasterState;
+	RenderTargetPool* _pRenderTargetPool;
+	D3D11StateTarget* _pStateTarget;
+	StateCache* _pStateCache;
 };
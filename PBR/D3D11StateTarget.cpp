@@ -0,0 +1,290 @@
+#include "D3D11StateTarget.h"
+#include <d3d11_1.h>
+
+D3D11StateTarget::D3D11StateTarget()
+{
+	_pDeviceContext = nullptr;
+	_pDeviceContext1 = nullptr;
+}
+
+D3D11StateTarget::~D3D11StateTarget()
+{
+	if (_pDeviceContext1)
+	{
+		_pDeviceContext1->Release();
+		_pDeviceContext1 = nullptr;
+	}
+}
+
+void D3D11StateTarget::Initialise(ID3D11DeviceContext* deviceContext)
+{
+	_pDeviceContext = deviceContext;
+
+	if (_pDeviceContext1)
+	{
+		_pDeviceContext1->Release();
+		_pDeviceContext1 = nullptr;
+	}
+
+	// Only needed for offset constant buffers, so carry on without it on older runtimes.
+	if (FAILED(deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1),
+	                                         reinterpret_cast<void**>(&_pDeviceContext1))))
+	{
+		_pDeviceContext1 = nullptr;
+	}
+}
+
+void D3D11StateTarget::SetInputLayout(ID3D11InputLayout* layout)
+{
+	_pDeviceContext->IASetInputLayout(layout);
+}
+
+void D3D11StateTarget::SetVertexShader(ID3D11VertexShader* shader)
+{
+	_pDeviceContext->VSSetShader(shader, nullptr, 0);
+}
+
+void D3D11StateTarget::SetPixelShader(ID3D11PixelShader* shader)
+{
+	_pDeviceContext->PSSetShader(shader, nullptr, 0);
+}
+
+void D3D11StateTarget::SetVertexBuffer(const int slot, ID3D11Buffer* buffer, const unsigned int stride,
+                                       const unsigned int offset)
+{
+	_pDeviceContext->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+}
+
+void D3D11StateTarget::SetIndexBuffer(ID3D11Buffer* buffer, const int format)
+{
+	_pDeviceContext->IASetIndexBuffer(buffer, DXGI_FORMAT(format), 0);
+}
+
+void D3D11StateTarget::SetPrimitiveTopology(const int topology)
+{
+	_pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY(topology));
+}
+
+void D3D11StateTarget::SetConstantBuffers(const ShaderStage stage, const int startSlot, const int count,
+                                          ID3D11Buffer* const* buffers, const unsigned int* firstConstants,
+                                          const unsigned int* constantCounts)
+{
+	if (firstConstants)
+	{
+		if (!_pDeviceContext1)
+		{
+			return;
+		}
+
+		if (stage == ShaderStage::Vertex)
+		{
+			_pDeviceContext1->VSSetConstantBuffers1(startSlot, count, buffers, firstConstants, constantCounts);
+		}
+		else
+		{
+			_pDeviceContext1->PSSetConstantBuffers1(startSlot, count, buffers, firstConstants, constantCounts);
+		}
+	}
+	else if (stage == ShaderStage::Vertex)
+	{
+		_pDeviceContext->VSSetConstantBuffers(startSlot, count, buffers);
+	}
+	else
+	{
+		_pDeviceContext->PSSetConstantBuffers(startSlot, count, buffers);
+	}
+}
+
+void D3D11StateTarget::SetShaderResources(const ShaderStage stage, const int startSlot, const int count,
+                                          ID3D11ShaderResourceView* const* views)
+{
+	if (stage == ShaderStage::Vertex)
+	{
+		_pDeviceContext->VSSetShaderResources(startSlot, count, views);
+	}
+	else
+	{
+		_pDeviceContext->PSSetShaderResources(startSlot, count, views);
+	}
+}
+
+void D3D11StateTarget::SetSamplers(const ShaderStage stage, const int startSlot, const int count,
+                                   ID3D11SamplerState* const* samplers)
+{
+	if (stage == ShaderStage::Vertex)
+	{
+		_pDeviceContext->VSSetSamplers(startSlot, count, samplers);
+	}
+	else
+	{
+		_pDeviceContext->PSSetSamplers(startSlot, count, samplers);
+	}
+}
+
+void* D3D11StateTarget::Map(ID3D11Buffer* buffer, const unsigned int size)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	const HRESULT result = _pDeviceContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	if (FAILED(result))
+	{
+		return nullptr;
+	}
+
+	return mappedResource.pData;
+}
+
+void D3D11StateTarget::Unmap(ID3D11Buffer* buffer)
+{
+	_pDeviceContext->Unmap(buffer, 0);
+}
+
+void D3D11StateTarget::DrawIndexed(const int indexCount, const int startIndex)
+{
+	_pDeviceContext->DrawIndexed(indexCount, startIndex, 0);
+}
+
+void D3D11StateTarget::DrawIndexedInstanced(const int indexCount, const int instanceCount, const int startIndex,
+                                            const int startInstance)
+{
+	_pDeviceContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, 0, startInstance);
+}
+
+CommandList* D3D11StateTarget::CreateCommandList()
+{
+	D3D11CommandList* commandList = new D3D11CommandList;
+	if (!commandList->Initialise(_pDeviceContext))
+	{
+		delete commandList;
+		return nullptr;
+	}
+
+	return commandList;
+}
+
+void D3D11StateTarget::ExecuteCommandList(CommandList* commandList)
+{
+	ID3D11CommandList* recorded = static_cast<D3D11CommandList*>(commandList)->GetCommandList();
+	if (recorded)
+	{
+		// Restoring the context's state afterwards keeps the render targets and everything the cache thinks is bound.
+		_pDeviceContext->ExecuteCommandList(recorded, TRUE);
+	}
+}
+
+D3D11CommandList::D3D11CommandList()
+{
+	_pImmediateContext = nullptr;
+	_pDeferredContext = nullptr;
+	_pCommandList = nullptr;
+}
+
+D3D11CommandList::~D3D11CommandList()
+{
+	ReleaseCommandList();
+
+	if (_pDeferredContext)
+	{
+		_pDeferredContext->Release();
+		_pDeferredContext = nullptr;
+	}
+}
+
+bool D3D11CommandList::Initialise(ID3D11DeviceContext* immediateContext)
+{
+	_pImmediateContext = immediateContext;
+
+	ID3D11Device* device;
+	immediateContext->GetDevice(&device);
+	const HRESULT result = device->CreateDeferredContext(0, &_pDeferredContext);
+	device->Release();
+	if (FAILED(result))
+	{
+		_pDeferredContext = nullptr;
+		return false;
+	}
+
+	_target.Initialise(_pDeferredContext);
+	return true;
+}
+
+StateTarget* D3D11CommandList::GetTarget()
+{
+	return &_target;
+}
+
+bool D3D11CommandList::Begin()
+{
+	ReleaseCommandList();
+
+	// Deferred contexts start from default state, so carry over the output merger and rasteriser state the frame set
+	// up. The Get calls add references, which are dropped once the deferred context holds its own.
+	ID3D11RenderTargetView* renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+	ID3D11DepthStencilView* depthStencilView;
+	_pImmediateContext->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, &depthStencilView);
+	_pDeferredContext->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, depthStencilView);
+	for (int i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+	{
+		if (renderTargets[i])
+		{
+			renderTargets[i]->Release();
+		}
+	}
+
+	if (depthStencilView)
+	{
+		depthStencilView->Release();
+	}
+
+	ID3D11DepthStencilState* depthStencilState;
+	UINT stencilRef;
+	_pImmediateContext->OMGetDepthStencilState(&depthStencilState, &stencilRef);
+	_pDeferredContext->OMSetDepthStencilState(depthStencilState, stencilRef);
+	if (depthStencilState)
+	{
+		depthStencilState->Release();
+	}
+
+	ID3D11RasterizerState* rasterState;
+	_pImmediateContext->RSGetState(&rasterState);
+	_pDeferredContext->RSSetState(rasterState);
+	if (rasterState)
+	{
+		rasterState->Release();
+	}
+
+	D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+	UINT viewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+	_pImmediateContext->RSGetViewports(&viewportCount, viewports);
+	_pDeferredContext->RSSetViewports(viewportCount, viewports);
+
+	return true;
+}
+
+bool D3D11CommandList::End()
+{
+	ReleaseCommandList();
+
+	// FALSE leaves the deferred context at default state, ready for the next Begin.
+	const HRESULT result = _pDeferredContext->FinishCommandList(FALSE, &_pCommandList);
+	if (FAILED(result))
+	{
+		_pCommandList = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+ID3D11CommandList* D3D11CommandList::GetCommandList() const
+{
+	return _pCommandList;
+}
+
+void D3D11CommandList::ReleaseCommandList()
+{
+	if (_pCommandList)
+	{
+		_pCommandList->Release();
+		_pCommandList = nullptr;
+	}
+}
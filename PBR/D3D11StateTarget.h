@@ -0,0 +1,66 @@
+#pragma once
+
+#include "StateCache.h"
+
+struct ID3D11CommandList;
+struct ID3D11DeviceContext;
+struct ID3D11DeviceContext1;
+
+// Sends a StateCache's output to a D3D11 device context. Constant buffers bound by offset need the D3D11.1
+// runtime, and are dropped if the context doesn't support it.
+class D3D11StateTarget : public StateTarget
+{
+public:
+	D3D11StateTarget();
+	virtual ~D3D11StateTarget();
+
+	void Initialise(ID3D11DeviceContext* deviceContext);
+
+	void SetInputLayout(ID3D11InputLayout* layout) override;
+	void SetVertexShader(ID3D11VertexShader* shader) override;
+	void SetPixelShader(ID3D11PixelShader* shader) override;
+	void SetVertexBuffer(int slot, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) override;
+	void SetIndexBuffer(ID3D11Buffer* buffer, int format) override;
+	void SetPrimitiveTopology(int topology) override;
+	void SetConstantBuffers(ShaderStage stage, int startSlot, int count, ID3D11Buffer* const* buffers,
+	                        const unsigned int* firstConstants, const unsigned int* constantCounts) override;
+	void SetShaderResources(ShaderStage stage, int startSlot, int count,
+	                        ID3D11ShaderResourceView* const* views) override;
+	void SetSamplers(ShaderStage stage, int startSlot, int count, ID3D11SamplerState* const* samplers) override;
+	void* Map(ID3D11Buffer* buffer, unsigned int size) override;
+	void Unmap(ID3D11Buffer* buffer) override;
+	void DrawIndexed(int indexCount, int startIndex) override;
+	void DrawIndexedInstanced(int indexCount, int instanceCount, int startIndex, int startInstance) override;
+	// Lists record on a deferred context of the same device.
+	CommandList* CreateCommandList() override;
+	void ExecuteCommandList(CommandList* commandList) override;
+
+private:
+	ID3D11DeviceContext* _pDeviceContext;
+	ID3D11DeviceContext1* _pDeviceContext1;
+};
+
+// Records into a deferred context, finishing into an ID3D11CommandList that the immediate context plays back.
+class D3D11CommandList : public CommandList
+{
+public:
+	D3D11CommandList();
+	virtual ~D3D11CommandList();
+
+	bool Initialise(ID3D11DeviceContext* immediateContext);
+
+	StateTarget* GetTarget() override;
+	bool Begin() override;
+	bool End() override;
+
+	// The last finished recording, or nullptr if End hasn't succeeded since Begin.
+	ID3D11CommandList* GetCommandList() const;
+
+private:
+	void ReleaseCommandList();
+
+	ID3D11DeviceContext* _pImmediateContext;
+	ID3D11DeviceContext* _pDeferredContext;
+	ID3D11CommandList* _pCommandList;
+	D3D11StateTarget _target;
+};
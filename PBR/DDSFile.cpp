@@ -0,0 +1,530 @@
+#include "DDSFile.h"
+#include "CpuTexture.h"
+#include "HalfFloat.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const uint32_t DDSMagic = 0x20534444; // "DDS "
+
+	const uint32_t DDSFlagCaps = 0x1;
+	const uint32_t DDSFlagHeight = 0x2;
+	const uint32_t DDSFlagWidth = 0x4;
+	const uint32_t DDSFlagPixelFormat = 0x1000;
+	const uint32_t DDSFlagMipMapCount = 0x20000;
+
+	const uint32_t DDSPixelFourCC = 0x4;
+	const uint32_t DDSPixelRGB = 0x40;
+
+	const uint32_t DDSCapsComplex = 0x8;
+	const uint32_t DDSCapsTexture = 0x1000;
+	const uint32_t DDSCapsMipMap = 0x400000;
+	const uint32_t DDSCaps2Cubemap = 0x200;
+	const uint32_t DDSCaps2AllFaces = 0xFC00;
+
+	const uint32_t DDSResourceDimensionTexture2D = 3;
+	const uint32_t DDSResourceMiscTextureCube = 0x4;
+
+	// The D3D11 limits. Nothing larger could be uploaded, so headers claiming more are rejected before allocating.
+	const uint32_t MaxTextureSize = 16384;
+	const uint32_t MaxArraySize = 2048;
+
+	// Legacy D3DFORMAT values stored directly in the FourCC field.
+	const uint32_t D3DFormatR16F = 111;
+	const uint32_t D3DFormatG16R16F = 112;
+	const uint32_t D3DFormatA16B16G16R16F = 113;
+	const uint32_t D3DFormatR32F = 114;
+	const uint32_t D3DFormatG32R32F = 115;
+	const uint32_t D3DFormatA32B32G32R32F = 116;
+
+#pragma pack(push, 1)
+	struct PixelFormat
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t FourCC;
+		uint32_t RGBBitCount;
+		uint32_t RBitMask;
+		uint32_t GBitMask;
+		uint32_t BBitMask;
+		uint32_t ABitMask;
+	};
+
+	struct Header
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t Height;
+		uint32_t Width;
+		uint32_t PitchOrLinearSize;
+		uint32_t Depth;
+		uint32_t MipMapCount;
+		uint32_t Reserved1[11];
+		PixelFormat Format;
+		uint32_t Caps;
+		uint32_t Caps2;
+		uint32_t Caps3;
+		uint32_t Caps4;
+		uint32_t Reserved2;
+	};
+
+	struct HeaderDXT10
+	{
+		uint32_t Format;
+		uint32_t ResourceDimension;
+		uint32_t MiscFlag;
+		uint32_t ArraySize;
+		uint32_t MiscFlags2;
+	};
+#pragma pack(pop)
+
+	uint32_t MakeFourCC(const char a, const char b, const char c, const char d)
+	{
+		return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+	}
+
+	int GetChannelCount(const DDSFormat format)
+	{
+		switch (format)
+		{
+		case DDSFormat::R32G32B32A32Float:
+		case DDSFormat::R16G16B16A16Float:
+		case DDSFormat::R8G8B8A8Unorm:
+		case DDSFormat::B8G8R8A8Unorm:
+			return 4;
+		case DDSFormat::R32G32B32Float:
+			return 3;
+		case DDSFormat::R32G32Float:
+		case DDSFormat::R16G16Float:
+			return 2;
+		case DDSFormat::R32Float:
+		case DDSFormat::R16Float:
+			return 1;
+		default:
+			return 0;
+		}
+	}
+
+	int GetChannelSize(const DDSFormat format)
+	{
+		switch (format)
+		{
+		case DDSFormat::R32G32B32A32Float:
+		case DDSFormat::R32G32B32Float:
+		case DDSFormat::R32G32Float:
+		case DDSFormat::R32Float:
+			return 4;
+		case DDSFormat::R16G16B16A16Float:
+		case DDSFormat::R16G16Float:
+		case DDSFormat::R16Float:
+			return 2;
+		case DDSFormat::R8G8B8A8Unorm:
+		case DDSFormat::B8G8R8A8Unorm:
+			return 1;
+		default:
+			return 0;
+		}
+	}
+
+	DDSFormat GetLegacyFormat(const PixelFormat& pixelFormat)
+	{
+		if (pixelFormat.Flags & DDSPixelFourCC)
+		{
+			switch (pixelFormat.FourCC)
+			{
+			case D3DFormatR16F: return DDSFormat::R16Float;
+			case D3DFormatG16R16F: return DDSFormat::R16G16Float;
+			case D3DFormatA16B16G16R16F: return DDSFormat::R16G16B16A16Float;
+			case D3DFormatR32F: return DDSFormat::R32Float;
+			case D3DFormatG32R32F: return DDSFormat::R32G32Float;
+			case D3DFormatA32B32G32R32F: return DDSFormat::R32G32B32A32Float;
+			default: return DDSFormat::Unknown;
+			}
+		}
+
+		if ((pixelFormat.Flags & DDSPixelRGB) && pixelFormat.RGBBitCount == 32)
+		{
+			if (pixelFormat.RBitMask == 0x000000FF && pixelFormat.GBitMask == 0x0000FF00 && pixelFormat.BBitMask == 0x00FF0000)
+			{
+				return DDSFormat::R8G8B8A8Unorm;
+			}
+
+			if (pixelFormat.RBitMask == 0x00FF0000 && pixelFormat.GBitMask == 0x0000FF00 && pixelFormat.BBitMask == 0x000000FF)
+			{
+				return DDSFormat::B8G8R8A8Unorm;
+			}
+		}
+
+		return DDSFormat::Unknown;
+	}
+
+	float ReadChannel(const uint8_t* source, const DDSFormat format, const int channel)
+	{
+		const int channelSize = GetChannelSize(format);
+
+		if (channelSize == 4)
+		{
+			float value;
+			std::memcpy(&value, source + channel * 4, sizeof value);
+			return value;
+		}
+
+		if (channelSize == 2)
+		{
+			uint16_t value;
+			std::memcpy(&value, source + channel * 2, sizeof value);
+			return HalfToFloat(value);
+		}
+
+		// Swizzle BGRA back to RGBA.
+		int byteIndex = channel;
+		if (format == DDSFormat::B8G8R8A8Unorm && channel < 3)
+		{
+			byteIndex = 2 - channel;
+		}
+
+		return source[byteIndex] / 255.0f;
+	}
+
+	void WriteChannel(uint8_t* destination, const DDSFormat format, const int channel, const float value)
+	{
+		const int channelSize = GetChannelSize(format);
+
+		if (channelSize == 4)
+		{
+			std::memcpy(destination + channel * 4, &value, sizeof value);
+		}
+		else if (channelSize == 2)
+		{
+			const uint16_t half = FloatToHalf(value);
+			std::memcpy(destination + channel * 2, &half, sizeof half);
+		}
+		else
+		{
+			int byteIndex = channel;
+			if (format == DDSFormat::B8G8R8A8Unorm && channel < 3)
+			{
+				byteIndex = 2 - channel;
+			}
+
+			const float clamped = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+			destination[byteIndex] = uint8_t(clamped * 255.0f + 0.5f);
+		}
+	}
+}
+
+DDSFile::DDSFile()
+{
+}
+
+DDSFile::~DDSFile()
+{
+}
+
+bool DDSFile::Load(const char* fileName, CpuTexture& texture)
+{
+	PROFILE_ZONE("DDSFile::Load");
+
+	MappedFile file;
+	return file.Open(fileName) && Parse(file.GetData(), file.GetSize(), texture);
+}
+
+#ifdef _WIN32
+bool DDSFile::Load(const wchar_t* fileName, CpuTexture& texture)
+{
+	PROFILE_ZONE("DDSFile::Load");
+
+	MappedFile file;
+	return file.Open(fileName) && Parse(file.GetData(), file.GetSize(), texture);
+}
+#endif
+
+bool DDSFile::Save(const char* fileName, const CpuTexture& texture, const DDSFormat format, const bool cubemap)
+{
+	std::vector<uint8_t> data;
+	Serialise(data, texture, format, cubemap);
+	if (data.empty())
+	{
+		return false;
+	}
+
+	FILE* file = std::fopen(fileName, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	const size_t bytesWritten = std::fwrite(data.data(), 1, data.size(), file);
+	std::fclose(file);
+
+	return bytesWritten == data.size();
+}
+
+bool DDSFile::Save(const char* fileName, const void* texels, const int width, const int height, const int mipLevels,
+                   const int arraySize, const DDSFormat format, const bool cubemap)
+{
+	const size_t texelSize = size_t(GetTexelSize(format));
+	if (texelSize == 0 || (cubemap && arraySize % 6 != 0))
+	{
+		return false;
+	}
+
+	size_t dataSize = 0;
+	for (int mip = 0; mip < mipLevels; ++mip)
+	{
+		dataSize += size_t(std::max(width >> mip, 1)) * std::max(height >> mip, 1) * texelSize;
+	}
+	dataSize *= arraySize;
+
+	std::vector<uint8_t> header;
+	SerialiseHeader(header, width, height, mipLevels, arraySize, format, cubemap);
+
+	FILE* file = std::fopen(fileName, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	// Written straight from the caller's buffer rather than copied after the header.
+	bool result = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+	result = result && std::fwrite(texels, 1, dataSize, file) == dataSize;
+	std::fclose(file);
+
+	return result;
+}
+
+bool DDSFile::Parse(const uint8_t* data, const size_t size, CpuTexture& texture)
+{
+	// Need at least the magic number and the header.
+	if (size < sizeof(uint32_t) + sizeof(Header))
+	{
+		return false;
+	}
+
+	uint32_t magic;
+	std::memcpy(&magic, data, sizeof magic);
+	if (magic != DDSMagic)
+	{
+		return false;
+	}
+
+	Header header;
+	std::memcpy(&header, data + sizeof(uint32_t), sizeof header);
+	if (header.Size != sizeof(Header) || header.Format.Size != sizeof(PixelFormat))
+	{
+		return false;
+	}
+
+	size_t offset = sizeof(uint32_t) + sizeof(Header);
+	DDSFormat format;
+	int arraySize = 1;
+
+	if ((header.Format.Flags & DDSPixelFourCC) && header.Format.FourCC == MakeFourCC('D', 'X', '1', '0'))
+	{
+		if (size < offset + sizeof(HeaderDXT10))
+		{
+			return false;
+		}
+
+		HeaderDXT10 extension;
+		std::memcpy(&extension, data + offset, sizeof extension);
+		offset += sizeof(HeaderDXT10);
+
+		// Only 2D textures and cubemaps are used by the renderer.
+		if (extension.ResourceDimension != DDSResourceDimensionTexture2D)
+		{
+			return false;
+		}
+
+		if (extension.ArraySize > MaxArraySize)
+		{
+			return false;
+		}
+
+		format = DDSFormat(extension.Format);
+		arraySize = extension.ArraySize > 0 ? int(extension.ArraySize) : 1;
+		if (extension.MiscFlag & DDSResourceMiscTextureCube)
+		{
+			arraySize *= 6;
+		}
+	}
+	else
+	{
+		format = GetLegacyFormat(header.Format);
+
+		// Partial cubemaps aren't supported.
+		if (header.Caps2 & DDSCaps2Cubemap)
+		{
+			if ((header.Caps2 & DDSCaps2AllFaces) != DDSCaps2AllFaces)
+			{
+				return false;
+			}
+
+			arraySize = 6;
+		}
+	}
+
+	const int channelCount = GetChannelCount(format);
+	if (channelCount == 0)
+	{
+		return false;
+	}
+
+	// Check everything the header claims against the limits and the file's size before allocating for it.
+	if (header.Width == 0 || header.Height == 0 || header.Width > MaxTextureSize || header.Height > MaxTextureSize ||
+	    arraySize > int(MaxArraySize))
+	{
+		return false;
+	}
+
+	// A longer mip chain than the full one is rejected rather than trimmed, as the extra mips would still be in the
+	// data between slices.
+	uint32_t fullMipLevels = 1;
+	for (uint32_t extent = std::max(header.Width, header.Height); extent > 1; extent >>= 1)
+	{
+		++fullMipLevels;
+	}
+
+	if (header.MipMapCount > fullMipLevels)
+	{
+		return false;
+	}
+
+	const int mipLevels = header.MipMapCount > 0 ? int(header.MipMapCount) : 1;
+	const size_t texelSize = size_t(channelCount) * GetChannelSize(format);
+
+	uint64_t sliceTexels = 0;
+	for (int mip = 0; mip < mipLevels; ++mip)
+	{
+		sliceTexels += uint64_t(std::max(header.Width >> mip, 1u)) * std::max(header.Height >> mip, 1u);
+	}
+
+	if (sliceTexels * uint64_t(arraySize) * texelSize > uint64_t(size - offset))
+	{
+		return false;
+	}
+
+	texture.Initialise(int(header.Width), int(header.Height), mipLevels, arraySize);
+
+	for (int slice = 0; slice < arraySize; ++slice)
+	{
+		for (int mip = 0; mip < mipLevels; ++mip)
+		{
+			const size_t texelCount = size_t(texture.GetWidth(mip)) * texture.GetHeight(mip);
+			float* pixels = texture.GetPixels(slice, mip);
+			for (size_t i = 0; i < texelCount; ++i)
+			{
+				const uint8_t* source = data + offset + i * texelSize;
+				float* texel = pixels + i * CpuTexture::ChannelCount;
+
+				texel[0] = ReadChannel(source, format, 0);
+				texel[1] = channelCount > 1 ? ReadChannel(source, format, 1) : 0.0f;
+				texel[2] = channelCount > 2 ? ReadChannel(source, format, 2) : 0.0f;
+				texel[3] = channelCount > 3 ? ReadChannel(source, format, 3) : 1.0f;
+			}
+
+			offset += texelCount * texelSize;
+		}
+	}
+
+	return true;
+}
+
+void DDSFile::Serialise(std::vector<uint8_t>& output, const CpuTexture& texture, const DDSFormat format,
+                        const bool cubemap)
+{
+	output.clear();
+
+	const int channelCount = GetChannelCount(format);
+	if (channelCount == 0 || (cubemap && texture.GetArraySize() % 6 != 0))
+	{
+		return;
+	}
+
+	const int mipLevels = texture.GetMipLevels();
+	const int arraySize = texture.GetArraySize();
+	const size_t texelSize = size_t(GetTexelSize(format));
+
+	size_t dataSize = 0;
+	for (int mip = 0; mip < mipLevels; ++mip)
+	{
+		dataSize += size_t(texture.GetWidth(mip)) * texture.GetHeight(mip) * texelSize;
+	}
+	dataSize *= arraySize;
+
+	SerialiseHeader(output, texture.GetWidth(), texture.GetHeight(), mipLevels, arraySize, format, cubemap);
+
+	const size_t headerSize = output.size();
+	output.resize(headerSize + dataSize);
+	uint8_t* destination = output.data() + headerSize;
+
+	for (int slice = 0; slice < arraySize; ++slice)
+	{
+		for (int mip = 0; mip < mipLevels; ++mip)
+		{
+			const size_t texelCount = size_t(texture.GetWidth(mip)) * texture.GetHeight(mip);
+			const float* pixels = texture.GetPixels(slice, mip);
+
+			for (size_t i = 0; i < texelCount; ++i)
+			{
+				const float* texel = pixels + i * CpuTexture::ChannelCount;
+				for (int channel = 0; channel < channelCount; ++channel)
+				{
+					WriteChannel(destination, format, channel, texel[channel]);
+				}
+
+				destination += texelSize;
+			}
+		}
+	}
+}
+
+void DDSFile::SerialiseHeader(std::vector<uint8_t>& output, const int width, const int height, const int mipLevels,
+                              const int arraySize, const DDSFormat format, const bool cubemap)
+{
+	Header header;
+	std::memset(&header, 0, sizeof header);
+	header.Size = sizeof(Header);
+	header.Flags = DDSFlagCaps | DDSFlagHeight | DDSFlagWidth | DDSFlagPixelFormat | DDSFlagMipMapCount;
+	header.Height = uint32_t(height);
+	header.Width = uint32_t(width);
+	header.MipMapCount = uint32_t(mipLevels);
+	header.Format.Size = sizeof(PixelFormat);
+	header.Format.Flags = DDSPixelFourCC;
+	header.Format.FourCC = MakeFourCC('D', 'X', '1', '0');
+	header.Caps = DDSCapsTexture;
+	if (mipLevels > 1)
+	{
+		header.Caps |= DDSCapsComplex | DDSCapsMipMap;
+	}
+	if (cubemap)
+	{
+		header.Caps |= DDSCapsComplex;
+		header.Caps2 = DDSCaps2Cubemap | DDSCaps2AllFaces;
+	}
+
+	HeaderDXT10 extension;
+	std::memset(&extension, 0, sizeof extension);
+	extension.Format = uint32_t(format);
+	extension.ResourceDimension = DDSResourceDimensionTexture2D;
+	extension.MiscFlag = cubemap ? DDSResourceMiscTextureCube : 0;
+	extension.ArraySize = uint32_t(cubemap ? arraySize / 6 : arraySize);
+
+	output.resize(sizeof(uint32_t) + sizeof(Header) + sizeof(HeaderDXT10));
+
+	uint8_t* destination = output.data();
+	std::memcpy(destination, &DDSMagic, sizeof(uint32_t));
+	destination += sizeof(uint32_t);
+	std::memcpy(destination, &header, sizeof header);
+	destination += sizeof header;
+	std::memcpy(destination, &extension, sizeof extension);
+}
+
+int DDSFile::GetTexelSize(const DDSFormat format)
+{
+	return GetChannelCount(format) * GetChannelSize(format);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+class CpuTexture;
+
+// The subset of DXGI formats the CPU side of the pipeline reads and writes. Values match DXGI_FORMAT.
+enum class DDSFormat
+{
+	Unknown = 0,
+	R32G32B32A32Float = 2,
+	R32G32B32Float = 6,
+	R16G16B16A16Float = 10,
+	R32G32Float = 16,
+	R8G8B8A8Unorm = 28,
+	R16G16Float = 34,
+	R32Float = 41,
+	R16Float = 54,
+	B8G8R8A8Unorm = 87
+};
+
+// Portable DDS reader and writer for uncompressed float and 8-bit textures.
+// Unlike DDSTextureLoader this has no D3D dependency, so it can run on build machines without a GPU.
+class DDSFile
+{
+	DDSFile();
+	~DDSFile();
+
+public:
+	static bool Load(const char* fileName, CpuTexture& texture);
+#ifdef _WIN32
+	static bool Load(const wchar_t* fileName, CpuTexture& texture);
+#endif
+	static bool Save(const char* fileName, const CpuTexture& texture, DDSFormat format, bool cubemap);
+	// Writes texel data that is already in the given format, laid out the same way as CpuTexture subresources.
+	static bool Save(const char* fileName, const void* texels, int width, int height, int mipLevels, int arraySize,
+	                 DDSFormat format, bool cubemap);
+
+	// Load maps the file and parses it in place, so the only copy made is the conversion into the texture.
+	static bool Parse(const uint8_t* data, size_t size, CpuTexture& texture);
+	static void Serialise(std::vector<uint8_t>& output, const CpuTexture& texture, DDSFormat format, bool cubemap);
+
+	// Writes just the magic number and headers, for callers that stream the texel data themselves.
+	static void SerialiseHeader(std::vector<uint8_t>& output, int width, int height, int mipLevels, int arraySize,
+	                            DDSFormat format, bool cubemap);
+	static int GetTexelSize(DDSFormat format);
+};
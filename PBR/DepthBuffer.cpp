@@ -0,0 +1,62 @@
+#include "DepthBuffer.h"
+#include <d3d11.h>
+
+DepthBuffer::DepthBuffer()
+{
+	_pTexture = nullptr;
+	_pDepthStencilView = nullptr;
+}
+
+DepthBuffer::~DepthBuffer()
+{
+	if (_pDepthStencilView)
+	{
+		_pDepthStencilView->Release();
+		_pDepthStencilView = nullptr;
+	}
+
+	if (_pTexture)
+	{
+		_pTexture->Release();
+		_pTexture = nullptr;
+	}
+}
+
+bool DepthBuffer::Initialise(ID3D11Device* device, const int width, const int height)
+{
+	D3D11_TEXTURE2D_DESC depthBufferDesc;
+	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
+
+	// Matches the back buffer's depth buffer created by D3D::ResizeDepthBuffer.
+	ZeroMemory(&depthBufferDesc, sizeof depthBufferDesc);
+	depthBufferDesc.Width = width;
+	depthBufferDesc.Height = height;
+	depthBufferDesc.MipLevels = 1;
+	depthBufferDesc.ArraySize = 1;
+	depthBufferDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthBufferDesc.SampleDesc.Count = 1;
+	depthBufferDesc.SampleDesc.Quality = 0;
+	depthBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	depthBufferDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	depthBufferDesc.CPUAccessFlags = 0;
+	depthBufferDesc.MiscFlags = 0;
+
+	HRESULT result = device->CreateTexture2D(&depthBufferDesc, nullptr, &_pTexture);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	ZeroMemory(&depthStencilViewDesc, sizeof depthStencilViewDesc);
+	depthStencilViewDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	depthStencilViewDesc.Texture2D.MipSlice = 0;
+
+	result = device->CreateDepthStencilView(_pTexture, &depthStencilViewDesc, &_pDepthStencilView);
+	return !FAILED(result);
+}
+
+ID3D11DepthStencilView* DepthBuffer::GetDSV() const
+{
+	return _pDepthStencilView;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+struct ID3D11Device;
+struct ID3D11Texture2D;
+struct ID3D11DepthStencilView;
+
+// A standalone D24S8 depth-stencil buffer, for render passes that shouldn't resize the back buffer's depth.
+class DepthBuffer
+{
+public:
+	DepthBuffer();
+	~DepthBuffer();
+
+	bool Initialise(ID3D11Device* device, int width, int height);
+
+	ID3D11DepthStencilView* GetDSV() const;
+
+private:
+	ID3D11Texture2D* _pTexture;
+	ID3D11DepthStencilView* _pDepthStencilView;
+};
@@ -0,0 +1,242 @@
+#include "DrawBenchmark.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace
+{
+	// Placeholder resource indices. Each mesh's vertex and index buffers follow the shared resources.
+	enum ResourceIndex
+	{
+		ObjectBufferResource,
+		ViewBufferResource,
+		LightBufferResource,
+		SHBufferResource,
+		FirstTextureResource,
+		SamplerResource = FirstTextureResource + 6,
+		InputLayoutResource,
+		VertexShaderResource,
+		PixelShaderResource,
+		FirstMeshResource
+	};
+
+	// D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST and DXGI_FORMAT_R16_UINT.
+	const int TriangleList = 4;
+	const int ShortIndexFormat = 57;
+	const unsigned int VertexStride = 20;
+}
+
+DrawBenchmark::DrawBenchmark()
+{
+	_pJobs = nullptr;
+	_meshCount = 0;
+	_statsBase.Requested = 0;
+	_statsBase.Forwarded = 0;
+	_statsBase.Elided = 0;
+}
+
+DrawBenchmark::~DrawBenchmark()
+{
+	for (auto it = _recorders.begin(); it != _recorders.end(); ++it)
+	{
+		delete it->List;
+		delete it->Cache;
+	}
+
+	_recorders.clear();
+}
+
+void DrawBenchmark::Initialise(const int drawCount, const int meshCount, JobSystem* jobs)
+{
+	_pJobs = jobs;
+	_meshCount = meshCount > 0 ? meshCount : 1;
+	_stateCache.Initialise(&_target);
+
+	// Models are drawn in scene order, so with several meshes most draws change the vertex and index buffers.
+	_meshes.resize(drawCount);
+	for (int i = 0; i < drawCount; ++i)
+	{
+		_meshes[i] = i % _meshCount;
+	}
+
+	_objectConstants.resize(drawCount);
+	_resources.resize(FirstMeshResource + _meshCount * 2);
+
+	// One list per core, as Graphics creates.
+	const int recorderCount = _pJobs->GetThreadCount();
+	for (int i = 0; i < recorderCount; ++i)
+	{
+		Recorder recorder;
+		recorder.List = _target.CreateCommandList();
+		recorder.Cache = new StateCache;
+		recorder.Cache->Initialise(recorder.List->GetTarget());
+		recorder.First = 0;
+		recorder.Last = 0;
+		recorder.Result = false;
+		_recorders.push_back(recorder);
+	}
+}
+
+bool DrawBenchmark::RecordFrame(int listCount)
+{
+	PROFILE_ZONE("DrawBenchmark::RecordFrame");
+
+	if (!WriteConstants())
+	{
+		return false;
+	}
+
+	const int drawCount = int(_meshes.size());
+	listCount = listCount < int(_recorders.size()) ? listCount : int(_recorders.size());
+	if (listCount <= 1)
+	{
+		BindSceneResources(&_stateCache);
+		RecordDraws(&_stateCache, 0, drawCount);
+		return true;
+	}
+
+	const int drawsPerList = (drawCount + listCount - 1) / listCount;
+	for (int i = 0; i < listCount; ++i)
+	{
+		Recorder& recorder = _recorders[i];
+		recorder.First = i * drawsPerList < drawCount ? i * drawsPerList : drawCount;
+		recorder.Last = recorder.First + drawsPerList < drawCount ? recorder.First + drawsPerList : drawCount;
+		recorder.Result = recorder.List->Begin();
+		recorder.Cache->Invalidate();
+	}
+
+	_pJobs->ParallelFor(listCount, 1, [this](const int first, const int last)
+	{
+		for (int i = first; i < last; ++i)
+		{
+			Recorder& recorder = _recorders[i];
+			if (!recorder.Result)
+			{
+				continue;
+			}
+
+			BindSceneResources(recorder.Cache);
+			RecordDraws(recorder.Cache, recorder.First, recorder.Last);
+			recorder.Result = recorder.List->End();
+		}
+	});
+
+	for (int i = 0; i < listCount; ++i)
+	{
+		if (!_recorders[i].Result)
+		{
+			return false;
+		}
+
+		_stateCache.ExecuteCommandList(_recorders[i].List);
+	}
+
+	return true;
+}
+
+void DrawBenchmark::ResetStats()
+{
+	_target.Reset();
+
+	_statsBase.Requested = 0;
+	_statsBase.Forwarded = 0;
+	_statsBase.Elided = 0;
+	_statsBase = GetStats();
+}
+
+const NullStateTarget& DrawBenchmark::GetTarget() const
+{
+	return _target;
+}
+
+StateCacheStats DrawBenchmark::GetStats() const
+{
+	StateCacheStats stats = _stateCache.GetStats();
+	for (auto it = _recorders.begin(); it != _recorders.end(); ++it)
+	{
+		const StateCacheStats listStats = it->Cache->GetStats();
+		stats.Requested += listStats.Requested;
+		stats.Forwarded += listStats.Forwarded;
+		stats.Elided += listStats.Elided;
+	}
+
+	stats.Requested -= _statsBase.Requested;
+	stats.Forwarded -= _statsBase.Forwarded;
+	stats.Elided -= _statsBase.Elided;
+	return stats;
+}
+
+bool DrawBenchmark::WriteConstants()
+{
+	// The same single map per frame that ConstantRingBuffer makes, sized for every draw.
+	ID3D11Buffer* objectBuffer = GetResource<ID3D11Buffer>(ObjectBufferResource);
+	const unsigned int capacity = ConstantAllocator::GetAllocationSize(ObjectConstantsSize) *
+	                              unsigned(_objectConstants.size());
+
+	void* data = _stateCache.Map(objectBuffer, capacity);
+	if (!data)
+	{
+		return false;
+	}
+
+	_allocator.Begin(data, capacity);
+	for (size_t i = 0; i < _objectConstants.size(); ++i)
+	{
+		float* constants = static_cast<float*>(_allocator.Allocate(ObjectConstantsSize, _objectConstants[i]));
+		if (!constants)
+		{
+			_allocator.End();
+			_stateCache.Unmap(objectBuffer);
+			return false;
+		}
+
+		for (unsigned int j = 0; j < ObjectConstantsSize / sizeof(float); ++j)
+		{
+			constants[j] = float(i);
+		}
+	}
+
+	_allocator.End();
+	_stateCache.Unmap(objectBuffer);
+	return true;
+}
+
+void DrawBenchmark::BindSceneResources(StateCache* stateCache) const
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		stateCache->SetShaderResource(ShaderStage::Pixel, i,
+		                              GetResource<ID3D11ShaderResourceView>(FirstTextureResource + i));
+	}
+
+	stateCache->SetConstantBuffer(ShaderStage::Pixel, 2, GetResource<ID3D11Buffer>(SHBufferResource));
+}
+
+void DrawBenchmark::RecordDraws(StateCache* stateCache, const int first, const int last) const
+{
+	PROFILE_ZONE("DrawBenchmark::RecordDraws");
+
+	ID3D11Buffer* objectBuffer = GetResource<ID3D11Buffer>(ObjectBufferResource);
+	ID3D11Buffer* viewBuffer = GetResource<ID3D11Buffer>(ViewBufferResource);
+	ID3D11Buffer* lightBuffer = GetResource<ID3D11Buffer>(LightBufferResource);
+
+	for (int i = first; i < last; ++i)
+	{
+		// Mesh::Bind.
+		const int mesh = FirstMeshResource + _meshes[i] * 2;
+		stateCache->SetVertexBuffer(0, GetResource<ID3D11Buffer>(mesh), VertexStride, 0);
+		stateCache->SetIndexBuffer(GetResource<ID3D11Buffer>(mesh + 1), ShortIndexFormat);
+		stateCache->SetPrimitiveTopology(TriangleList);
+
+		// PBRShader::Render.
+		const ConstantRange& range = _objectConstants[i];
+		stateCache->SetConstantBuffer(ShaderStage::Vertex, 0, viewBuffer);
+		stateCache->SetConstantBuffer(ShaderStage::Vertex, 1, objectBuffer, range.FirstConstant, range.ConstantCount);
+		stateCache->SetConstantBuffer(ShaderStage::Pixel, 0, viewBuffer);
+		stateCache->SetConstantBuffer(ShaderStage::Pixel, 3, lightBuffer);
+		stateCache->SetSampler(ShaderStage::Pixel, 0, GetResource<ID3D11SamplerState>(SamplerResource));
+		stateCache->SetInputLayout(GetResource<ID3D11InputLayout>(InputLayoutResource));
+		stateCache->SetVertexShader(GetResource<ID3D11VertexShader>(VertexShaderResource));
+		stateCache->SetPixelShader(GetResource<ID3D11PixelShader>(PixelShaderResource));
+		stateCache->DrawIndexed(IndexCount, 0);
+	}
+}
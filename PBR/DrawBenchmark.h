@@ -0,0 +1,68 @@
+#pragma once
+
+#include "StateCache.h"
+#include "NullStateTarget.h"
+#include "ConstantAllocator.h"
+#include <vector>
+
+class JobSystem;
+
+// Records the non-instanced path's frame against a NullStateTarget, so the CPU cost of the state cache, per draw
+// constant allocation and parallel command list recording can be measured without a GPU.
+// Each frame follows Graphics::RenderModels: every draw's constants are written with one map, then the draws are
+// recorded straight into the target or split across command lists recorded on the job system.
+// The resources bound are placeholders that are never dereferenced.
+class DrawBenchmark
+{
+public:
+	DrawBenchmark();
+	~DrawBenchmark();
+
+	void Initialise(int drawCount, int meshCount, JobSystem* jobs);
+
+	// Records one frame into listCount command lists, or straight into the target when listCount is 1.
+	bool RecordFrame(int listCount);
+	// Clears the target's counts and the state cache stats.
+	void ResetStats();
+
+	const NullStateTarget& GetTarget() const;
+	// The stats of the main state cache and every list's cache added together.
+	StateCacheStats GetStats() const;
+
+private:
+	// Matches the size of ObjectBufferType.
+	static const unsigned int ObjectConstantsSize = 80;
+	static const int IndexCount = 2280;
+
+	struct Recorder
+	{
+		CommandList* List;
+		StateCache* Cache;
+		int First;
+		int Last;
+		bool Result;
+	};
+
+	bool WriteConstants();
+	void BindSceneResources(StateCache* stateCache) const;
+	void RecordDraws(StateCache* stateCache, int first, int last) const;
+
+	// Distinct addresses to stand in for each kind of resource.
+	template <typename T>
+	T* GetResource(int index) const
+	{
+		return reinterpret_cast<T*>(const_cast<unsigned char*>(&_resources[index]));
+	}
+
+	JobSystem* _pJobs;
+	NullStateTarget _target;
+	StateCache _stateCache;
+	ConstantAllocator _allocator;
+	std::vector<Recorder> _recorders;
+	std::vector<ConstantRange> _objectConstants;
+	std::vector<int> _meshes;
+	std::vector<unsigned char> _resources;
+	int _meshCount;
+	// The caches' stats when ResetStats was last called.
+	StateCacheStats _statsBase;
+};
@@ -0,0 +1,402 @@
+#include "EquirectToCubemap.h"
+#include "CpuTexture.h"
+#include "HalfFloat.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define EQUIRECT_AVX2 1
+#define EQUIRECT_SSE 1
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define EQUIRECT_SSE 1
+#include <emmintrin.h>
+#endif
+
+// Every AVX2 processor also has F16C, but GCC and Clang only enable it when asked.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define EQUIRECT_F16C 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	const float PI = 3.14159265359f;
+
+	// Rows per job. Small enough that six faces keep every core busy, large enough that claiming a job is negligible.
+	const int BandSize = 16;
+
+	// Abramowitz and Stegun 4.4.49, atan(t) for t in [0, 1].
+	const float Atan1 = 0.9998660f;
+	const float Atan3 = -0.3302995f;
+	const float Atan5 = 0.1801410f;
+	const float Atan7 = -0.0851330f;
+	const float Atan9 = 0.0208351f;
+
+	// Cube face directions are Origin + u * Axis for u in [-1, 1] across a row, matching GetCubeDirection in IBLBaker.
+	struct FaceRow
+	{
+		float Origin[3];
+		float Axis[3];
+	};
+
+	FaceRow GetFaceRow(const int face, const float v)
+	{
+		static const float Axes[6][3] = {
+			{ 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f },
+			{ 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }
+		};
+
+		const float origins[6][3] = {
+			{ 1.0f, -v, 0.0f }, { -1.0f, -v, 0.0f }, { 0.0f, 1.0f, v },
+			{ 0.0f, -1.0f, -v }, { 0.0f, -v, 1.0f }, { 0.0f, -v, -1.0f }
+		};
+
+		FaceRow row;
+		for (int i = 0; i < 3; ++i)
+		{
+			row.Origin[i] = origins[face][i];
+			row.Axis[i] = Axes[face][i];
+		}
+
+		return row;
+	}
+
+	// Scale and offset from angles to source texel coordinates, with the half texel offset of a bilinear fetch folded in.
+	struct SourceMapping
+	{
+		float ScaleX;
+		float OffsetX;
+		float ScaleY;
+		float OffsetY;
+	};
+
+	float AtanScalar(const float y, const float x)
+	{
+		const float ax = std::fabs(x);
+		const float ay = std::fabs(y);
+		const float largest = std::max(ax, ay);
+		const float t = largest > 0.0f ? std::min(ax, ay) / largest : 0.0f;
+		const float t2 = t * t;
+
+		float angle = ((((Atan9 * t2 + Atan7) * t2 + Atan5) * t2 + Atan3) * t2 + Atan1) * t;
+		if (ay > ax)
+		{
+			angle = PI * 0.5f - angle;
+		}
+		if (x < 0.0f)
+		{
+			angle = PI - angle;
+		}
+
+		return y < 0.0f ? -angle : angle;
+	}
+
+	void MapScalar(const FaceRow& row, const SourceMapping& mapping, const float u, float& sx, float& sy)
+	{
+		const float x = row.Origin[0] + u * row.Axis[0];
+		const float y = row.Origin[1] + u * row.Axis[1];
+		const float z = row.Origin[2] + u * row.Axis[2];
+
+		sx = AtanScalar(z, x) * mapping.ScaleX + mapping.OffsetX;
+		sy = AtanScalar(y, std::sqrt(x * x + z * z)) * mapping.ScaleY + mapping.OffsetY;
+	}
+
+#if defined(EQUIRECT_AVX2)
+	__m256 Atan256(const __m256 y, const __m256 x)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		const __m256 ax = _mm256_andnot_ps(signMask, x);
+		const __m256 ay = _mm256_andnot_ps(signMask, y);
+		const __m256 largest = _mm256_max_ps(_mm256_max_ps(ax, ay), _mm256_set1_ps(1e-30f));
+		const __m256 t = _mm256_div_ps(_mm256_min_ps(ax, ay), largest);
+		const __m256 t2 = _mm256_mul_ps(t, t);
+
+		__m256 angle = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(Atan9), t2), _mm256_set1_ps(Atan7));
+		angle = _mm256_add_ps(_mm256_mul_ps(angle, t2), _mm256_set1_ps(Atan5));
+		angle = _mm256_add_ps(_mm256_mul_ps(angle, t2), _mm256_set1_ps(Atan3));
+		angle = _mm256_add_ps(_mm256_mul_ps(angle, t2), _mm256_set1_ps(Atan1));
+		angle = _mm256_mul_ps(angle, t);
+
+		angle = _mm256_blendv_ps(angle, _mm256_sub_ps(_mm256_set1_ps(PI * 0.5f), angle), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+		angle = _mm256_blendv_ps(angle, _mm256_sub_ps(_mm256_set1_ps(PI), angle),
+		                        _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+		return _mm256_xor_ps(angle, _mm256_and_ps(y, signMask));
+	}
+#endif
+
+#if defined(EQUIRECT_SSE)
+	__m128 Select(const __m128 mask, const __m128 a, const __m128 b)
+	{
+		return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+	}
+#endif
+
+#if defined(EQUIRECT_SSE) && !defined(EQUIRECT_AVX2)
+	__m128 Atan128(const __m128 y, const __m128 x)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 ax = _mm_andnot_ps(signMask, x);
+		const __m128 ay = _mm_andnot_ps(signMask, y);
+		const __m128 largest = _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(1e-30f));
+		const __m128 t = _mm_div_ps(_mm_min_ps(ax, ay), largest);
+		const __m128 t2 = _mm_mul_ps(t, t);
+
+		__m128 angle = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Atan9), t2), _mm_set1_ps(Atan7));
+		angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(Atan5));
+		angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(Atan3));
+		angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(Atan1));
+		angle = _mm_mul_ps(angle, t);
+
+		angle = Select(_mm_cmpgt_ps(ay, ax), angle, _mm_sub_ps(_mm_set1_ps(PI * 0.5f), angle));
+		angle = Select(_mm_cmplt_ps(x, _mm_setzero_ps()), angle, _mm_sub_ps(_mm_set1_ps(PI), angle));
+		return _mm_xor_ps(angle, _mm_and_ps(y, signMask));
+	}
+#endif
+
+	// Fills sx and sy with the source texel coordinates of every texel in a row of a face.
+	void MapRow(const FaceRow& row, const SourceMapping& mapping, const int size, float* sx, float* sy)
+	{
+		const float step = 2.0f / float(size);
+		const float start = step * 0.5f - 1.0f;
+		int x = 0;
+
+#if defined(EQUIRECT_AVX2)
+		const __m256 originX = _mm256_set1_ps(row.Origin[0]);
+		const __m256 originY = _mm256_set1_ps(row.Origin[1]);
+		const __m256 originZ = _mm256_set1_ps(row.Origin[2]);
+		const __m256 axisX = _mm256_set1_ps(row.Axis[0]);
+		const __m256 axisY = _mm256_set1_ps(row.Axis[1]);
+		const __m256 axisZ = _mm256_set1_ps(row.Axis[2]);
+		const __m256 scaleX = _mm256_set1_ps(mapping.ScaleX);
+		const __m256 offsetX = _mm256_set1_ps(mapping.OffsetX);
+		const __m256 scaleY = _mm256_set1_ps(mapping.ScaleY);
+		const __m256 offsetY = _mm256_set1_ps(mapping.OffsetY);
+		const __m256 lanes = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+
+		for (; x + 8 <= size; x += 8)
+		{
+			const __m256 index = _mm256_add_ps(_mm256_set1_ps(float(x)), lanes);
+			const __m256 u = _mm256_add_ps(_mm256_mul_ps(index, _mm256_set1_ps(step)), _mm256_set1_ps(start));
+			const __m256 dx = _mm256_add_ps(originX, _mm256_mul_ps(u, axisX));
+			const __m256 dy = _mm256_add_ps(originY, _mm256_mul_ps(u, axisY));
+			const __m256 dz = _mm256_add_ps(originZ, _mm256_mul_ps(u, axisZ));
+			const __m256 horizontal = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz)));
+
+			_mm256_storeu_ps(sx + x, _mm256_add_ps(_mm256_mul_ps(Atan256(dz, dx), scaleX), offsetX));
+			_mm256_storeu_ps(sy + x, _mm256_add_ps(_mm256_mul_ps(Atan256(dy, horizontal), scaleY), offsetY));
+		}
+#elif defined(EQUIRECT_SSE)
+		const __m128 originX = _mm_set1_ps(row.Origin[0]);
+		const __m128 originY = _mm_set1_ps(row.Origin[1]);
+		const __m128 originZ = _mm_set1_ps(row.Origin[2]);
+		const __m128 axisX = _mm_set1_ps(row.Axis[0]);
+		const __m128 axisY = _mm_set1_ps(row.Axis[1]);
+		const __m128 axisZ = _mm_set1_ps(row.Axis[2]);
+		const __m128 scaleX = _mm_set1_ps(mapping.ScaleX);
+		const __m128 offsetX = _mm_set1_ps(mapping.OffsetX);
+		const __m128 scaleY = _mm_set1_ps(mapping.ScaleY);
+		const __m128 offsetY = _mm_set1_ps(mapping.OffsetY);
+		const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+		for (; x + 4 <= size; x += 4)
+		{
+			const __m128 index = _mm_add_ps(_mm_set1_ps(float(x)), lanes);
+			const __m128 u = _mm_add_ps(_mm_mul_ps(index, _mm_set1_ps(step)), _mm_set1_ps(start));
+			const __m128 dx = _mm_add_ps(originX, _mm_mul_ps(u, axisX));
+			const __m128 dy = _mm_add_ps(originY, _mm_mul_ps(u, axisY));
+			const __m128 dz = _mm_add_ps(originZ, _mm_mul_ps(u, axisZ));
+			const __m128 horizontal = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)));
+
+			_mm_storeu_ps(sx + x, _mm_add_ps(_mm_mul_ps(Atan128(dz, dx), scaleX), offsetX));
+			_mm_storeu_ps(sy + x, _mm_add_ps(_mm_mul_ps(Atan128(dy, horizontal), scaleY), offsetY));
+		}
+#endif
+
+		for (; x < size; ++x)
+		{
+			MapScalar(row, mapping, float(x) * step + start, sx[x], sy[x]);
+		}
+	}
+
+#if defined(EQUIRECT_SSE)
+	typedef __m128 Colour;
+
+	Colour Lerp(const Colour a, const Colour b, const float t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+	}
+
+	void Store(float* texel, Colour colour)
+	{
+		_mm_storeu_ps(texel, colour);
+	}
+
+	void Store(uint16_t* texel, Colour colour)
+	{
+#if defined(EQUIRECT_F16C)
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(texel), _mm_cvtps_ph(colour, _MM_FROUND_TO_NEAREST_INT));
+#else
+		float values[4];
+		_mm_storeu_ps(values, colour);
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			texel[channel] = FloatToHalf(values[channel]);
+		}
+#endif
+	}
+#else
+	struct Colour
+	{
+		float Values[4];
+	};
+
+	Colour Lerp(const Colour& a, const Colour& b, const float t)
+	{
+		Colour result;
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			result.Values[channel] = a.Values[channel] + (b.Values[channel] - a.Values[channel]) * t;
+		}
+
+		return result;
+	}
+
+	void Store(float* texel, const Colour& colour)
+	{
+		std::copy(colour.Values, colour.Values + 4, texel);
+	}
+
+	void Store(uint16_t* texel, const Colour& colour)
+	{
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			texel[channel] = FloatToHalf(colour.Values[channel]);
+		}
+	}
+#endif
+
+	Colour LoadTexel(const float* pixels, const int width, const int x, const int y)
+	{
+		const float* texel = pixels + (size_t(y) * width + x) * CpuTexture::ChannelCount;
+#if defined(EQUIRECT_SSE)
+		return _mm_loadu_ps(texel);
+#else
+		Colour result;
+		std::copy(texel, texel + 4, result.Values);
+		return result;
+#endif
+	}
+
+	// Bilinearly filters the source at each coordinate and writes opaque texels.
+	template <typename Texel>
+	void SampleRow(const CpuTexture& source, const float* sx, const float* sy, const int count, Texel* output)
+	{
+		const float* pixels = source.GetPixels(0, 0);
+		const int width = source.GetWidth();
+		const int height = source.GetHeight();
+
+#if defined(EQUIRECT_SSE)
+		const __m128 opaque = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+		const __m128 one = _mm_set1_ps(1.0f);
+#endif
+
+		for (int i = 0; i < count; ++i)
+		{
+			// Coordinates are never below -0.5, so truncating after adding one floors them.
+			const int fx = int(sx[i] + 1.0f) - 1;
+			const int fy = int(sy[i] + 1.0f) - 1;
+			const float tx = sx[i] - float(fx);
+			const float ty = sy[i] - float(fy);
+
+			const int x0 = fx < 0 ? width - 1 : std::min(fx, width - 1);
+			const int x1 = fx + 1 >= width ? 0 : fx + 1;
+			const int y0 = std::min(std::max(fy, 0), height - 1);
+			const int y1 = std::min(fy + 1, height - 1);
+
+			const Colour top = Lerp(LoadTexel(pixels, width, x0, y0), LoadTexel(pixels, width, x1, y0), tx);
+			const Colour bottom = Lerp(LoadTexel(pixels, width, x0, y1), LoadTexel(pixels, width, x1, y1), tx);
+			Colour colour = Lerp(top, bottom, ty);
+
+#if defined(EQUIRECT_SSE)
+			colour = Select(opaque, colour, one);
+#else
+			colour.Values[3] = 1.0f;
+#endif
+
+			Store(output + size_t(i) * CpuTexture::ChannelCount, colour);
+		}
+	}
+
+	// Converts every face, one band of rows per job. getFace returns the texels of a face.
+	template <typename Texel, typename GetFace>
+	void ConvertFaces(const CpuTexture& equirect, const int size, JobSystem& jobs, const GetFace& getFace)
+	{
+		SourceMapping mapping;
+		mapping.ScaleX = float(equirect.GetWidth()) / (2.0f * PI);
+		mapping.OffsetX = float(equirect.GetWidth()) * 0.5f - 0.5f;
+		mapping.ScaleY = float(equirect.GetHeight()) / PI;
+		mapping.OffsetY = float(equirect.GetHeight()) * 0.5f - 0.5f;
+
+		const int bandsPerFace = (size + BandSize - 1) / BandSize;
+		const int bandCount = bandsPerFace * 6;
+
+		jobs.ParallelFor(bandCount, 1, [&](const int firstBand, const int lastBand)
+		{
+			std::vector<float> sx(size);
+			std::vector<float> sy(size);
+
+			for (int band = firstBand; band < lastBand; ++band)
+			{
+				const int face = band / bandsPerFace;
+				const int y0 = (band % bandsPerFace) * BandSize;
+				const int y1 = std::min(y0 + BandSize, size);
+				Texel* texels = getFace(face);
+
+				for (int y = y0; y < y1; ++y)
+				{
+					const float v = 2.0f * (float(y) + 0.5f) / float(size) - 1.0f;
+					MapRow(GetFaceRow(face, v), mapping, size, sx.data(), sy.data());
+					SampleRow(equirect, sx.data(), sy.data(), size,
+					          texels + size_t(y) * size * CpuTexture::ChannelCount);
+				}
+			}
+		});
+	}
+}
+
+EquirectToCubemap::EquirectToCubemap()
+{
+}
+
+EquirectToCubemap::~EquirectToCubemap()
+{
+}
+
+void EquirectToCubemap::Convert(const CpuTexture& equirect, const int size, JobSystem& jobs, CpuTexture& cubemap)
+{
+	cubemap.Initialise(size, size, 1, 6);
+	ConvertFaces<float>(equirect, size, jobs, [&](const int face)
+	{
+		return cubemap.GetPixels(face, 0);
+	});
+}
+
+void EquirectToCubemap::Convert(const CpuTexture& equirect, const int size, JobSystem& jobs,
+                                std::vector<uint16_t>& texels)
+{
+	const size_t faceSize = size_t(size) * size * CpuTexture::ChannelCount;
+	texels.resize(faceSize * 6);
+
+	uint16_t* data = texels.data();
+	ConvertFaces<uint16_t>(equirect, size, jobs, [&](const int face)
+	{
+		return data + faceSize * face;
+	});
+}
+
+float EquirectToCubemap::Atan2(const float y, const float x)
+{
+	return AtanScalar(y, x);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class CpuTexture;
+class JobSystem;
+
+// CPU version of RectToCubemap.shader, for converting equirectangular HDRIs without a GPU.
+// Source coordinates for a whole row of a face are computed together, eight at a time with AVX2 or four with SSE, using
+// a polynomial arctangent instead of atan2 and asin. Since asin(y) = atan2(y, sqrt(x * x + z * z)) the same polynomial
+// covers both angles, and neither needs the direction to be normalised. The polynomial is Abramowitz and Stegun 4.4.49,
+// whose error is at most 1e-5 radians, about 1/75th of a texel of an 8192 wide source.
+// The source is filtered bilinearly, wrapping horizontally and clamping at the poles. Faces are split into bands of
+// rows that run as jobs, and are written in D3D11 order (+X, -X, +Y, -Y, +Z, -Z).
+class EquirectToCubemap
+{
+	EquirectToCubemap();
+	~EquirectToCubemap();
+
+public:
+	// Writes a single mip RGBA 32-bit float cubemap.
+	static void Convert(const CpuTexture& equirect, int size, JobSystem& jobs, CpuTexture& cubemap);
+
+	// Writes RGBA 16-bit float texels in the layout of a single mip R16G16B16A16_FLOAT cubemap, which is what the
+	// environment map is stored as, so there is no intermediate float copy of the faces.
+	static void Convert(const CpuTexture& equirect, int size, JobSystem& jobs, std::vector<uint16_t>& texels);
+
+	// The arctangent approximation on its own, for measuring its error.
+	static float Atan2(float y, float x);
+};
@@ -0,0 +1,162 @@
+#include "FrustumCuller.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#define CULLING_AVX 1
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define CULLING_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	bool IsVisible(const Frustum& frustum, const float x, const float y, const float z, const float radius)
+	{
+		for (int p = 0; p < 6; ++p)
+		{
+			const float* plane = frustum.Planes[p];
+			// Summed in the same order as the vector paths, so every path agrees on spheres touching a plane.
+			if (plane[0] * x + plane[3] + plane[1] * y + plane[2] * z < -radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	int CullScalar(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+	               const int start, const int count, unsigned char* visible)
+	{
+		int visibleCount = 0;
+		for (int i = start; i < count; ++i)
+		{
+			visible[i] = IsVisible(frustum, x[i], y[i], z[i], radius[i]) ? 1 : 0;
+			visibleCount += visible[i];
+		}
+
+		return visibleCount;
+	}
+}
+
+FrustumCuller::FrustumCuller()
+{
+}
+
+FrustumCuller::~FrustumCuller()
+{
+}
+
+void FrustumCuller::ExtractPlanes(const float viewProjection[16], Frustum& frustum)
+{
+	// With row vectors, clip space is (x, y, z, w) = p * M, so each clip coordinate is p dotted with a column.
+	float columns[4][4];
+	for (int c = 0; c < 4; ++c)
+	{
+		for (int r = 0; r < 4; ++r)
+		{
+			columns[c][r] = viewProjection[r * 4 + c];
+		}
+	}
+
+	// -w <= x <= w, -w <= y <= w and 0 <= z <= w.
+	for (int i = 0; i < 4; ++i)
+	{
+		frustum.Planes[0][i] = columns[3][i] + columns[0][i];
+		frustum.Planes[1][i] = columns[3][i] - columns[0][i];
+		frustum.Planes[2][i] = columns[3][i] + columns[1][i];
+		frustum.Planes[3][i] = columns[3][i] - columns[1][i];
+		frustum.Planes[4][i] = columns[2][i];
+		frustum.Planes[5][i] = columns[3][i] - columns[2][i];
+	}
+
+	for (int p = 0; p < 6; ++p)
+	{
+		float* plane = frustum.Planes[p];
+		const float invLength = 1.0f / std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		for (int i = 0; i < 4; ++i)
+		{
+			plane[i] *= invLength;
+		}
+	}
+}
+
+int FrustumCuller::Cull(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                        const int count, unsigned char* visible)
+{
+	int visibleCount = 0;
+	int i = 0;
+
+#if defined(CULLING_AVX)
+	__m256 planes[6][4];
+	for (int p = 0; p < 6; ++p)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			planes[p][j] = _mm256_set1_ps(frustum.Planes[p][j]);
+		}
+	}
+
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 sx = _mm256_loadu_ps(x + i);
+		const __m256 sy = _mm256_loadu_ps(y + i);
+		const __m256 sz = _mm256_loadu_ps(z + i);
+		const __m256 negativeRadius = _mm256_xor_ps(_mm256_loadu_ps(radius + i), signMask);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; ++p)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(planes[p][0], sx), planes[p][3]);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(planes[p][1], sy));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(planes[p][2], sz));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+
+		const int mask = _mm256_movemask_ps(inside);
+		for (int j = 0; j < 8; ++j)
+		{
+			visible[i + j] = static_cast<unsigned char>((mask >> j) & 1);
+			visibleCount += (mask >> j) & 1;
+		}
+	}
+#elif defined(CULLING_SSE)
+	__m128 planes[6][4];
+	for (int p = 0; p < 6; ++p)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			planes[p][j] = _mm_set1_ps(frustum.Planes[p][j]);
+		}
+	}
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 sx = _mm_loadu_ps(x + i);
+		const __m128 sy = _mm_loadu_ps(y + i);
+		const __m128 sz = _mm_loadu_ps(z + i);
+		const __m128 negativeRadius = _mm_xor_ps(_mm_loadu_ps(radius + i), signMask);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(planes[p][0], sx), planes[p][3]);
+			distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][1], sy));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][2], sz));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		const int mask = _mm_movemask_ps(inside);
+		for (int j = 0; j < 4; ++j)
+		{
+			visible[i + j] = static_cast<unsigned char>((mask >> j) & 1);
+			visibleCount += (mask >> j) & 1;
+		}
+	}
+#endif
+
+	return visibleCount + CullScalar(frustum, x, y, z, radius, i, count, visible);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Six planes (a, b, c, d) facing into the frustum, normalised so ax + by + cz + d is a signed distance.
+// In order: left, right, bottom, top, near, far.
+struct Frustum
+{
+	float Planes[6][4];
+};
+
+// Tests bounding spheres against a view frustum. Spheres are passed as separate x, y, z and radius arrays so
+// they can be tested eight at a time with AVX, or four with SSE.
+class FrustumCuller
+{
+	FrustumCuller();
+	~FrustumCuller();
+
+public:
+	// Takes a row-major view-projection matrix for row vectors, as DirectXMath builds them, with D3D's 0 to 1
+	// clip space depth.
+	static void ExtractPlanes(const float viewProjection[16], Frustum& frustum);
+
+	// Sets visible[i] to 1 for spheres at least partly inside the frustum and 0 for the rest, and returns how
+	// many are visible. Spheres exactly touching a plane count as visible.
+	static int Cull(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+	                int count, unsigned char* visible);
+};
@@ -2,15 +2,53 @@
 #include "Input.h"
 #include "D3D.h"
 #include "Camera.h"
-#include "Model.h"
+#include "Scene.h"
+#include "Mesh.h"
+#include "MeshCache.h"
 #include "PBRShader.h"
 #include "Skybox.h"
-#include "FrameCBuffer.h"
-#include "ObjectCBuffer.h"
+#include "ViewCBuffer.h"
+#include "LightCBuffer.h"
+#include "ConstantRingBuffer.h"
 #include "Texture.h"
+#include "StateCache.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "RenderTargetPool.h"
 #include <d3d11.h>
+#include <algorithm>
+#include <cstdio>
 
-Graphics::Graphics() = default;
+Graphics::Graphics()
+{
+	_pD3D = nullptr;
+	_pCamera = nullptr;
+	_pSkybox = nullptr;
+	_pViewBuffer = nullptr;
+	_pLightBuffer = nullptr;
+	_pObjectBuffer = nullptr;
+	_pScene = nullptr;
+	_pMeshCache = nullptr;
+	_pInstanceBuffer = nullptr;
+	_cullingStats.Visible = 0;
+	_cullingStats.Culled = 0;
+	_constantUploadBytes = 0;
+	_instanceUploadBytes = 0;
+	_skippedUploads = 0;
+	_stateStats.Requested = 0;
+	_stateStats.Forwarded = 0;
+	_stateStats.Elided = 0;
+	_renderTargetStatsLogged = false;
+	_pPBRShader = nullptr;
+	_pInstancedShader = nullptr;
+	_instancedModels = InstancedModels;
+	_switchKeyDown = false;
+	_pNormal = nullptr;
+	_pRoughness = nullptr;
+	_pMetallic = nullptr;
+	_pInput = nullptr;
+	_pJobSystem = nullptr;
+}
 
 Graphics::~Graphics()
 {
@@ -20,11 +58,35 @@ Graphics::~Graphics()
 		_pPBRShader = nullptr;
 	}
 
-	for (auto it = _pModels.begin(); it != _pModels.end(); ++it)
+	if (_pInstancedShader)
+	{
+		delete _pInstancedShader;
+		_pInstancedShader = nullptr;
+	}
+
+	// The scene's meshes came from the cache, so go back to it before it is deleted.
+	if (_pScene)
+	{
+		for (int i = 0; i < _pScene->GetMeshCount(); ++i)
+		{
+			_pMeshCache->Release(_pScene->GetMesh(i));
+		}
+
+		delete _pScene;
+		_pScene = nullptr;
+	}
+
+	if (_pMeshCache)
+	{
+		delete _pMeshCache;
+		_pMeshCache = nullptr;
+	}
+
+	if (_pInstanceBuffer)
 	{
-		delete *it;
+		delete _pInstanceBuffer;
+		_pInstanceBuffer = nullptr;
 	}
-	_pModels.clear();
 
 	if (_pCamera)
 	{
@@ -56,10 +118,16 @@ Graphics::~Graphics()
 		_pNormal = nullptr;
 	}
 
-	if (_pFrameBuffer)
+	if (_pViewBuffer)
+	{
+		delete _pViewBuffer;
+		_pViewBuffer = nullptr;
+	}
+
+	if (_pLightBuffer)
 	{
-		delete _pFrameBuffer;
-		_pFrameBuffer = nullptr;
+		delete _pLightBuffer;
+		_pLightBuffer = nullptr;
 	}
 
 	if (_pObjectBuffer)
@@ -68,17 +136,36 @@ Graphics::~Graphics()
 		_pObjectBuffer = nullptr;
 	}
 
+	for (size_t i = 0; i < _drawRecorders.size(); ++i)
+	{
+		delete _drawRecorders[i].Cache;
+		delete _drawRecorders[i].List;
+	}
+
+	_drawRecorders.clear();
+
 	if (_pD3D)
 	{
 		delete _pD3D;
 		_pD3D = nullptr;
 	}
+
+	if (_pJobSystem)
+	{
+		delete _pJobSystem;
+		_pJobSystem = nullptr;
+	}
 }
 
 bool Graphics::Initialise(const int screenWidth, const int screenHeight, const HWND hwnd, Input* input)
 {
+	PROFILE_ZONE("Graphics::Initialise");
+
 	_pInput = input;
 
+	_pJobSystem = new JobSystem;
+	_pJobSystem->Initialise(0);
+
 	// Create the Direct3D object.
 	_pD3D = new D3D;
 	if (!_pD3D)
@@ -96,98 +183,210 @@ bool Graphics::Initialise(const int screenWidth, const int screenHeight, const H
 
 	ID3D11Device* device = _pD3D->GetDevice();
 
-	_pMetallic = new Texture;
-	HRESULT hr = _pMetallic->Initialise(device, L"metallic.dds");
-	if (!hr)
+	// Create the camera object.
+	_pCamera = new Camera;
+	_pCamera->Initialise(screenWidth, screenHeight, ScreenNear, ScreenDepth);
+
+	// Set the initial position of the camera.
+	_pCamera->SetPosition(0.0f, 0.0f, -10.0f);
+
+	_pViewBuffer = new ViewCBuffer;
+	_pViewBuffer->Initialise(device);
+
+	_pLightBuffer = new LightCBuffer;
+	_pLightBuffer->Initialise(device);
+
+	int lightIndex = 0;
+	for (int i = 0; i < 2; ++i)
 	{
-		return false;
+		for (int j = 0; j < 2; ++j)
+		{
+			_pLightBuffer->SetLight(lightIndex, XMFLOAT3(2.5f + i * 10.0f, 2.5f + j * 10.0f, -10.0f),
+			                        XMFLOAT3(300.0f, 300.0f, 300.0f));
+			++lightIndex;
+		}
 	}
 
-	_pNormal = new Texture;
-	hr = _pNormal->Initialise(device, L"normal.dds");
-	if (!hr)
+	// The non-instanced path is set up even when starting on the instanced one, so the two can be switched between.
+	_pObjectBuffer = new ConstantRingBuffer;
+	result = _pObjectBuffer->Initialise(device, 64 * 1024);
+	if (!result)
 	{
-		return false;
+		delete _pObjectBuffer;
+		_pObjectBuffer = nullptr;
+
+		if (!InstancedModels)
+		{
+			MessageBox(hwnd, L"Could not initialize the object constant buffer.", L"Error", MB_OK);
+			return false;
+		}
 	}
 
+	// Without lists, or with only the one core, the draws are recorded straight into the device context.
+	const int recorderCount = ParallelDrawRecording && _pObjectBuffer ? _pJobSystem->GetThreadCount() : 0;
+	for (int i = 0; recorderCount > 1 && i < recorderCount; ++i)
+	{
+		CommandList* list = _pD3D->GetStateCache()->CreateCommandList();
+		if (!list)
+		{
+			break;
+		}
+
+		DrawRecorder recorder;
+		recorder.List = list;
+		recorder.Cache = new StateCache;
+		recorder.Cache->Initialise(list->GetTarget());
+		recorder.First = 0;
+		recorder.Last = 0;
+		recorder.Result = false;
+		_drawRecorders.push_back(recorder);
+	}
+
+	// Load the material textures on other cores while the skybox is set up. The device is free threaded, so
+	// resources can be created from any thread.
+	_pMetallic = new Texture;
+	_pNormal = new Texture;
 	_pRoughness = new Texture;
-	hr = _pRoughness->Initialise(device, L"roughness.dds");
-	if (!hr)
+	bool loaded[3] = {};
+
+	JobCounter textureJobs;
+	_pJobSystem->Run([&]()
+	{
+		loaded[0] = _pMetallic->Initialise(device, L"metallic.dds");
+	}, &textureJobs);
+	_pJobSystem->Run([&]()
+	{
+		loaded[1] = _pNormal->Initialise(device, L"normal.dds");
+	}, &textureJobs);
+	_pJobSystem->Run([&]()
+	{
+		loaded[2] = _pRoughness->Initialise(device, L"roughness.dds");
+	}, &textureJobs);
+
+	// Only starts the bake, which carries on in the background behind a placeholder.
+	_pSkybox = new Skybox;
+	const bool skyboxCreated = _pSkybox->Initialise(_pD3D, hwnd, _pViewBuffer, _pJobSystem);
+
+	_pJobSystem->Wait(textureJobs);
+	if (!skyboxCreated || !loaded[0] || !loaded[1] || !loaded[2])
 	{
 		return false;
 	}
 
-	// Create the camera object.
-	_pCamera = new Camera;
-	_pCamera->Initialise(screenWidth, screenHeight, ScreenNear, ScreenDepth);
-
-	// Set the initial position of the camera.
-	_pCamera->SetPosition(0.0f, 0.0f, -10.0f);
+	// Models with the same geometry share one mesh from the cache.
+	_pMeshCache = new MeshCache;
+	_pScene = new Scene;
 
-	_pFrameBuffer = new FrameCBuffer;
-	_pFrameBuffer->Initialise(device);
+	Mesh* sphere = _pMeshCache->AcquireSphere(device, 1.0f, 20, 20);
+	if (!sphere)
+	{
+		MessageBox(hwnd, L"Could not initialize the sphere mesh.", L"Error", MB_OK);
+		return false;
+	}
 
-	_pObjectBuffer = new ObjectCBuffer;
-	_pObjectBuffer->Initialise(device);
+	const MeshHandle sphereMesh = _pScene->AddMesh(sphere);
 
-	_pSkybox = new Skybox;
-	_pSkybox->Initialise(_pD3D, hwnd, _pFrameBuffer, _pCamera);
+	Material gold;
+	gold.Colour = XMFLOAT4(1.0f, 0.6172f, 0.1384f, 1.0f);
+	const MaterialHandle goldMaterial = _pScene->AddMaterial(gold);
 
-	// Create the model object.
+	// Create the models.
 	for (int i = 0; i < 10; ++i)
 	{
 		for (int j = 0; j < 10; ++j)
 		{
-			Model* model = new Model;
-
-			result = model->Initialise(device, XMFLOAT3(i * 2.0f, j * 2.0f, 0.0f));
-			if (!result)
-			{
-				MessageBox(hwnd, L"Could not initialize the model object.", L"Error", MB_OK);
-				return false;
-			}
-
-			_pModels.push_back(model);
+			_pScene->CreateEntity(XMFLOAT3(i * 2.0f, j * 2.0f, 0.0f), sphereMesh, goldMaterial);
 		}
 	}
 
-	_pPBRShader = new PBRShader;
-	if (!_pPBRShader)
+	LogMeshStats();
+
+	_pInstanceBuffer = new InstanceBuffer;
+	result = _pInstanceBuffer->Initialise(device, _pScene->GetEntityCount());
+	if (!result)
 	{
 		return false;
 	}
 
-	result = _pPBRShader->Initialise(device, hwnd);
+	_pInstancedShader = new PBRShader;
+	result = _pInstancedShader->Initialise(device, hwnd, true, PackedVertices);
 	if (!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the PBR shader object.", L"Error", MB_OK);
 		return false;
 	}
 
+	if (_pObjectBuffer)
+	{
+		_pPBRShader = new PBRShader;
+		result = _pPBRShader->Initialise(device, hwnd, false, PackedVertices);
+		if (!result)
+		{
+			MessageBox(hwnd, L"Could not initialize the PBR shader object.", L"Error", MB_OK);
+			return false;
+		}
+	}
+
 	return true;
 }
 
-bool Graphics::Frame() const
+bool Graphics::Frame()
 {
+	// Only switch on the frame F9 goes down, so holding it doesn't flip back and forth.
+	const bool keyDown = _pInput->IsKeyDown(DIK_F9);
+	if (keyDown && !_switchKeyDown && _pObjectBuffer)
+	{
+		_instancedModels = !_instancedModels;
+	}
+
+	_switchKeyDown = keyDown;
+
 	_pCamera->UpdateInput(_pInput);
 
 	return true;
 }
 
-bool Graphics::Render() const
+bool Graphics::Render()
 {
-	ID3D11DeviceContext* context = _pD3D->GetDeviceContext();
+	PROFILE_ZONE("Graphics::Render");
+
+	StateCache* stateCache = _pD3D->GetStateCache();
 	XMMATRIX worldMatrix;
 
+	const StateCacheStats stateTotals = GetStateTotals();
+	const unsigned long long skippedUploads = _pViewBuffer->GetStats().SkippedUploads +
+	                                          _pLightBuffer->GetStats().SkippedUploads;
+
+	// The bake's passes draw to their own targets, so they go before the frame's are cleared.
+	if (!_pSkybox->Update(_pD3D))
+	{
+		return false;
+	}
+
+	if (!_renderTargetStatsLogged && _pSkybox->IsBakeComplete())
+	{
+		LogRenderTargetStats();
+		_renderTargetStatsLogged = true;
+	}
+
 	_pD3D->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
 
-	bool result = _pCamera->Render(context, _pFrameBuffer);
+	const unsigned long long uploadBytes = _pViewBuffer->GetStats().UploadBytes +
+	                                       _pLightBuffer->GetStats().UploadBytes;
+
+	bool result = _pCamera->Render(stateCache, _pViewBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = _pLightBuffer->Update(stateCache);
 	if (!result)
 	{
 		return false;
 	}
 
-	result = _pSkybox->Render(context);
+	result = _pSkybox->Render(stateCache);
 	if (!result)
 	{
 		return false;
@@ -195,34 +394,380 @@ bool Graphics::Render() const
 
 	_pCamera->GetWorldMatrix(worldMatrix);
 
-	// Bind textures.
-	ID3D11ShaderResourceView* normal = _pNormal->GetSRV();
-	ID3D11ShaderResourceView* roughness = _pRoughness->GetSRV();
-	ID3D11ShaderResourceView* metallic = _pMetallic->GetSRV();
-	context->PSSetShaderResources(3, 1, &normal);
-	context->PSSetShaderResources(4, 1, &roughness);
-	context->PSSetShaderResources(5, 1, &metallic);
+	BindSceneResources(stateCache);
 
 	// Render meshes.
-	for (auto it = _pModels.begin(); it != _pModels.end(); ++it)
+	CullModels(worldMatrix);
+	result = _instancedModels ? RenderModelsInstanced(stateCache, worldMatrix) : RenderModels(stateCache, worldMatrix);
+	if (!result)
+	{
+		return false;
+	}
+
+	_constantUploadBytes = size_t(_pViewBuffer->GetStats().UploadBytes + _pLightBuffer->GetStats().UploadBytes -
+	                              uploadBytes);
+	if (_instancedModels)
+	{
+		_instanceUploadBytes = sizeof(InstanceType) * _instances.size();
+	}
+	else
 	{
-		Model* model = *it;
+		_constantUploadBytes += _pObjectBuffer->GetFrameBytes();
+		_instanceUploadBytes = 0;
+	}
 
-		model->Render(context);
+	_skippedUploads = _pViewBuffer->GetStats().SkippedUploads + _pLightBuffer->GetStats().SkippedUploads -
+	                  skippedUploads;
 
-		result = _pObjectBuffer->Update(context, worldMatrix, model->GetPosition());
-		if (!result)
+	_stateStats = GetStateTotals();
+	_stateStats.Requested -= stateTotals.Requested;
+	_stateStats.Forwarded -= stateTotals.Forwarded;
+	_stateStats.Elided -= stateTotals.Elided;
+
+	_pD3D->EndScene();
+	return true;
+}
+
+bool Graphics::RenderModels(StateCache* stateCache, const XMMATRIX worldMatrix)
+{
+	PROFILE_ZONE("Graphics::RenderModels");
+
+	const int entityCount = _pScene->GetEntityCount();
+	const float* positionsX = _pScene->GetPositionsX();
+	const float* positionsY = _pScene->GetPositionsY();
+	const float* positionsZ = _pScene->GetPositionsZ();
+	const MaterialHandle* materialHandles = _pScene->GetMaterialHandles();
+
+	// Write every visible model's constants with one map, then draw each with its own range bound.
+	const unsigned int objectSize = ConstantAllocator::GetAllocationSize(sizeof(ObjectBufferType));
+	if (!_pObjectBuffer->BeginFrame(_pD3D->GetDevice(), stateCache, objectSize * unsigned(_cullingStats.Visible)))
+	{
+		return false;
+	}
+
+	_objectConstants.resize(entityCount);
+	for (int i = 0; i < entityCount; ++i)
+	{
+		if (!_visible[i])
+		{
+			continue;
+		}
+
+		ObjectBufferType* objectPtr = static_cast<ObjectBufferType*>(
+			_pObjectBuffer->Allocate(sizeof(ObjectBufferType), _objectConstants[i]));
+		if (!objectPtr)
+		{
+			_pObjectBuffer->EndFrame(stateCache);
+			return false;
+		}
+
+		const XMMATRIX world = XMMatrixMultiply(worldMatrix,
+		                                        XMMatrixTranslation(positionsX[i], positionsY[i], positionsZ[i]));
+		objectPtr->World = XMMatrixTranspose(world);
+		objectPtr->Colour = _pScene->GetMaterial(materialHandles[i]).Colour;
+	}
+
+	_pObjectBuffer->EndFrame(stateCache);
+
+	_drawOrder.clear();
+	for (int i = 0; i < entityCount; ++i)
+	{
+		if (_visible[i])
+		{
+			_drawOrder.push_back(i);
+		}
+	}
+
+	const int drawCount = int(_drawOrder.size());
+	const int listCount = std::min(int(_drawRecorders.size()), drawCount / MinDrawsPerList);
+	if (listCount <= 1)
+	{
+		return RecordModelDraws(stateCache, 0, drawCount);
+	}
+
+	// Lists are begun on this thread, as they copy the render targets and viewport from the device context.
+	const int drawsPerList = (drawCount + listCount - 1) / listCount;
+	for (int i = 0; i < listCount; ++i)
+	{
+		DrawRecorder& recorder = _drawRecorders[i];
+		recorder.First = std::min(i * drawsPerList, drawCount);
+		recorder.Last = std::min(recorder.First + drawsPerList, drawCount);
+		recorder.Result = recorder.List->Begin();
+		recorder.Cache->Invalidate();
+	}
+
+	_pJobSystem->ParallelFor(listCount, 1, [this](const int first, const int last)
+	{
+		for (int i = first; i < last; ++i)
+		{
+			DrawRecorder& recorder = _drawRecorders[i];
+			if (!recorder.Result)
+			{
+				continue;
+			}
+
+			BindSceneResources(recorder.Cache);
+			recorder.Result = RecordModelDraws(recorder.Cache, recorder.First, recorder.Last);
+			recorder.Result = recorder.List->End() && recorder.Result;
+		}
+	});
+
+	// Executed in the order they were split, so the frame comes out the same however the jobs were scheduled.
+	for (int i = 0; i < listCount; ++i)
+	{
+		if (!_drawRecorders[i].Result)
 		{
 			return false;
 		}
 
-		result = _pPBRShader->Render(context, model->GetIndexCount(), _pFrameBuffer, _pObjectBuffer);
+		stateCache->ExecuteCommandList(_drawRecorders[i].List);
+	}
+
+	return true;
+}
+
+void Graphics::BindSceneResources(StateCache* stateCache) const
+{
+	_pSkybox->BindLighting(stateCache);
+
+	stateCache->SetShaderResource(ShaderStage::Pixel, 3, _pNormal->GetSRV());
+	stateCache->SetShaderResource(ShaderStage::Pixel, 4, _pRoughness->GetSRV());
+	stateCache->SetShaderResource(ShaderStage::Pixel, 5, _pMetallic->GetSRV());
+}
+
+bool Graphics::RecordModelDraws(StateCache* stateCache, const int first, const int last) const
+{
+	PROFILE_ZONE("Graphics::RecordModelDraws");
+
+	const MeshHandle* meshHandles = _pScene->GetMeshHandles();
+
+	for (int i = first; i < last; ++i)
+	{
+		const int entity = _drawOrder[i];
+		const Mesh* mesh = _pScene->GetMesh(meshHandles[entity]);
+		mesh->Bind(stateCache);
+
+		const int lod = _lods[entity];
+		const bool result = _pPBRShader->Render(stateCache, mesh->GetIndexCount(lod), mesh->GetStartIndex(lod),
+		                                        _pViewBuffer, _pLightBuffer, _pObjectBuffer,
+		                                        _objectConstants[entity]);
 		if (!result)
 		{
 			return false;
 		}
 	}
 
-	_pD3D->EndScene();
 	return true;
 }
+
+bool Graphics::RenderModelsInstanced(StateCache* stateCache, const XMMATRIX worldMatrix)
+{
+	PROFILE_ZONE("Graphics::RenderModelsInstanced");
+
+	const int entityCount = _pScene->GetEntityCount();
+	const float* positionsX = _pScene->GetPositionsX();
+	const float* positionsY = _pScene->GetPositionsY();
+	const float* positionsZ = _pScene->GetPositionsZ();
+	const MeshHandle* meshHandles = _pScene->GetMeshHandles();
+	const MaterialHandle* materialHandles = _pScene->GetMaterialHandles();
+
+	// Counting sort the visible entities by mesh and LOD, so each batch fills a contiguous run of instances.
+	ModelBatch emptyBatch;
+	emptyBatch.StartInstance = 0;
+	emptyBatch.InstanceCount = 0;
+	_batches.assign(_pScene->GetMeshCount() * Mesh::MaxLodCount, emptyBatch);
+	_batchIndices.resize(entityCount);
+
+	for (int i = 0; i < entityCount; ++i)
+	{
+		if (_visible[i])
+		{
+			_batchIndices[i] = meshHandles[i] * Mesh::MaxLodCount + _lods[i];
+			++_batches[_batchIndices[i]].InstanceCount;
+		}
+	}
+
+	int startInstance = 0;
+	for (auto it = _batches.begin(); it != _batches.end(); ++it)
+	{
+		it->StartInstance = startInstance;
+		startInstance += it->InstanceCount;
+		it->InstanceCount = 0;
+	}
+
+	_instances.resize(startInstance);
+	for (int i = 0; i < entityCount; ++i)
+	{
+		if (!_visible[i])
+		{
+			continue;
+		}
+
+		const XMMATRIX world = XMMatrixMultiply(worldMatrix,
+		                                        XMMatrixTranslation(positionsX[i], positionsY[i], positionsZ[i]));
+
+		ModelBatch& batch = _batches[_batchIndices[i]];
+		InstanceType& instance = _instances[batch.StartInstance + batch.InstanceCount];
+		XMStoreFloat4x4(&instance.World, world);
+		instance.Colour = _pScene->GetMaterial(materialHandles[i]).Colour;
+		++batch.InstanceCount;
+	}
+
+	// One upload for every instance in the frame.
+	if (!_pInstanceBuffer->Update(_pD3D->GetDevice(), stateCache, _instances.data(), int(_instances.size())))
+	{
+		return false;
+	}
+
+	_pInstanceBuffer->Bind(stateCache, 1);
+
+	for (size_t i = 0; i < _batches.size(); ++i)
+	{
+		const ModelBatch& batch = _batches[i];
+		if (batch.InstanceCount == 0)
+		{
+			continue;
+		}
+
+		const Mesh* mesh = _pScene->GetMesh(MeshHandle(i / Mesh::MaxLodCount));
+		const int lod = int(i % Mesh::MaxLodCount);
+		mesh->Bind(stateCache);
+
+		if (!_pInstancedShader->Render(stateCache, mesh->GetIndexCount(lod), mesh->GetStartIndex(lod),
+		                               batch.InstanceCount, batch.StartInstance, _pViewBuffer, _pLightBuffer))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Graphics::CullModels(const XMMATRIX worldMatrix)
+{
+	PROFILE_ZONE("Graphics::CullModels");
+
+	const int entityCount = _pScene->GetEntityCount();
+	const float* positionsX = _pScene->GetPositionsX();
+	const float* positionsY = _pScene->GetPositionsY();
+	const float* positionsZ = _pScene->GetPositionsZ();
+	const float* radii = _pScene->GetBoundingRadii();
+	const MeshHandle* meshHandles = _pScene->GetMeshHandles();
+
+	_visible.resize(entityCount);
+	_lods.resize(entityCount);
+
+	XMMATRIX viewMatrix, projectionMatrix;
+	_pCamera->GetViewMatrix(viewMatrix);
+	_pCamera->GetProjectionMatrix(projectionMatrix);
+
+	// Fold the world matrix into the frustum, so the scene's positions can be tested as they are.
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMMatrixMultiply(worldMatrix, viewMatrix), projectionMatrix));
+
+	Frustum frustum;
+	FrustumCuller::ExtractPlanes(&viewProjection._11, frustum);
+
+	// Large scenes are culled in ranges spread across every core. The grain is a multiple of the culler's width.
+	const int grainSize = 4096;
+	std::atomic<int> visibleCount(0);
+	_pJobSystem->ParallelFor(entityCount, grainSize, [&](const int first, const int last)
+	{
+		visibleCount += FrustumCuller::Cull(frustum, positionsX + first, positionsY + first, positionsZ + first,
+		                                    radii + first, last - first, _visible.data() + first);
+
+		for (int i = first; i < last; ++i)
+		{
+			if (!_visible[i])
+			{
+				continue;
+			}
+
+			XMFLOAT3 centre;
+			XMStoreFloat3(&centre, XMVector3Transform(XMVectorSet(positionsX[i], positionsY[i], positionsZ[i], 1.0f),
+			                                          worldMatrix));
+
+			const Mesh* mesh = _pScene->GetMesh(meshHandles[i]);
+			_lods[i] = mesh->SelectLod(_pCamera->GetScreenSize(centre, radii[i]));
+		}
+	});
+
+	_cullingStats.Visible = visibleCount;
+	_cullingStats.Culled = entityCount - _cullingStats.Visible;
+}
+
+CullingStats Graphics::GetCullingStats() const
+{
+	return _cullingStats;
+}
+
+bool Graphics::IsInstanced() const
+{
+	return _instancedModels;
+}
+
+size_t Graphics::GetConstantUploadBytes() const
+{
+	return _constantUploadBytes;
+}
+
+size_t Graphics::GetInstanceUploadBytes() const
+{
+	return _instanceUploadBytes;
+}
+
+unsigned long long Graphics::GetSkippedUploads() const
+{
+	return _skippedUploads;
+}
+
+StateCacheStats Graphics::GetStateStats() const
+{
+	return _stateStats;
+}
+
+StateCacheStats Graphics::GetStateTotals() const
+{
+	StateCacheStats totals = _pD3D->GetStateCache()->GetStats();
+	for (size_t i = 0; i < _drawRecorders.size(); ++i)
+	{
+		const StateCacheStats stats = _drawRecorders[i].Cache->GetStats();
+		totals.Requested += stats.Requested;
+		totals.Forwarded += stats.Forwarded;
+		totals.Elided += stats.Elided;
+	}
+
+	return totals;
+}
+
+void Graphics::LogMeshStats() const
+{
+	const MeshCacheStats cacheStats = _pMeshCache->GetStats();
+	char message[256];
+	sprintf_s(message, "Mesh cache: %zu meshes, %zu references, %zu hits, %zu misses, %zu KB of buffers\n",
+	          cacheStats.MeshCount, cacheStats.ReferenceCount, cacheStats.Hits, cacheStats.Misses,
+	          cacheStats.BufferBytes / 1024);
+	OutputDebugStringA(message);
+
+	for (int i = 0; i < _pScene->GetMeshCount(); ++i)
+	{
+		const MeshOptimiserStats& stats = _pScene->GetMesh(i)->GetOptimiserStats();
+		sprintf_s(message, "Mesh %d: ACMR %.3f to %.3f, ATVR %.3f to %.3f\n", i, stats.AcmrBefore, stats.AcmrAfter,
+		          stats.AtvrBefore, stats.AtvrAfter);
+		OutputDebugStringA(message);
+	}
+}
+
+void Graphics::LogRenderTargetStats() const
+{
+	const RenderTargetPool* pool = _pD3D->GetRenderTargetPool();
+	const ResourcePoolStats targetStats = pool->GetRenderTargetStats();
+	const ResourcePoolStats depthStats = pool->GetDepthBufferStats();
+
+	char message[256];
+	sprintf_s(message, "Render target pool after the skybox bake: render targets %zu hits, %zu misses, %zu in use, "
+	          "%zu free; depth buffers %zu hits, %zu misses, %zu in use, %zu free\n", targetStats.Hits,
+	          targetStats.Misses, targetStats.InUse, targetStats.Free, depthStats.Hits, depthStats.Misses,
+	          depthStats.InUse, depthStats.Free);
+	OutputDebugStringA(message);
+}
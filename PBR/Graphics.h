@@ -2,22 +2,42 @@
 
 #include <vector>
 #include <DirectXMath.h>
+#include "InstanceBuffer.h"
+#include "FrustumCuller.h"
+#include "ConstantAllocator.h"
+#include "StateCache.h"
 
 const bool FullScreen = false;
 const bool VsyncEnabled = true;
 const float ScreenDepth = 1000.0f;
 const float ScreenNear = 0.1f;
 
+// Draws every model sharing a mesh with one instanced call, rather than one draw per model with its own ObjectBuffer.
+// This is the path the demo starts on. F9 switches between the two while running, if the device can bind constants
+// by offset.
+const bool InstancedModels = true;
+
+// Records the non-instanced path's draws into command lists on every core, executed in scene order by the main
+// thread. The instanced path makes too few draws to be worth splitting.
+const bool ParallelDrawRecording = true;
+
+// Uploads model meshes as PackedVertexType rather than FullVertexType, less than half the vertex fetch bandwidth.
+const bool PackedVertices = true;
+
 struct HWND__;
 class Input;
-class Model;
+class Scene;
 class PBRShader;
 class D3D;
 class Camera;
 class Skybox;
-class FrameCBuffer;
+class ViewCBuffer;
+class LightCBuffer;
 class Texture;
-class ObjectCBuffer;
+class ConstantRingBuffer;
+class Mesh;
+class MeshCache;
+class JobSystem;
 
 struct PosUvVertexType
 {
@@ -25,19 +45,44 @@ struct PosUvVertexType
 	DirectX::XMFLOAT2 Uv;
 };
 
+// Colour is per model rather than per vertex, and comes from ObjectBuffer or the instance stream.
 struct FullVertexType
 {
 	DirectX::XMFLOAT3 Position;
 	DirectX::XMFLOAT3 Normal;
-	DirectX::XMFLOAT4 Colour;
 	DirectX::XMFLOAT2 Uv;
 };
 
+// The 20 byte equivalent of FullVertexType, converted with VertexPacking. Normal is octahedral encoded snorm16
+// and Uv is unorm16.
+struct PackedVertexType
+{
+	DirectX::XMFLOAT3 Position;
+	short Normal[2];
+	unsigned short Uv[2];
+};
+
+// PBR.shader's ObjectBuffer for the non-instanced path. World is transposed for the shader.
+struct ObjectBufferType
+{
+	DirectX::XMMATRIX World;
+	DirectX::XMFLOAT4 Colour;
+};
+
+// Models drawn and skipped by frustum culling in the last frame.
+struct CullingStats
+{
+	int Visible;
+	int Culled;
+};
+
 struct MeshData
 {
 	PosUvVertexType* PosUvVertexData;
 	FullVertexType* FullVertexData;
-	unsigned long* IndexData;
+	// unsigned short indices when ShortIndices is set, otherwise unsigned long.
+	void* IndexData;
+	bool ShortIndices;
 };
 
 class Graphics
@@ -47,19 +92,96 @@ public:
 	~Graphics();
 
 	bool Initialise(int screenWidth, int screenHeight, HWND__* hwnd, Input* input);
-	bool Frame() const;
-	bool Render() const;
+	bool Frame();
+	bool Render();
+
+	CullingStats GetCullingStats() const;
+	// Whether models are drawn instanced or one draw each. F9 switches between the two.
+	bool IsInstanced() const;
+	// Bytes of constant buffer data uploaded by the last Render: the view and light constants when they changed, and
+	// every model's constants on the non-instanced path.
+	size_t GetConstantUploadBytes() const;
+	// Bytes of instance data uploaded by the last Render, which is where the instanced path's per-model data goes.
+	size_t GetInstanceUploadBytes() const;
+	// View and light constant uploads the last Render skipped because nothing had changed.
+	unsigned long long GetSkippedUploads() const;
+	// The state changes the last Render asked for, and how many of them the state caches forwarded and elided.
+	StateCacheStats GetStateStats() const;
 
 private:
+	// A run of instances in the instance buffer that share a mesh and LOD. Batches are indexed by
+	// mesh handle * Mesh::MaxLodCount + LOD.
+	struct ModelBatch
+	{
+		int StartInstance;
+		int InstanceCount;
+	};
+
+	// A command list and the state cache recording into it, with the range of _drawOrder it records this frame.
+	struct DrawRecorder
+	{
+		CommandList* List;
+		StateCache* Cache;
+		int First;
+		int Last;
+		bool Result;
+	};
+
+	// Below this many draws per list, recording in parallel costs more than it saves. The demo's 100 models go out
+	// over as many as 6 lists, one per core.
+	static const int MinDrawsPerList = 16;
+
+	void CullModels(DirectX::XMMATRIX worldMatrix);
+	// The stats of the device's state cache and every recorder's added together, since startup.
+	StateCacheStats GetStateTotals() const;
+	// Writes the mesh cache's stats and each mesh's optimiser stats to the debugger once the scene is loaded.
+	void LogMeshStats() const;
+	// Writes the render target pool's stats to the debugger once the skybox bake, its heaviest user, is done.
+	void LogRenderTargetStats() const;
+
+	// Binds the lighting and material textures every model is drawn with.
+	void BindSceneResources(StateCache* stateCache) const;
+	bool RenderModels(StateCache* stateCache, DirectX::XMMATRIX worldMatrix);
+	// Draws the models at _drawOrder[first, last).
+	bool RecordModelDraws(StateCache* stateCache, int first, int last) const;
+	bool RenderModelsInstanced(StateCache* stateCache, DirectX::XMMATRIX worldMatrix);
+
 	D3D* _pD3D;
 	Camera* _pCamera;
 	Skybox* _pSkybox;
-	FrameCBuffer* _pFrameBuffer;
-	ObjectCBuffer* _pObjectBuffer;
-	std::vector<Model*> _pModels;
+	ViewCBuffer* _pViewBuffer;
+	LightCBuffer* _pLightBuffer;
+	// The non-instanced path's per-model constants. Null if the device can't bind them by offset, which leaves only
+	// the instanced path.
+	ConstantRingBuffer* _pObjectBuffer;
+	std::vector<ConstantRange> _objectConstants;
+	// The visible entities in the order they are drawn, and one recorder per core when drawing in parallel.
+	std::vector<int> _drawOrder;
+	std::vector<DrawRecorder> _drawRecorders;
+	Scene* _pScene;
+	MeshCache* _pMeshCache;
+	InstanceBuffer* _pInstanceBuffer;
+	std::vector<InstanceType> _instances;
+	std::vector<ModelBatch> _batches;
+	// Per entity results of the last CullModels, in the scene's entity order.
+	std::vector<unsigned char> _visible;
+	std::vector<int> _lods;
+	std::vector<int> _batchIndices;
+	CullingStats _cullingStats;
+	size_t _constantUploadBytes;
+	size_t _instanceUploadBytes;
+	unsigned long long _skippedUploads;
+	StateCacheStats _stateStats;
+	bool _renderTargetStatsLogged;
+	// One shader per path, so the path can be switched without recompiling.
 	PBRShader* _pPBRShader;
+	PBRShader* _pInstancedShader;
+	bool _instancedModels;
+	bool _switchKeyDown;
 	Texture* _pNormal;
 	Texture* _pRoughness;
 	Texture* _pMetallic;
 	Input* _pInput;
+	// Shared by loading, the skybox bake and culling.
+	JobSystem* _pJobSystem;
 };
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Conversions between 32-bit floats and the 16-bit floats stored in our R16G16B16A16_FLOAT textures.
+// These are plain C++ so the CPU baker can produce identical texture data without a GPU.
+
+inline uint16_t FloatToHalf(const float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof bits);
+
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	const uint32_t exponent = (bits >> 23) & 0xFFu;
+	uint32_t mantissa = bits & 0x7FFFFFu;
+
+	// Infinity and NaN.
+	if (exponent == 0xFFu)
+	{
+		return uint16_t(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+	}
+
+	const int halfExponent = int(exponent) - 127 + 15;
+
+	// Too large, clamp to infinity.
+	if (halfExponent >= 31)
+	{
+		return uint16_t(sign | 0x7C00u);
+	}
+
+	// Too small for a normalised half, produce a denormal or zero.
+	if (halfExponent <= 0)
+	{
+		if (halfExponent < -10)
+		{
+			return uint16_t(sign);
+		}
+
+		mantissa |= 0x800000u;
+		const int shift = 14 - halfExponent;
+		uint32_t halfMantissa = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+		const uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u)))
+		{
+			++halfMantissa;
+		}
+
+		return uint16_t(sign | halfMantissa);
+	}
+
+	// Round to nearest even. A carry out of the mantissa correctly bumps the exponent.
+	uint32_t half = sign | (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+	const uint32_t remainder = mantissa & 0x1FFFu;
+	if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+	{
+		++half;
+	}
+
+	return uint16_t(half);
+}
+
+inline float HalfToFloat(const uint16_t value)
+{
+	const uint32_t sign = uint32_t(value & 0x8000u) << 16;
+	uint32_t exponent = (value >> 10) & 0x1Fu;
+	uint32_t mantissa = value & 0x3FFu;
+	uint32_t bits;
+
+	if (exponent == 0x1Fu)
+	{
+		// Infinity and NaN.
+		bits = sign | 0x7F800000u | (mantissa << 13);
+	}
+	else if (exponent == 0)
+	{
+		if (mantissa == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			// Renormalise the denormal.
+			exponent = 1;
+			while (!(mantissa & 0x400u))
+			{
+				mantissa <<= 1;
+				--exponent;
+			}
+
+			mantissa &= 0x3FFu;
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		}
+	}
+	else
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	float result;
+	std::memcpy(&result, &bits, sizeof result);
+	return result;
+}
@@ -0,0 +1,459 @@
+#include "IBLBaker.h"
+#include "CpuTexture.h"
+#include "SphericalHarmonics.h"
+#include "PreFilterSamples.h"
+#include "BrdfLut.h"
+#include "EquirectToCubemap.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	const float PI = 3.14159265359f;
+	const int TileSize = 32;
+
+	struct Float3
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	Float3 MakeFloat3(const float x, const float y, const float z)
+	{
+		Float3 result;
+		result.x = x;
+		result.y = y;
+		result.z = z;
+		return result;
+	}
+
+	Float3 Add(const Float3& a, const Float3& b)
+	{
+		return MakeFloat3(a.x + b.x, a.y + b.y, a.z + b.z);
+	}
+
+	Float3 Scale(const Float3& a, const float s)
+	{
+		return MakeFloat3(a.x * s, a.y * s, a.z * s);
+	}
+
+	float Dot(const Float3& a, const Float3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	Float3 Cross(const Float3& a, const Float3& b)
+	{
+		return MakeFloat3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	Float3 Normalise(const Float3& a)
+	{
+		const float length = std::sqrt(Dot(a, a));
+		return length > 0.0f ? Scale(a, 1.0f / length) : a;
+	}
+
+	// Direction through the centre of a cube face texel, matching the orientation Skybox::RenderFaces renders each face with.
+	Float3 GetCubeDirection(const int face, const int x, const int y, const int size)
+	{
+		const float u = 2.0f * (float(x) + 0.5f) / float(size) - 1.0f;
+		const float v = 2.0f * (float(y) + 0.5f) / float(size) - 1.0f;
+
+		switch (face)
+		{
+		case 0: return Normalise(MakeFloat3(1.0f, -v, -u));
+		case 1: return Normalise(MakeFloat3(-1.0f, -v, u));
+		case 2: return Normalise(MakeFloat3(u, 1.0f, v));
+		case 3: return Normalise(MakeFloat3(u, -1.0f, -v));
+		case 4: return Normalise(MakeFloat3(u, -v, 1.0f));
+		default: return Normalise(MakeFloat3(-u, -v, -1.0f));
+		}
+	}
+
+	// Bilinear fetch with either wrapped or clamped addressing, returning RGB.
+	Float3 SampleBilinear(const float* pixels, const int width, const int height, float u, float v, const bool wrap)
+	{
+		const float x = u * float(width) - 0.5f;
+		const float y = v * float(height) - 0.5f;
+		const float fx = std::floor(x);
+		const float fy = std::floor(y);
+		const float tx = x - fx;
+		const float ty = y - fy;
+
+		int x0 = int(fx);
+		int y0 = int(fy);
+		int x1 = x0 + 1;
+		int y1 = y0 + 1;
+
+		if (wrap)
+		{
+			x0 = ((x0 % width) + width) % width;
+			x1 = ((x1 % width) + width) % width;
+			y0 = ((y0 % height) + height) % height;
+			y1 = ((y1 % height) + height) % height;
+		}
+		else
+		{
+			x0 = std::min(std::max(x0, 0), width - 1);
+			x1 = std::min(std::max(x1, 0), width - 1);
+			y0 = std::min(std::max(y0, 0), height - 1);
+			y1 = std::min(std::max(y1, 0), height - 1);
+		}
+
+		const float* p00 = pixels + (size_t(y0) * width + x0) * CpuTexture::ChannelCount;
+		const float* p10 = pixels + (size_t(y0) * width + x1) * CpuTexture::ChannelCount;
+		const float* p01 = pixels + (size_t(y1) * width + x0) * CpuTexture::ChannelCount;
+		const float* p11 = pixels + (size_t(y1) * width + x1) * CpuTexture::ChannelCount;
+
+		const float w00 = (1.0f - tx) * (1.0f - ty);
+		const float w10 = tx * (1.0f - ty);
+		const float w01 = (1.0f - tx) * ty;
+		const float w11 = tx * ty;
+
+		return MakeFloat3(p00[0] * w00 + p10[0] * w10 + p01[0] * w01 + p11[0] * w11,
+		                  p00[1] * w00 + p10[1] * w10 + p01[1] * w01 + p11[1] * w11,
+		                  p00[2] * w00 + p10[2] * w10 + p01[2] * w01 + p11[2] * w11);
+	}
+
+	// Equivalent of TextureCube::Sample with a linear filter. Faces are filtered independently and clamped at their edges.
+	Float3 SampleCube(const CpuTexture& cubemap, const int mip, const Float3& direction)
+	{
+		const float ax = std::fabs(direction.x);
+		const float ay = std::fabs(direction.y);
+		const float az = std::fabs(direction.z);
+
+		int face;
+		float sc, tc, ma;
+		if (ax >= ay && ax >= az)
+		{
+			face = direction.x >= 0.0f ? 0 : 1;
+			sc = direction.x >= 0.0f ? -direction.z : direction.z;
+			tc = -direction.y;
+			ma = ax;
+		}
+		else if (ay >= az)
+		{
+			face = direction.y >= 0.0f ? 2 : 3;
+			sc = direction.x;
+			tc = direction.y >= 0.0f ? direction.z : -direction.z;
+			ma = ay;
+		}
+		else
+		{
+			face = direction.z >= 0.0f ? 4 : 5;
+			sc = direction.z >= 0.0f ? direction.x : -direction.x;
+			tc = -direction.y;
+			ma = az;
+		}
+
+		const float u = 0.5f * (sc / ma + 1.0f);
+		const float v = 0.5f * (tc / ma + 1.0f);
+
+		return SampleBilinear(cubemap.GetPixels(face, mip), cubemap.GetWidth(mip), cubemap.GetHeight(mip), u, v, false);
+	}
+
+	// Equivalent of TextureCube::SampleLevel with a trilinear filter.
+	Float3 SampleCubeLevel(const CpuTexture& cubemap, float lod, const Float3& direction)
+	{
+		lod = std::min(std::max(lod, 0.0f), float(cubemap.GetMipLevels() - 1));
+		const int mip0 = int(lod);
+		const int mip1 = std::min(mip0 + 1, cubemap.GetMipLevels() - 1);
+		const float t = lod - float(mip0);
+
+		const Float3 colour0 = SampleCube(cubemap, mip0, direction);
+		if (t <= 0.0f || mip1 == mip0)
+		{
+			return colour0;
+		}
+
+		return Add(Scale(colour0, 1.0f - t), Scale(SampleCube(cubemap, mip1, direction), t));
+	}
+
+	// Builds the full mip chain of a cubemap with a 2x2 box filter, the same as ID3D11DeviceContext::GenerateMips.
+	void CreateMipChain(const CpuTexture& source, CpuTexture& pyramid)
+	{
+		const int size = source.GetWidth();
+		int mipLevels = 1;
+		while ((size >> mipLevels) > 0)
+		{
+			++mipLevels;
+		}
+
+		pyramid.Initialise(size, size, mipLevels, source.GetArraySize());
+		for (int face = 0; face < source.GetArraySize(); ++face)
+		{
+			std::copy(source.GetPixels(face, 0),
+			          source.GetPixels(face, 0) + size_t(size) * size * CpuTexture::ChannelCount,
+			          pyramid.GetPixels(face, 0));
+
+			for (int mip = 1; mip < mipLevels; ++mip)
+			{
+				const int parentSize = pyramid.GetWidth(mip - 1);
+				const int mipSize = pyramid.GetWidth(mip);
+				const float* parent = pyramid.GetPixels(face, mip - 1);
+				float* pixels = pyramid.GetPixels(face, mip);
+
+				for (int y = 0; y < mipSize; ++y)
+				{
+					for (int x = 0; x < mipSize; ++x)
+					{
+						const float* p00 = parent + (size_t(y * 2) * parentSize + x * 2) * CpuTexture::ChannelCount;
+						const float* p01 = p00 + size_t(parentSize) * CpuTexture::ChannelCount;
+						float* pixel = pixels + (size_t(y) * mipSize + x) * CpuTexture::ChannelCount;
+
+						for (int channel = 0; channel < CpuTexture::ChannelCount; ++channel)
+						{
+							pixel[channel] = 0.25f * (p00[channel] + p00[channel + CpuTexture::ChannelCount] + p01[channel] +
+							                          p01[channel + CpuTexture::ChannelCount]);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Tangent frame used by ImportanceSampleGGX in the shaders.
+	void GetTangentFrame(const Float3& normal, Float3& tangent, Float3& bitangent)
+	{
+		const Float3 up = std::fabs(normal.z) < 0.999f ? MakeFloat3(0.0f, 0.0f, 1.0f) : MakeFloat3(1.0f, 0.0f, 0.0f);
+		tangent = Normalise(Cross(up, normal));
+		bitangent = Cross(normal, tangent);
+	}
+
+	Float3 ToWorld(const Float3& sample, const Float3& tangent, const Float3& bitangent, const Float3& normal)
+	{
+		return Add(Add(Scale(tangent, sample.x), Scale(bitangent, sample.y)), Scale(normal, sample.z));
+	}
+
+	void WritePixel(float* pixel, const Float3& colour, const float alpha)
+	{
+		pixel[0] = colour.x;
+		pixel[1] = colour.y;
+		pixel[2] = colour.z;
+		pixel[3] = alpha;
+	}
+}
+
+IBLBaker::IBLBaker()
+{
+	_pJobs = nullptr;
+}
+
+IBLBaker::~IBLBaker()
+{
+}
+
+void IBLBaker::Initialise(const IBLBakeSettings& settings, JobSystem* jobs)
+{
+	_settings = settings;
+	_pJobs = jobs;
+}
+
+void IBLBaker::RunTiles(const CpuTexture& target, const TileFunction& function) const
+{
+	struct Tile
+	{
+		int Slice;
+		int Mip;
+		int X0;
+		int Y0;
+		int X1;
+		int Y1;
+	};
+
+	// Split every face of every mip into tiles so small mips don't leave workers idle.
+	std::vector<Tile> tiles;
+	for (int slice = 0; slice < target.GetArraySize(); ++slice)
+	{
+		for (int mip = 0; mip < target.GetMipLevels(); ++mip)
+		{
+			const int width = target.GetWidth(mip);
+			const int height = target.GetHeight(mip);
+			for (int y = 0; y < height; y += TileSize)
+			{
+				for (int x = 0; x < width; x += TileSize)
+				{
+					Tile tile;
+					tile.Slice = slice;
+					tile.Mip = mip;
+					tile.X0 = x;
+					tile.Y0 = y;
+					tile.X1 = std::min(x + TileSize, width);
+					tile.Y1 = std::min(y + TileSize, height);
+					tiles.push_back(tile);
+				}
+			}
+		}
+	}
+
+	_pJobs->ParallelFor(int(tiles.size()), 1, [&](const int first, const int last)
+	{
+		for (int i = first; i < last; ++i)
+		{
+			PROFILE_ZONE("IBLBaker tile");
+			const Tile& tile = tiles[i];
+			function(tile.Slice, tile.Mip, tile.X0, tile.Y0, tile.X1, tile.Y1);
+		}
+	});
+}
+
+void IBLBaker::CreateEnvironmentMap(const CpuTexture& equirect, CpuTexture& cubemap) const
+{
+	PROFILE_ZONE("IBLBaker::CreateEnvironmentMap");
+
+	// RectToCubemap.shader
+	EquirectToCubemap::Convert(equirect, _settings.SkyboxSize, *_pJobs, cubemap);
+}
+
+void IBLBaker::CreateIrradianceMap(const CpuTexture& cubemap, CpuTexture& irradiance) const
+{
+	PROFILE_ZONE("IBLBaker::CreateIrradianceMap");
+
+	const int size = _settings.IrradianceSize;
+	if (_settings.Irradiance == IrradianceMethod::SphericalHarmonics)
+	{
+		SHCoefficients radiance, convolved;
+		SphericalHarmonics::ProjectCubemap(cubemap, 0, *_pJobs, radiance);
+		SphericalHarmonics::ConvolveIrradiance(radiance, convolved);
+		SphericalHarmonics::CreateIrradianceMap(convolved, size, irradiance);
+		return;
+	}
+
+	irradiance.Initialise(size, size, 1, 6);
+
+	// Irradiance.shader walks the hemisphere in fixed steps. The step sequence (and therefore the sample count) is
+	// reproduced exactly, including the float accumulation, and the tangent space samples are computed once up front.
+	struct HemisphereSample
+	{
+		Float3 Direction;
+		float Weight;
+	};
+
+	std::vector<HemisphereSample> samples;
+	const float sampleDelta = _settings.IrradianceSampleDelta;
+	for (float phi = 0.0f; phi < 2.0f * PI; phi += sampleDelta)
+	{
+		for (float theta = 0.0f; theta < 0.5f * PI; theta += sampleDelta)
+		{
+			HemisphereSample sample;
+			sample.Direction = MakeFloat3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+			sample.Weight = std::cos(theta) * std::sin(theta);
+			samples.push_back(sample);
+		}
+	}
+
+	const float scale = PI / float(samples.size());
+
+	RunTiles(irradiance, [&](const int face, const int mip, const int x0, const int y0, const int x1, const int y1)
+	{
+		float* pixels = irradiance.GetPixels(face, mip);
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = x0; x < x1; ++x)
+			{
+				// The shader builds its basis from an unnormalised position. Normalising here keeps the same
+				// orientation while giving the evenly weighted hemisphere the math describes.
+				const Float3 normal = GetCubeDirection(face, x, y, size);
+				const Float3 right = Normalise(Cross(MakeFloat3(0.0f, 1.0f, 0.0f), normal));
+				const Float3 up = Cross(normal, right);
+
+				Float3 sum = MakeFloat3(0.0f, 0.0f, 0.0f);
+				for (size_t i = 0; i < samples.size(); ++i)
+				{
+					const HemisphereSample& sample = samples[i];
+					const Float3 sampleVec = ToWorld(sample.Direction, right, up, normal);
+					sum = Add(sum, Scale(SampleCube(cubemap, 0, sampleVec), sample.Weight));
+				}
+
+				WritePixel(pixels + (size_t(y) * size + x) * CpuTexture::ChannelCount, Scale(sum, scale), 1.0f);
+			}
+		}
+	});
+}
+
+void IBLBaker::CreatePreFilterMap(const CpuTexture& cubemap, CpuTexture& preFilter) const
+{
+	PROFILE_ZONE("IBLBaker::CreatePreFilterMap");
+
+	const int size = _settings.PreFilterSize;
+	const int mipLevels = _settings.PreFilterMipLevels;
+	const int sampleCount = _settings.PreFilterSampleCount;
+	preFilter.Initialise(size, size, mipLevels, 6);
+
+	// Filtered importance sampling reads from a mip pyramid of the source, so far fewer samples are needed.
+	const bool filtered = _settings.PreFilter == PreFilterMethod::FilteredImportanceSampling;
+	CpuTexture pyramid;
+	if (filtered)
+	{
+		CreateMipChain(cubemap, pyramid);
+	}
+
+	const CpuTexture& source = filtered ? pyramid : cubemap;
+
+	// PreFilter.shader sets N = V = R, so the sample set only depends on the roughness of each mip. The tables are
+	// the same ones Skybox uploads for the shader.
+	std::vector<std::vector<PreFilterSample>> mipSamples(mipLevels);
+	for (int mip = 0; mip < mipLevels; ++mip)
+	{
+		const float roughness = mipLevels > 1 ? float(mip) / float(mipLevels - 1) : 0.0f;
+		PreFilterSamples::Generate(roughness, sampleCount, filtered ? cubemap.GetWidth() : 0, mipSamples[mip]);
+	}
+
+	RunTiles(preFilter, [&](const int face, const int mip, const int x0, const int y0, const int x1, const int y1)
+	{
+		const int mipSize = preFilter.GetWidth(mip);
+		const std::vector<PreFilterSample>& samples = mipSamples[mip];
+		float* pixels = preFilter.GetPixels(face, mip);
+
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = x0; x < x1; ++x)
+			{
+				const Float3 N = GetCubeDirection(face, x, y, mipSize);
+				Float3 tangent, bitangent;
+				GetTangentFrame(N, tangent, bitangent);
+
+				Float3 colour = MakeFloat3(0.0f, 0.0f, 0.0f);
+				float totalWeight = 0.0f;
+				for (size_t i = 0; i < samples.size(); ++i)
+				{
+					const PreFilterSample& sample = samples[i];
+					const float NdotL = sample.z;
+					const Float3 L = ToWorld(MakeFloat3(sample.x, sample.y, sample.z), tangent, bitangent, N);
+					colour = Add(colour, Scale(SampleCubeLevel(source, sample.Lod, L), NdotL));
+					totalWeight += NdotL;
+				}
+
+				WritePixel(pixels + (size_t(y) * mipSize + x) * CpuTexture::ChannelCount, Scale(colour, 1.0f / totalWeight),
+				           1.0f);
+			}
+		}
+	});
+}
+
+void IBLBaker::CreateBrdfLUT(CpuTexture& brdfLut) const
+{
+	PROFILE_ZONE("IBLBaker::CreateBrdfLUT");
+
+	const int size = _settings.BrdfLookupSize;
+	const int sampleCount = _settings.BrdfSampleCount;
+	brdfLut.Initialise(size, size, 1, 1);
+
+	// IntegrateBRDF.shader. Texels are laid out the way PBR.shader samples the LUT: u = NdotV, v = roughness.
+	std::vector<float> scaleBias;
+	BrdfLut::Generate(size, sampleCount, *_pJobs, scaleBias);
+
+	float* pixels = brdfLut.GetPixels(0, 0);
+	for (size_t i = 0; i < size_t(size) * size; ++i)
+	{
+		pixels[i * CpuTexture::ChannelCount + 0] = scaleBias[i * 2 + 0];
+		pixels[i * CpuTexture::ChannelCount + 1] = scaleBias[i * 2 + 1];
+		pixels[i * CpuTexture::ChannelCount + 2] = 0.0f;
+		pixels[i * CpuTexture::ChannelCount + 3] = 1.0f;
+	}
+}
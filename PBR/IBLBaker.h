@@ -0,0 +1,63 @@
+#pragma once
+
+#include <functional>
+
+class CpuTexture;
+class JobSystem;
+
+// How the diffuse irradiance map is produced.
+enum class IrradianceMethod
+{
+	// Brute force hemisphere integration per texel, as Irradiance.shader does.
+	Convolution,
+	// Projection onto nine spherical harmonic coefficients, then evaluated per texel.
+	SphericalHarmonics
+};
+
+// How the pre-filtered specular map is integrated.
+enum class PreFilterMethod
+{
+	// Every sample reads the top level of the source cubemap, as PreFilter.shader originally did.
+	ImportanceSampling,
+	// Samples read a mip of the source chosen from the GGX pdf, which needs 32 to 64 samples rather than 1024.
+	FilteredImportanceSampling
+};
+
+struct IBLBakeSettings
+{
+	int SkyboxSize = 2048;
+	int IrradianceSize = 32;
+	int PreFilterSize = 256;
+	int PreFilterMipLevels = 5;
+	int BrdfLookupSize = 512;
+	IrradianceMethod Irradiance = IrradianceMethod::Convolution;
+	float IrradianceSampleDelta = 0.025f;
+	PreFilterMethod PreFilter = PreFilterMethod::ImportanceSampling;
+	int PreFilterSampleCount = 1024;
+	int BrdfSampleCount = 1024;
+};
+
+// CPU implementation of the image based lighting bake Skybox performs on the GPU.
+// Each stage follows the math of the matching .shader file and writes cube faces in D3D11 order (+X, -X, +Y, -Y, +Z, -Z).
+// Work is split into per-face, per-tile jobs that run on the job system passed to Initialise.
+class IBLBaker
+{
+public:
+	IBLBaker();
+	~IBLBaker();
+
+	void Initialise(const IBLBakeSettings& settings, JobSystem* jobs);
+
+	void CreateEnvironmentMap(const CpuTexture& equirect, CpuTexture& cubemap) const;
+	void CreateIrradianceMap(const CpuTexture& cubemap, CpuTexture& irradiance) const;
+	void CreatePreFilterMap(const CpuTexture& cubemap, CpuTexture& preFilter) const;
+	void CreateBrdfLUT(CpuTexture& brdfLut) const;
+
+private:
+	typedef std::function<void(int slice, int mip, int x0, int y0, int x1, int y1)> TileFunction;
+
+	void RunTiles(const CpuTexture& target, const TileFunction& function) const;
+
+	IBLBakeSettings _settings;
+	JobSystem* _pJobs;
+};
@@ -0,0 +1,356 @@
+#include "IBLCache.h"
+#include "IBLBaker.h"
+#include "DDSFile.h"
+#include "Cubemap.h"
+#include "Texture.h"
+#include "JobSystem.h"
+#include <d3d11.h>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	// Bump whenever the bake output changes in a way the settings don't capture.
+	const uint32_t CacheVersion = 1;
+
+	const wchar_t* CacheDirectory = L"IBLCache";
+
+	// Enough to finish the default bake's readback in a few dozen frames while keeping each frame's copy short.
+	const size_t ReadbackBytesPerFrame = 16 << 20;
+
+	const uint64_t FnvOffsetBasis = 14695981039346656037ull;
+	const uint64_t FnvPrime = 1099511628211ull;
+
+	uint64_t HashBytes(uint64_t hash, const void* data, const size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= FnvPrime;
+		}
+
+		return hash;
+	}
+
+	template <typename T>
+	uint64_t HashValue(const uint64_t hash, const T& value)
+	{
+		return HashBytes(hash, &value, sizeof value);
+	}
+}
+
+IBLCache::IBLCache()
+{
+	_sourceHash = FnvOffsetBasis;
+	_saving = false;
+}
+
+IBLCache::~IBLCache()
+{
+	ReleaseStaging();
+}
+
+bool IBLCache::Initialise(const wchar_t* sourceFileName, const IBLBakeSettings& settings)
+{
+	std::ifstream file(Texture::GetFullPath(sourceFileName), std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	// Hash the source image.
+	uint64_t hash = FnvOffsetBasis;
+	std::vector<char> buffer(1 << 20);
+	while (file)
+	{
+		file.read(buffer.data(), std::streamsize(buffer.size()));
+		hash = HashBytes(hash, buffer.data(), size_t(file.gcount()));
+	}
+
+	_sourceHash = hash;
+	SetSettings(settings);
+	return true;
+}
+
+void IBLCache::SetSettings(const IBLBakeSettings& settings)
+{
+	// Everything that affects the output.
+	uint64_t hash = HashValue(_sourceHash, CacheVersion);
+	hash = HashValue(hash, settings.SkyboxSize);
+	hash = HashValue(hash, settings.IrradianceSize);
+	hash = HashValue(hash, settings.Irradiance);
+	hash = HashValue(hash, settings.PreFilterSize);
+	hash = HashValue(hash, settings.PreFilterMipLevels);
+	hash = HashValue(hash, settings.BrdfLookupSize);
+	hash = HashValue(hash, settings.IrradianceSampleDelta);
+	hash = HashValue(hash, settings.PreFilter);
+	hash = HashValue(hash, settings.PreFilterSampleCount);
+	hash = HashValue(hash, settings.BrdfSampleCount);
+
+	wchar_t key[17];
+	swprintf_s(key, L"%016llx", static_cast<unsigned long long>(hash));
+	_key = key;
+}
+
+std::wstring IBLCache::GetEntryName(const wchar_t* product) const
+{
+	return std::wstring(CacheDirectory) + L"\\" + _key + L"_" + product + L".dds";
+}
+
+bool IBLCache::Load(ID3D11Device* device, Cubemap* environment, Cubemap* irradiance, Cubemap* preFilter,
+                    Texture* brdfLut) const
+{
+	if (_key.empty())
+	{
+		return false;
+	}
+
+	if (!environment->Initialise(device, GetEntryName(L"environment").c_str()))
+	{
+		return false;
+	}
+
+	if (irradiance && !irradiance->Initialise(device, GetEntryName(L"irradiance").c_str()))
+	{
+		return false;
+	}
+
+	if (!preFilter->Initialise(device, GetEntryName(L"prefilter").c_str()))
+	{
+		return false;
+	}
+
+	return !brdfLut || brdfLut->Initialise(device, GetEntryName(L"brdf").c_str());
+}
+
+bool IBLCache::BeginSave(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11Texture2D* environment,
+                         ID3D11Texture2D* irradiance, ID3D11Texture2D* preFilter, ID3D11Texture2D* brdfLut)
+{
+	if (_key.empty() || _saving)
+	{
+		return false;
+	}
+
+	_pending.clear();
+	const bool queued = QueueTexture(device, context, environment, GetEntryName(L"environment")) &&
+		(!irradiance || QueueTexture(device, context, irradiance, GetEntryName(L"irradiance"))) &&
+		QueueTexture(device, context, preFilter, GetEntryName(L"prefilter")) &&
+		(!brdfLut || QueueTexture(device, context, brdfLut, GetEntryName(L"brdf")));
+
+	if (!queued)
+	{
+		ReleaseStaging();
+		_pending.clear();
+		return false;
+	}
+
+	_saving = true;
+	return true;
+}
+
+bool IBLCache::QueueTexture(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11Texture2D* texture,
+                            const std::wstring& fileName)
+{
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+
+	const DDSFormat format = DDSFormat(desc.Format);
+	const int texelSize = DDSFile::GetTexelSize(format);
+	if (texelSize == 0)
+	{
+		return false;
+	}
+
+	const bool cubemap = (desc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) != 0;
+
+	// Copy into a staging texture so the contents can be read back once the GPU gets to it.
+	D3D11_TEXTURE2D_DESC stagingDesc = desc;
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.BindFlags = 0;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	stagingDesc.MiscFlags = 0;
+
+	ID3D11Texture2D* staging;
+	const HRESULT result = device->CreateTexture2D(&stagingDesc, nullptr, &staging);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	context->CopyResource(staging, texture);
+
+	PendingTexture pending;
+	pending.FileName = fileName;
+	pending.Staging = staging;
+	pending.Width = int(desc.Width);
+	pending.Height = int(desc.Height);
+	pending.MipLevels = int(desc.MipLevels);
+	pending.ArraySize = int(desc.ArraySize);
+	pending.TexelSize = texelSize;
+	pending.NextSubresource = 0;
+	pending.NextRow = 0;
+
+	DDSFile::SerialiseHeader(pending.Data, pending.Width, pending.Height, pending.MipLevels, pending.ArraySize, format,
+	                         cubemap);
+
+	size_t payloadSize = 0;
+	for (int mip = 0; mip < pending.MipLevels; ++mip)
+	{
+		const int width = pending.Width >> mip > 0 ? pending.Width >> mip : 1;
+		const int height = pending.Height >> mip > 0 ? pending.Height >> mip : 1;
+		payloadSize += size_t(width) * height * texelSize;
+	}
+
+	pending.Data.reserve(pending.Data.size() + payloadSize * pending.ArraySize);
+	_pending.push_back(std::move(pending));
+	return true;
+}
+
+void IBLCache::UpdateSave(ID3D11DeviceContext* context, JobSystem& jobs, JobCounter& counter)
+{
+	if (!_saving)
+	{
+		return;
+	}
+
+	// D3D numbers subresources mip by mip within each face, the same order DDS files store them in.
+	size_t bytesRead = 0;
+	for (size_t i = 0; i < _pending.size(); ++i)
+	{
+		PendingTexture& texture = _pending[i];
+		const int subresourceCount = texture.MipLevels * texture.ArraySize;
+		while (texture.NextSubresource < subresourceCount)
+		{
+			if (bytesRead >= ReadbackBytesPerFrame)
+			{
+				return;
+			}
+
+			// Never wait on the GPU. If it hasn't finished the copy, try again next frame.
+			D3D11_MAPPED_SUBRESOURCE mappedResource;
+			const UINT subresource = UINT(texture.NextSubresource);
+			const HRESULT result = context->Map(texture.Staging, subresource, D3D11_MAP_READ,
+			                                    D3D11_MAP_FLAG_DO_NOT_WAIT, &mappedResource);
+			if (result == DXGI_ERROR_WAS_STILL_DRAWING)
+			{
+				return;
+			}
+
+			if (FAILED(result))
+			{
+				ReleaseStaging();
+				_pending.clear();
+				_saving = false;
+				return;
+			}
+
+			const int mip = texture.NextSubresource % texture.MipLevels;
+			const int width = texture.Width >> mip > 0 ? texture.Width >> mip : 1;
+			const int height = texture.Height >> mip > 0 ? texture.Height >> mip : 1;
+			const size_t rowSize = size_t(width) * texture.TexelSize;
+
+			const uint8_t* source = static_cast<const uint8_t*>(mappedResource.pData);
+			for (; texture.NextRow < height && bytesRead < ReadbackBytesPerFrame; ++texture.NextRow)
+			{
+				const uint8_t* row = source + size_t(texture.NextRow) * mappedResource.RowPitch;
+				texture.Data.insert(texture.Data.end(), row, row + rowSize);
+				bytesRead += rowSize;
+			}
+
+			context->Unmap(texture.Staging, subresource);
+
+			if (texture.NextRow == height)
+			{
+				texture.NextRow = 0;
+				++texture.NextSubresource;
+			}
+		}
+	}
+
+	// Everything is in system memory, so the GPU copies can go and the disk work moves off the frame.
+	ReleaseStaging();
+	_saving = false;
+	jobs.RunBackground([this]()
+	{
+		WriteFiles();
+	}, &counter);
+}
+
+bool IBLCache::IsSaving() const
+{
+	return _saving;
+}
+
+void IBLCache::ReleaseStaging()
+{
+	for (size_t i = 0; i < _pending.size(); ++i)
+	{
+		if (_pending[i].Staging)
+		{
+			_pending[i].Staging->Release();
+			_pending[i].Staging = nullptr;
+		}
+	}
+}
+
+void IBLCache::WriteFiles()
+{
+	CreateDirectoryW(Texture::GetFullPath(CacheDirectory).c_str(), nullptr);
+	RemoveStaleEntries();
+
+	for (size_t i = 0; i < _pending.size(); ++i)
+	{
+		if (!WriteEntry(_pending[i]))
+		{
+			break;
+		}
+	}
+
+	_pending.clear();
+	_pending.shrink_to_fit();
+}
+
+bool IBLCache::WriteEntry(const PendingTexture& texture)
+{
+	// Write to a temporary file first so an interrupted save never leaves a truncated entry behind.
+	const std::wstring fullPath = Texture::GetFullPath(texture.FileName.c_str());
+	const std::wstring tempPath = fullPath + L".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(texture.Data.data()), std::streamsize(texture.Data.size()));
+	file.close();
+
+	if (!file)
+	{
+		DeleteFileW(tempPath.c_str());
+		return false;
+	}
+
+	return MoveFileExW(tempPath.c_str(), fullPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+void IBLCache::RemoveStaleEntries() const
+{
+	const std::wstring directory = Texture::GetFullPath(CacheDirectory) + L"\\";
+
+	WIN32_FIND_DATAW findData;
+	const HANDLE find = FindFirstFileW((directory + L"*.dds").c_str(), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	// Anything not produced with the current key can never be loaded again.
+	do
+	{
+		const std::wstring name = findData.cFileName;
+		if (name.compare(0, _key.size(), _key) != 0)
+		{
+			DeleteFileW((directory + name).c_str());
+		}
+	}
+	while (FindNextFileW(find, &findData));
+
+	FindClose(find);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+struct ID3D11Texture2D;
+struct IBLBakeSettings;
+class Cubemap;
+class Texture;
+class JobSystem;
+class JobCounter;
+
+// On-disk cache of the baked image based lighting textures.
+// Entries are keyed by a hash of the source image and the bake settings, so changing either produces a new key and
+// the stale entry is replaced the next time the bake runs.
+// The irradiance map and BRDF lookup table are optional and skipped when null, for the modes that build them on the
+// CPU instead.
+class IBLCache
+{
+public:
+	IBLCache();
+	~IBLCache();
+
+	bool Initialise(const wchar_t* sourceFileName, const IBLBakeSettings& settings);
+	// Re-keys the cache for different settings without hashing the source again. Call before BeginSave.
+	void SetSettings(const IBLBakeSettings& settings);
+
+	bool Load(ID3D11Device* device, Cubemap* environment, Cubemap* irradiance, Cubemap* preFilter, Texture* brdfLut) const;
+
+	// Saving is spread over frames so it never stalls one. BeginSave queues GPU copies of the textures into staging
+	// memory. UpdateSave reads back whatever the GPU has finished, a few rows at a time, and once everything is read
+	// hands the file writes to a background job counted by counter. A failed save is dropped without an entry.
+	bool BeginSave(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11Texture2D* environment,
+	               ID3D11Texture2D* irradiance, ID3D11Texture2D* preFilter, ID3D11Texture2D* brdfLut);
+	void UpdateSave(ID3D11DeviceContext* context, JobSystem& jobs, JobCounter& counter);
+	bool IsSaving() const;
+
+private:
+	// A texture on its way to disk. Data holds the DDS header, then each subresource's rows as they are read back.
+	struct PendingTexture
+	{
+		std::wstring FileName;
+		ID3D11Texture2D* Staging;
+		int Width;
+		int Height;
+		int MipLevels;
+		int ArraySize;
+		int TexelSize;
+		int NextSubresource;
+		int NextRow;
+		std::vector<uint8_t> Data;
+	};
+
+	bool QueueTexture(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11Texture2D* texture,
+	                  const std::wstring& fileName);
+	void ReleaseStaging();
+	void WriteFiles();
+	static bool WriteEntry(const PendingTexture& texture);
+	void RemoveStaleEntries() const;
+	std::wstring GetEntryName(const wchar_t* product) const;
+
+	// The hash of the source image, which the settings are added to for the key.
+	uint64_t _sourceHash;
+	std::wstring _key;
+	// Only touched by the write job once reading back has finished.
+	std::vector<PendingTexture> _pending;
+	bool _saving;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Hammersley and GGX sampling shared by the CPU bake. Matches the functions of the same name in the bake shaders.
+
+inline float RadicalInverseVdC(uint32_t bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return float(bits) * 2.3283064365386963e-10f;
+}
+
+// GGX distributed half vector for Hammersley point i of sampleCount, in tangent space (N = +Z).
+inline void ImportanceSampleGGX(const int i, const int sampleCount, const float roughness, float& x, float& y, float& z)
+{
+	const float a = roughness * roughness;
+	const float xiX = float(i) / float(sampleCount);
+	const float xiY = RadicalInverseVdC(uint32_t(i));
+
+	const float phi = 2.0f * 3.14159265359f * xiX;
+	const float cosTheta = std::sqrt((1.0f - xiY) / (1.0f + (a * a - 1.0f) * xiY));
+	const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+
+	x = std::cos(phi) * sinTheta;
+	y = std::sin(phi) * sinTheta;
+	z = cosTheta;
+}
@@ -0,0 +1,87 @@
+#include "InstanceBuffer.h"
+#include "StateCache.h"
+#include <d3d11.h>
+#include <cstring>
+
+InstanceBuffer::InstanceBuffer()
+{
+	_pBuffer = nullptr;
+	_capacity = 0;
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	if (_pBuffer)
+	{
+		_pBuffer->Release();
+		_pBuffer = nullptr;
+	}
+}
+
+bool InstanceBuffer::Initialise(ID3D11Device* device, const int capacity)
+{
+	if (_pBuffer)
+	{
+		_pBuffer->Release();
+		_pBuffer = nullptr;
+	}
+
+	D3D11_BUFFER_DESC bufferDesc;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = sizeof(InstanceType) * capacity;
+	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	const HRESULT result = device->CreateBuffer(&bufferDesc, nullptr, &_pBuffer);
+	if (FAILED(result))
+	{
+		_capacity = 0;
+		return false;
+	}
+
+	_capacity = capacity;
+	return true;
+}
+
+bool InstanceBuffer::Update(ID3D11Device* device, StateCache* stateCache, const InstanceType* instances,
+                            const int count)
+{
+	if (count == 0)
+	{
+		return true;
+	}
+
+	// Grow geometrically so a slowly growing scene doesn't reallocate every frame.
+	if (count > _capacity)
+	{
+		int capacity = _capacity > 0 ? _capacity : 1;
+		while (capacity < count)
+		{
+			capacity *= 2;
+		}
+
+		if (!Initialise(device, capacity))
+		{
+			return false;
+		}
+	}
+
+	void* data = stateCache->Map(_pBuffer, sizeof(InstanceType) * count);
+	if (!data)
+	{
+		return false;
+	}
+
+	std::memcpy(data, instances, sizeof(InstanceType) * count);
+
+	stateCache->Unmap(_pBuffer);
+
+	return true;
+}
+
+void InstanceBuffer::Bind(StateCache* stateCache, const int slot) const
+{
+	stateCache->SetVertexBuffer(slot, _pBuffer, sizeof(InstanceType), 0);
+}
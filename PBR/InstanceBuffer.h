@@ -0,0 +1,35 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+struct ID3D11Device;
+struct ID3D11Buffer;
+class StateCache;
+
+// Per-instance data read by the instanced PBR.shader vertex shader. World is stored untransposed, one row per
+// WORLD semantic.
+struct InstanceType
+{
+	XMFLOAT4X4 World;
+	XMFLOAT4 Colour;
+};
+
+// A dynamic vertex buffer holding every instance drawn in a frame. It is written with one map per frame and grows
+// when a frame needs more instances than it holds.
+class InstanceBuffer
+{
+public:
+	InstanceBuffer();
+	~InstanceBuffer();
+
+	bool Initialise(ID3D11Device* device, int capacity);
+	bool Update(ID3D11Device* device, StateCache* stateCache, const InstanceType* instances, int count);
+
+	void Bind(StateCache* stateCache, int slot) const;
+
+private:
+	ID3D11Buffer* _pBuffer;
+	int _capacity;
+};
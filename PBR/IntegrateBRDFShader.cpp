@@ -1,4 +1,5 @@
 #include "IntegrateBRDFShader.h"
+#include "StateCache.h"
 #include <D3Dcompiler.h>
 #include "CBuffer.h"
 #include <d3d11.h>
@@ -35,15 +36,15 @@ bool IntegrateBRDFShader::Initialise(ID3D11Device* device, const HWND hwnd)
 	return LoadShader(device, hwnd, L"IntegrateBRDF.shader", polygonLayout, 2);
 }
 
-bool IntegrateBRDFShader::Render(ID3D11DeviceContext* deviceContext, const int indexCount, CBuffer* frameBuffer) const
+bool IntegrateBRDFShader::Render(StateCache* stateCache, const int indexCount, CBuffer* viewBuffer) const
 {
-	ID3D11Buffer* frameBuff = frameBuffer->GetBuffer();
+	ID3D11Buffer* viewBuff = viewBuffer->GetBuffer();
 
 	// Finanly set the constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(0, 1, &frameBuff);
+	stateCache->SetConstantBuffer(ShaderStage::Vertex, 0, viewBuff);
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(stateCache, indexCount);
 
 	return true;
 }
@@ -13,5 +13,5 @@ public:
 	virtual ~IntegrateBRDFShader();
 
 	bool Initialise(ID3D11Device* device, HWND__* hwnd) override;
-	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, CBuffer* frameBuffer) const;
+	bool Render(StateCache* stateCache, int indexCount, CBuffer* viewBuffer) const;
 };
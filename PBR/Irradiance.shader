@@ -1,11 +1,8 @@
-cbuffer FrameBuffer
+cbuffer ViewBuffer
 {
 	matrix viewMatrix;
 	matrix projectionMatrix;
-	float4 lightPositions[4];
-	float4 lightColours[4];
 	float4 camPos;
-	float4 customData;
 };
 
 struct VertexInputType
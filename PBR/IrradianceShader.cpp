@@ -1,4 +1,5 @@
 #include "IrradianceShader.h"
+#include "StateCache.h"
 #include <D3Dcompiler.h>
 #include "CBuffer.h"
 #include <d3d11.h>
@@ -62,16 +63,16 @@ bool IrradianceShader::Initialise(ID3D11Device* device, const HWND hwnd)
 	return !FAILED(result);
 }
 
-bool IrradianceShader::Render(ID3D11DeviceContext* deviceContext, const int indexCount, CBuffer* frameBuffer) const
+bool IrradianceShader::Render(StateCache* stateCache, const int indexCount, CBuffer* viewBuffer) const
 {
-	ID3D11Buffer* frameBuff = frameBuffer->GetBuffer();
+	ID3D11Buffer* viewBuff = viewBuffer->GetBuffer();
 
 	// Finanly set the constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(0, 1, &frameBuff);
-	deviceContext->PSSetSamplers(0, 1, &_pSampler);
+	stateCache->SetConstantBuffer(ShaderStage::Vertex, 0, viewBuff);
+	stateCache->SetSampler(ShaderStage::Pixel, 0, _pSampler);
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(stateCache, indexCount);
 
 	return true;
 }
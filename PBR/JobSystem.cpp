@@ -0,0 +1,373 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <string>
+
+namespace
+{
+	// The scheduler and worker index of the current thread, or -1 on threads that aren't workers.
+	thread_local const JobSystem* CurrentSystem = nullptr;
+	thread_local int CurrentWorker = -1;
+}
+
+JobCounter::JobCounter()
+{
+	_count = 0;
+}
+
+JobCounter::~JobCounter()
+{
+}
+
+bool JobCounter::IsDone() const
+{
+	return _count.load() == 0;
+}
+
+JobSystem::JobSystem()
+{
+	_pWorkers = nullptr;
+	_threadCount = 0;
+	_queuedCount = 0;
+	_backgroundCount = 0;
+	_nextWorker = 0;
+	_stopping = false;
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+void JobSystem::Initialise(int threadCount)
+{
+	Shutdown();
+
+	if (threadCount <= 0)
+	{
+		threadCount = int(std::thread::hardware_concurrency());
+	}
+
+	_threadCount = std::max(1, threadCount);
+	_pWorkers = new Worker[_threadCount];
+	_stopping = false;
+
+	CurrentSystem = this;
+	CurrentWorker = 0;
+
+	for (int i = 1; i < _threadCount; ++i)
+	{
+		_threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	if (!_pWorkers)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_stopping = true;
+	}
+
+	_wake.notify_all();
+
+	for (size_t i = 0; i < _threads.size(); ++i)
+	{
+		_threads[i].join();
+	}
+
+	_threads.clear();
+	delete[] _pWorkers;
+	_pWorkers = nullptr;
+	_threadCount = 0;
+
+	if (CurrentSystem == this)
+	{
+		CurrentSystem = nullptr;
+		CurrentWorker = -1;
+	}
+}
+
+int JobSystem::GetThreadCount() const
+{
+	return _threadCount;
+}
+
+void JobSystem::Run(const JobFunction& function, JobCounter* counter)
+{
+	if (counter)
+	{
+		++counter->_count;
+	}
+
+	Job job;
+	job.Function = function;
+	job.Counter = counter;
+	Push(job);
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, const JobFunction& function, JobCounter* counter)
+{
+	if (counter)
+	{
+		++counter->_count;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(dependency._mutex);
+		if (dependency._count.load() != 0)
+		{
+			JobCounter::DependentJob dependent;
+			dependent.Function = function;
+			dependent.Counter = counter;
+			dependency._dependents.push_back(dependent);
+			return;
+		}
+	}
+
+	Job job;
+	job.Function = function;
+	job.Counter = counter;
+	Push(job);
+}
+
+void JobSystem::RunBackground(const JobFunction& function, JobCounter* counter)
+{
+	if (counter)
+	{
+		++counter->_count;
+	}
+
+	if (_threadCount <= 1)
+	{
+		function();
+		Finish(counter);
+		return;
+	}
+
+	Job job;
+	job.Function = function;
+	job.Counter = counter;
+
+	{
+		std::lock_guard<std::mutex> lock(_backgroundMutex);
+		_backgroundJobs.push_back(std::move(job));
+	}
+
+	++_backgroundCount;
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+	}
+
+	_wake.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (counter._count.load() != 0)
+	{
+		if (!TryRunJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// The last job's Finish may still be leaving the counter's lock, so wait for it before the counter can go.
+	std::lock_guard<std::mutex> lock(counter._mutex);
+}
+
+void JobSystem::ParallelFor(const int count, int grainSize, const RangeFunction& function)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	grainSize = std::max(1, grainSize);
+	if (count <= grainSize || _threadCount <= 1)
+	{
+		for (int first = 0; first < count; first += grainSize)
+		{
+			function(first, std::min(first + grainSize, count));
+		}
+
+		return;
+	}
+
+	// Queue every range but the first, which the calling thread starts on straight away.
+	JobCounter counter;
+	for (int first = grainSize; first < count; first += grainSize)
+	{
+		const int last = std::min(first + grainSize, count);
+		Run([&function, first, last]()
+		{
+			function(first, last);
+		}, &counter);
+	}
+
+	function(0, grainSize);
+	Wait(counter);
+}
+
+void JobSystem::WorkerLoop(const int index)
+{
+	CurrentSystem = this;
+	CurrentWorker = index;
+	Profiler::SetThreadName(("Worker " + std::to_string(index)).c_str());
+
+	while (!_stopping)
+	{
+		// Short jobs first, as something may be waiting on them.
+		if (TryRunJob() || TryRunBackgroundJob())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_wake.wait(lock, [this]()
+		{
+			return _queuedCount.load() > 0 || _backgroundCount.load() > 0 || _stopping;
+		});
+	}
+}
+
+void JobSystem::Push(Job& job)
+{
+	// Workers keep their own jobs, other threads spread theirs round the workers.
+	const int index = CurrentSystem == this ? CurrentWorker : int(_nextWorker++ % unsigned(_threadCount));
+
+	{
+		Worker& worker = _pWorkers[index];
+		std::lock_guard<std::mutex> lock(worker.Mutex);
+		worker.Jobs.push_back(std::move(job));
+	}
+
+	++_queuedCount;
+
+	// Taking the lock orders this with a worker checking the queue count before it sleeps, so the wake isn't lost.
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+	}
+
+	_wake.notify_one();
+}
+
+bool JobSystem::TryRunJob()
+{
+	const int index = CurrentSystem == this ? CurrentWorker : -1;
+
+	Job job;
+	if (!PopJob(index, job) && !StealJob(index, job))
+	{
+		return false;
+	}
+
+	--_queuedCount;
+	job.Function();
+	Finish(job.Counter);
+	return true;
+}
+
+bool JobSystem::PopJob(const int index, Job& job)
+{
+	if (index < 0)
+	{
+		return false;
+	}
+
+	Worker& worker = _pWorkers[index];
+	std::lock_guard<std::mutex> lock(worker.Mutex);
+	if (worker.Jobs.empty())
+	{
+		return false;
+	}
+
+	job = std::move(worker.Jobs.back());
+	worker.Jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::StealJob(const int thief, Job& job)
+{
+	if (_queuedCount.load() <= 0)
+	{
+		return false;
+	}
+
+	// Start after the thief so workers don't all raid the same queue.
+	const int start = thief < 0 ? 0 : thief + 1;
+	for (int i = 0; i < _threadCount; ++i)
+	{
+		const int index = (start + i) % _threadCount;
+		if (index == thief)
+		{
+			continue;
+		}
+
+		Worker& worker = _pWorkers[index];
+		std::lock_guard<std::mutex> lock(worker.Mutex);
+		if (!worker.Jobs.empty())
+		{
+			job = std::move(worker.Jobs.front());
+			worker.Jobs.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::TryRunBackgroundJob()
+{
+	if (_backgroundCount.load() <= 0)
+	{
+		return false;
+	}
+
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(_backgroundMutex);
+		if (_backgroundJobs.empty())
+		{
+			return false;
+		}
+
+		job = std::move(_backgroundJobs.front());
+		_backgroundJobs.pop_front();
+	}
+
+	--_backgroundCount;
+	job.Function();
+	Finish(job.Counter);
+	return true;
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+	if (!counter)
+	{
+		return;
+	}
+
+	std::vector<JobCounter::DependentJob> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->_mutex);
+		if (--counter->_count == 0)
+		{
+			ready.swap(counter->_dependents);
+		}
+	}
+
+	for (size_t i = 0; i < ready.size(); ++i)
+	{
+		Job job;
+		job.Function = std::move(ready[i].Function);
+		job.Counter = ready[i].Counter;
+		Push(job);
+	}
+}
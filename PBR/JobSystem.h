@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::function<void()> JobFunction;
+typedef std::function<void(int first, int last)> RangeFunction;
+
+// Counts the unfinished jobs it was passed to, and holds jobs that were asked to run once they are all done.
+class JobCounter
+{
+public:
+	JobCounter();
+	~JobCounter();
+
+	bool IsDone() const;
+
+private:
+	friend class JobSystem;
+
+	struct DependentJob
+	{
+		JobFunction Function;
+		JobCounter* Counter;
+	};
+
+	std::atomic<int> _count;
+	std::mutex _mutex;
+	std::vector<DependentJob> _dependents;
+};
+
+// A work-stealing scheduler. Each worker pushes and pops jobs at the back of its own queue and, once that is empty,
+// steals from the front of the others', so jobs spawned by a job stay on the core that spawned them while the
+// oldest, usually largest, jobs are spread out.
+// The thread calling Initialise counts as one of the workers, but only runs jobs while it waits on a counter.
+// Jobs can be run from any thread. Plain C++, so it is shared by the renderer and PBRBake.
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	// Zero uses every available core.
+	void Initialise(int threadCount);
+	// Stops the worker threads. Every job must have finished.
+	void Shutdown();
+
+	int GetThreadCount() const;
+
+	// counter, when given, is counted up now and down again when the job has run.
+	void Run(const JobFunction& function, JobCounter* counter = nullptr);
+	// Queues the job once every job counted by dependency has finished.
+	void RunAfter(JobCounter& dependency, const JobFunction& function, JobCounter* counter = nullptr);
+	// For long jobs, such as a bake, that mustn't hold up a frame. Only the worker threads run them, when they have
+	// nothing else to do, so they are never picked up by a thread waiting on a counter. With no worker threads the job
+	// runs straight away on the calling thread.
+	void RunBackground(const JobFunction& function, JobCounter* counter = nullptr);
+	// Runs jobs on the calling thread until every job counted by counter has finished.
+	void Wait(JobCounter& counter);
+
+	// Calls function over [0, count) in ranges of at most grainSize, spread across every worker, and returns once
+	// they are all done. Ranges start at multiples of grainSize, so work can be divided by range as well as by index.
+	void ParallelFor(int count, int grainSize, const RangeFunction& function);
+
+private:
+	struct Job
+	{
+		JobFunction Function;
+		JobCounter* Counter;
+	};
+
+	// Padded so neighbouring workers' locks never share a cache line.
+	struct Worker
+	{
+		std::mutex Mutex;
+		std::deque<Job> Jobs;
+		char Padding[64];
+	};
+
+	void WorkerLoop(int index);
+	void Push(Job& job);
+	bool TryRunJob();
+	bool PopJob(int index, Job& job);
+	bool StealJob(int thief, Job& job);
+	bool TryRunBackgroundJob();
+	void Finish(JobCounter* counter);
+
+	Worker* _pWorkers;
+	int _threadCount;
+	std::vector<std::thread> _threads;
+	std::atomic<int> _queuedCount;
+	std::mutex _backgroundMutex;
+	std::deque<Job> _backgroundJobs;
+	std::atomic<int> _backgroundCount;
+	std::atomic<unsigned int> _nextWorker;
+	std::atomic<bool> _stopping;
+	std::mutex _sleepMutex;
+	std::condition_variable _wake;
+};
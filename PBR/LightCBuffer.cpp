@@ -0,0 +1,61 @@
+#include "LightCBuffer.h"
+#include "StateCache.h"
+#include "Profiler.h"
+#include <cstring>
+
+LightCBuffer::LightCBuffer()
+{
+	std::memset(&_data, 0, sizeof(_data));
+	_dirty = true;
+	_stats.Uploads = 0;
+	_stats.SkippedUploads = 0;
+	_stats.UploadBytes = 0;
+}
+
+LightCBuffer::~LightCBuffer()
+{
+}
+
+bool LightCBuffer::Initialise(ID3D11Device* device)
+{
+	return CBuffer::Initialise(device, sizeof(LightBufferType));
+}
+
+bool LightCBuffer::Update(StateCache* stateCache)
+{
+	PROFILE_ZONE("LightCBuffer::Update");
+
+	if (!_dirty)
+	{
+		++_stats.SkippedUploads;
+		return true;
+	}
+
+	// Lock the constant buffer so it can be written to.
+	void* dataPtr = stateCache->Map(_pBuffer, sizeof(_data));
+	if (!dataPtr)
+	{
+		return false;
+	}
+
+	std::memcpy(dataPtr, &_data, sizeof(_data));
+
+	stateCache->Unmap(_pBuffer);
+
+	_dirty = false;
+	++_stats.Uploads;
+	_stats.UploadBytes += sizeof(LightBufferType);
+	return true;
+}
+
+void LightCBuffer::SetLight(const int index, const XMFLOAT3 position, const XMFLOAT3 colour)
+{
+	_data.LightPositions[index] = XMFLOAT4(position.x, position.y, position.z, 0.0f);
+	_data.LightColours[index] = XMFLOAT4(colour.x, colour.y, colour.z, 0.0f);
+	_dirty = true;
+}
+
+CBufferStats LightCBuffer::GetStats() const
+{
+	return _stats;
+}
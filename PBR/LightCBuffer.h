@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CBuffer.h"
+
+const int LightCount = 4;
+
+struct LightBufferType
+{
+	XMFLOAT4 LightPositions[LightCount];
+	XMFLOAT4 LightColours[LightCount];
+};
+
+// The scene's point lights for PBR.shader. They rarely change, so Update only uploads after SetLight has changed
+// one since the last upload.
+class LightCBuffer : public CBuffer
+{
+public:
+	LightCBuffer();
+	virtual ~LightCBuffer();
+
+	bool Initialise(ID3D11Device* device) override;
+	bool Update(StateCache* stateCache);
+	void SetLight(int index, XMFLOAT3 position, XMFLOAT3 colour);
+
+	CBufferStats GetStats() const;
+
+private:
+	LightBufferType _data;
+	bool _dirty;
+	CBufferStats _stats;
+};
@@ -0,0 +1,142 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	_pData = nullptr;
+	_size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const char* fileName)
+{
+	Close();
+
+	// Other readers are fine, but writers are shut out while the file is mapped.
+	const HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                                FILE_ATTRIBUTE_NORMAL, nullptr);
+	return Map(file);
+}
+
+bool MappedFile::Open(const wchar_t* fileName)
+{
+	Close();
+
+	const HANDLE file = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                                FILE_ATTRIBUTE_NORMAL, nullptr);
+	return Map(file);
+}
+
+bool MappedFile::Map(void* file)
+{
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// The view holds its own references to the mapping and the file, so both handles can go straight away.
+	const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+	{
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!data)
+	{
+		return false;
+	}
+
+	_pData = static_cast<const uint8_t*>(data);
+	_size = size_t(size.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_pData)
+	{
+		UnmapViewOfFile(_pData);
+		_pData = nullptr;
+	}
+
+	_size = 0;
+}
+#else
+bool MappedFile::Open(const char* fileName)
+{
+	Close();
+
+	const int file = open(fileName, O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size <= 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// The mapping keeps the file open, so the descriptor can go straight away.
+	const size_t size = size_t(status.st_size);
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	// Loaders read the file front to back, so let the kernel read ahead.
+	posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+
+	_pData = static_cast<const uint8_t*>(data);
+	_size = size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_pData)
+	{
+		munmap(const_cast<uint8_t*>(_pData), _size);
+		_pData = nullptr;
+	}
+
+	_size = 0;
+}
+#endif
+
+const uint8_t* MappedFile::GetData() const
+{
+	return _pData;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return _size;
+}
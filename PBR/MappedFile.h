@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A read-only view of a whole file. The file is mapped rather than read, so it can be parsed in place without first
+// being copied to the heap, and pages are only read from disk as they are touched. Uses a file mapping on Windows and
+// mmap elsewhere, so it is shared by the renderer and PBRBake.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Fails on empty files, as they can't be mapped.
+	bool Open(const char* fileName);
+#ifdef _WIN32
+	bool Open(const wchar_t* fileName);
+#endif
+	void Close();
+
+	// Valid until Close, and only for reading.
+	const uint8_t* GetData() const;
+	size_t GetSize() const;
+
+private:
+#ifdef _WIN32
+	// Takes ownership of the file handle, which can be closed once the view exists.
+	bool Map(void* file);
+#endif
+
+	const uint8_t* _pData;
+	size_t _size;
+};
@@ -0,0 +1,238 @@
+#include "Mesh.h"
+#include "Shapes.h"
+#include "Graphics.h"
+#include "VertexPacking.h"
+#include "MeshArena.h"
+#include "MeshSimplifier.h"
+#include "StateCache.h"
+#include <cmath>
+#include <d3d11.h>
+
+using namespace DirectX;
+
+namespace
+{
+	template <typename Index>
+	void CopyIndices(const unsigned int* source, const int count, void* destination)
+	{
+		Index* typed = static_cast<Index*>(destination);
+		for (int i = 0; i < count; ++i)
+		{
+			typed[i] = Index(source[i]);
+		}
+	}
+}
+
+Mesh::Mesh()
+{
+	_pVertexBuffer = nullptr;
+	_pIndexBuffer = nullptr;
+	_vertexStride = 0;
+	_vertexCount = 0;
+	_indexCount = 0;
+	_shortIndices = false;
+	_optimiserStats = MeshOptimiserStats();
+	_boundingRadius = 0.0f;
+}
+
+Mesh::~Mesh()
+{
+	if (_pIndexBuffer)
+	{
+		_pIndexBuffer->Release();
+		_pIndexBuffer = nullptr;
+	}
+
+	if (_pVertexBuffer)
+	{
+		_pVertexBuffer->Release();
+		_pVertexBuffer = nullptr;
+	}
+}
+
+bool Mesh::InitialiseSphere(ID3D11Device* device, MeshArena& arena, const float radius, const int sliceCount,
+                            const int stackCount)
+{
+	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
+	D3D11_SUBRESOURCE_DATA vertexData, indexData;
+
+	MeshData meshData;
+
+	int baseIndexCount;
+	Shapes::CreateSphere(arena, meshData, radius, sliceCount, stackCount, _vertexCount, baseIndexCount);
+	MeshOptimiser::Optimise(meshData, _vertexCount, baseIndexCount, &_optimiserStats);
+
+	FullVertexType* vertices = meshData.FullVertexData;
+	_shortIndices = meshData.ShortIndices;
+
+	_boundingRadius = 0.0f;
+	for (int i = 0; i < _vertexCount; ++i)
+	{
+		const XMFLOAT3& position = vertices[i].Position;
+		const float distance = std::sqrt(position.x * position.x + position.y * position.y + position.z * position.z);
+		_boundingRadius = distance > _boundingRadius ? distance : _boundingRadius;
+	}
+
+	// Build the LOD chain, each level simplified from the one before to half its triangles.
+	const unsigned short* shortIndices = static_cast<const unsigned short*>(meshData.IndexData);
+	const unsigned long* longIndices = static_cast<const unsigned long*>(meshData.IndexData);
+	std::vector<unsigned int> lodIndices(baseIndexCount);
+	for (int i = 0; i < baseIndexCount; ++i)
+	{
+		lodIndices[i] = _shortIndices ? shortIndices[i] : longIndices[i];
+	}
+
+	_lods.clear();
+	Lod baseLod;
+	baseLod.StartIndex = 0;
+	baseLod.IndexCount = baseIndexCount;
+	_lods.push_back(baseLod);
+
+	std::vector<unsigned int> simplified(baseIndexCount);
+	while (int(_lods.size()) < MaxLodCount)
+	{
+		const Lod& previous = _lods.back();
+		const int target = previous.IndexCount / 6 * 3;
+		const int indexCount = MeshSimplifier::Simplify(&vertices[0].Position.x, sizeof(FullVertexType), _vertexCount,
+		                                                &lodIndices[previous.StartIndex], previous.IndexCount, target,
+		                                                simplified.data());
+
+		// Stop once simplification stalls, rather than storing near copies of the last level.
+		if (indexCount > previous.IndexCount * 3 / 4)
+		{
+			break;
+		}
+
+		Lod lod;
+		lod.StartIndex = int(lodIndices.size());
+		lod.IndexCount = indexCount;
+		lodIndices.resize(lodIndices.size() + indexCount);
+		MeshOptimiser::OptimiseVertexCache(simplified.data(), indexCount, _vertexCount, &lodIndices[lod.StartIndex]);
+		_lods.push_back(lod);
+	}
+
+	_indexCount = int(lodIndices.size());
+	void* indices = arena.Allocate(size_t(GetIndexSize()) * _indexCount, sizeof(unsigned long));
+	if (_shortIndices)
+	{
+		CopyIndices<unsigned short>(lodIndices.data(), _indexCount, indices);
+	}
+	else
+	{
+		CopyIndices<unsigned long>(lodIndices.data(), _indexCount, indices);
+	}
+
+	PackedVertexType* packedVertices = nullptr;
+	if (PackedVertices)
+	{
+		packedVertices = arena.Allocate<PackedVertexType>(_vertexCount);
+		VertexPacking::Pack(vertices, _vertexCount, packedVertices);
+		_vertexStride = sizeof(PackedVertexType);
+	}
+	else
+	{
+		_vertexStride = sizeof(FullVertexType);
+	}
+
+	// Set up the description of the static vertex buffer.
+	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	vertexBufferDesc.ByteWidth = _vertexStride * _vertexCount;
+	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vertexBufferDesc.CPUAccessFlags = 0;
+	vertexBufferDesc.MiscFlags = 0;
+	vertexBufferDesc.StructureByteStride = 0;
+
+	// Give the subresource structure a pointer to the vertex data.
+	vertexData.pSysMem = packedVertices ? static_cast<const void*>(packedVertices) : vertices;
+	vertexData.SysMemPitch = 0;
+	vertexData.SysMemSlicePitch = 0;
+
+	// Now create the vertex buffer.
+	HRESULT result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &_pVertexBuffer);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	// Set up the description of the static index buffer.
+	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	indexBufferDesc.ByteWidth = GetIndexSize() * _indexCount;
+	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	indexBufferDesc.CPUAccessFlags = 0;
+	indexBufferDesc.MiscFlags = 0;
+	indexBufferDesc.StructureByteStride = 0;
+
+	// Give the subresource structure a pointer to the index data.
+	indexData.pSysMem = indices;
+	indexData.SysMemPitch = 0;
+	indexData.SysMemSlicePitch = 0;
+
+	// Create the index buffer.
+	result = device->CreateBuffer(&indexBufferDesc, &indexData, &_pIndexBuffer);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void Mesh::Bind(StateCache* stateCache) const
+{
+	stateCache->SetVertexBuffer(0, _pVertexBuffer, _vertexStride, 0);
+	stateCache->SetIndexBuffer(_pIndexBuffer, _shortIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+int Mesh::GetLodCount() const
+{
+	return int(_lods.size());
+}
+
+int Mesh::GetIndexCount(const int lod) const
+{
+	return _lods[lod].IndexCount;
+}
+
+int Mesh::GetStartIndex(const int lod) const
+{
+	return _lods[lod].StartIndex;
+}
+
+int Mesh::SelectLod(const float screenSize) const
+{
+	int lod = 0;
+	float threshold = LodScreenSize;
+	while (lod + 1 < int(_lods.size()) && screenSize < threshold)
+	{
+		++lod;
+		threshold *= 0.5f;
+	}
+
+	return lod;
+}
+
+float Mesh::GetBoundingRadius() const
+{
+	return _boundingRadius;
+}
+
+int Mesh::GetVertexCount() const
+{
+	return _vertexCount;
+}
+
+size_t Mesh::GetBufferBytes() const
+{
+	return size_t(_vertexStride) * size_t(_vertexCount) + size_t(GetIndexSize()) * size_t(_indexCount);
+}
+
+int Mesh::GetIndexSize() const
+{
+	return _shortIndices ? int(sizeof(unsigned short)) : int(sizeof(unsigned long));
+}
+
+const MeshOptimiserStats& Mesh::GetOptimiserStats() const
+{
+	return _optimiserStats;
+}
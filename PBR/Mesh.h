@@ -0,0 +1,62 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include "MeshOptimiser.h"
+#include <vector>
+
+struct ID3D11Device;
+struct ID3D11Buffer;
+class MeshArena;
+class StateCache;
+
+// Vertex and index buffers for one piece of geometry. Models reference a Mesh rather than owning buffers, so every
+// model using the same mesh can be drawn with a single instanced call.
+// Simplified LODs share the vertex buffer and are stored one after another in the index buffer.
+class Mesh
+{
+public:
+	static const int MaxLodCount = 4;
+	// LOD 0 is drawn while the mesh's bounding sphere covers at least this fraction of the screen's height. Each
+	// further LOD, with half the triangles of the last, takes over at half the size of the one before.
+	static constexpr float LodScreenSize = 0.3f;
+
+	Mesh();
+	~Mesh();
+
+	// Builds PackedVertexType vertices when PackedVertices is set, otherwise FullVertexType. The arena is only used
+	// while the mesh is being built and can be reset once this returns.
+	bool InitialiseSphere(ID3D11Device* device, MeshArena& arena, float radius, int sliceCount, int stackCount);
+
+	void Bind(StateCache* stateCache) const;
+	int GetLodCount() const;
+	int GetIndexCount(int lod = 0) const;
+	int GetStartIndex(int lod = 0) const;
+	int SelectLod(float screenSize) const;
+	// Radius of a sphere around the mesh's origin containing every vertex.
+	float GetBoundingRadius() const;
+	int GetVertexCount() const;
+	size_t GetBufferBytes() const;
+	// 2 for 16-bit indices, 4 for 32-bit.
+	int GetIndexSize() const;
+	// Vertex cache efficiency of the generated triangle order and of the optimised order that was uploaded.
+	const MeshOptimiserStats& GetOptimiserStats() const;
+
+private:
+	ID3D11Buffer* _pVertexBuffer;
+	ID3D11Buffer* _pIndexBuffer;
+	int _vertexStride;
+	int _vertexCount;
+	int _indexCount;
+	bool _shortIndices;
+	MeshOptimiserStats _optimiserStats;
+	float _boundingRadius;
+
+	struct Lod
+	{
+		int StartIndex;
+		int IndexCount;
+	};
+
+	std::vector<Lod> _lods;
+};
@@ -0,0 +1,87 @@
+#include "MeshArena.h"
+
+namespace
+{
+	const size_t MinBlockSize = 64 * 1024;
+}
+
+MeshArena::MeshArena()
+{
+}
+
+MeshArena::~MeshArena()
+{
+	for (size_t i = 0; i < _blocks.size(); ++i)
+	{
+		delete[] _blocks[i].Data;
+	}
+
+	_blocks.clear();
+}
+
+void* MeshArena::Allocate(const size_t size, const size_t alignment)
+{
+	if (!_blocks.empty())
+	{
+		Block& block = _blocks.back();
+		const size_t offset = (block.Used + alignment - 1) & ~(alignment - 1);
+		if (offset + size <= block.Size)
+		{
+			block.Used = offset + size;
+			return block.Data + offset;
+		}
+	}
+
+	// Blocks come from new[], which is aligned for any fundamental type, so a fresh block needs no padding.
+	size_t blockSize = _blocks.empty() ? MinBlockSize : _blocks.back().Size * 2;
+	if (blockSize < size)
+	{
+		blockSize = size;
+	}
+
+	AddBlock(blockSize);
+
+	Block& block = _blocks.back();
+	block.Used = size;
+	return block.Data;
+}
+
+void MeshArena::Reset()
+{
+	if (_blocks.size() > 1)
+	{
+		const size_t capacity = GetCapacity();
+
+		for (size_t i = 0; i < _blocks.size(); ++i)
+		{
+			delete[] _blocks[i].Data;
+		}
+
+		_blocks.clear();
+		AddBlock(capacity);
+	}
+	else if (!_blocks.empty())
+	{
+		_blocks[0].Used = 0;
+	}
+}
+
+size_t MeshArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (size_t i = 0; i < _blocks.size(); ++i)
+	{
+		capacity += _blocks[i].Size;
+	}
+
+	return capacity;
+}
+
+void MeshArena::AddBlock(const size_t size)
+{
+	Block block;
+	block.Data = new char[size];
+	block.Size = size;
+	block.Used = 0;
+	_blocks.push_back(block);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Scratch memory for building meshes before they are uploaded. Allocations are bumped out of large blocks and are
+// only freed together, by Reset or when the arena is destroyed, so generating a mesh costs no heap traffic once the
+// arena has grown to fit it.
+class MeshArena
+{
+public:
+	MeshArena();
+	~MeshArena();
+
+	void* Allocate(size_t size, size_t alignment);
+
+	template <typename T>
+	T* Allocate(const int count)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * size_t(count), alignof(T)));
+	}
+
+	// Frees every allocation. Memory is kept for reuse, merged into a single block if the arena had to grow.
+	void Reset();
+
+	size_t GetCapacity() const;
+
+private:
+	struct Block
+	{
+		char* Data;
+		size_t Size;
+		size_t Used;
+	};
+
+	void AddBlock(size_t size);
+
+	std::vector<Block> _blocks;
+};
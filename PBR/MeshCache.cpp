@@ -0,0 +1,99 @@
+#include "MeshCache.h"
+#include "Mesh.h"
+
+bool MeshCache::SphereKey::operator==(const SphereKey& other) const
+{
+	return Radius == other.Radius && SliceCount == other.SliceCount && StackCount == other.StackCount;
+}
+
+MeshCache::MeshCache()
+{
+	_hits = 0;
+	_misses = 0;
+}
+
+MeshCache::~MeshCache()
+{
+	// Anything still referenced is freed with the cache.
+	for (size_t i = 0; i < _entries.size(); ++i)
+	{
+		delete _entries[i].CachedMesh;
+	}
+
+	_entries.clear();
+}
+
+Mesh* MeshCache::AcquireSphere(ID3D11Device* device, const float radius, const int sliceCount, const int stackCount)
+{
+	SphereKey key;
+	key.Radius = radius;
+	key.SliceCount = sliceCount;
+	key.StackCount = stackCount;
+
+	// Only a few distinct meshes exist at once, so a linear search is enough.
+	for (size_t i = 0; i < _entries.size(); ++i)
+	{
+		Entry& entry = _entries[i];
+		if (entry.Key == key)
+		{
+			++entry.ReferenceCount;
+			++_hits;
+			return entry.CachedMesh;
+		}
+	}
+
+	++_misses;
+
+	Mesh* mesh = new Mesh;
+	const bool result = mesh->InitialiseSphere(device, _arena, radius, sliceCount, stackCount);
+	_arena.Reset();
+	if (!result)
+	{
+		delete mesh;
+		return nullptr;
+	}
+
+	Entry entry;
+	entry.Key = key;
+	entry.CachedMesh = mesh;
+	entry.ReferenceCount = 1;
+	_entries.push_back(entry);
+
+	return mesh;
+}
+
+void MeshCache::Release(Mesh* mesh)
+{
+	for (size_t i = 0; i < _entries.size(); ++i)
+	{
+		Entry& entry = _entries[i];
+		if (entry.CachedMesh == mesh)
+		{
+			if (--entry.ReferenceCount == 0)
+			{
+				delete entry.CachedMesh;
+				_entries.erase(_entries.begin() + i);
+			}
+
+			return;
+		}
+	}
+}
+
+MeshCacheStats MeshCache::GetStats() const
+{
+	MeshCacheStats stats;
+	stats.MeshCount = _entries.size();
+	stats.ReferenceCount = 0;
+	stats.Hits = _hits;
+	stats.Misses = _misses;
+	stats.BufferBytes = 0;
+
+	for (size_t i = 0; i < _entries.size(); ++i)
+	{
+		stats.ReferenceCount += _entries[i].ReferenceCount;
+		stats.BufferBytes += _entries[i].CachedMesh->GetBufferBytes();
+	}
+
+	return stats;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "MeshArena.h"
+
+struct ID3D11Device;
+class Mesh;
+
+struct MeshCacheStats
+{
+	// Distinct meshes alive, and how many models reference them between them.
+	size_t MeshCount;
+	size_t ReferenceCount;
+	// Acquires served by an existing mesh, and those that had to generate one.
+	size_t Hits;
+	size_t Misses;
+	// Vertex and index buffer memory held by the cached meshes.
+	size_t BufferBytes;
+};
+
+// Builds each generated mesh once and shares it between every model asking for the same generator parameters.
+// Meshes are reference counted and destroyed when their last user releases them.
+class MeshCache
+{
+public:
+	MeshCache();
+	~MeshCache();
+
+	Mesh* AcquireSphere(ID3D11Device* device, float radius, int sliceCount, int stackCount);
+	void Release(Mesh* mesh);
+
+	MeshCacheStats GetStats() const;
+
+private:
+	// The parameters passed to Shapes::CreateSphere.
+	struct SphereKey
+	{
+		float Radius;
+		int SliceCount;
+		int StackCount;
+
+		bool operator==(const SphereKey& other) const;
+	};
+
+	struct Entry
+	{
+		SphereKey Key;
+		Mesh* CachedMesh;
+		int ReferenceCount;
+	};
+
+	std::vector<Entry> _entries;
+	// Scratch memory shared by every mesh the cache builds.
+	MeshArena _arena;
+	size_t _hits;
+	size_t _misses;
+};
@@ -0,0 +1,345 @@
+#include "MeshOptimiser.h"
+#include "Graphics.h"
+#include <cmath>
+
+namespace
+{
+	// The LRU cache the optimiser models, and the scoring constants from Forsyth's paper.
+	const int OptimiserCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriangleScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	float ScoreVertex(const int cachePosition, const int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// The vertices of the triangle just emitted are scored the same, whatever order they went in.
+				score = LastTriangleScore;
+			}
+			else
+			{
+				const float scale = 1.0f / (OptimiserCacheSize - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scale, CacheDecayPower);
+			}
+		}
+
+		// Favour vertices with few triangles left, so lone triangles aren't left behind to be picked up later.
+		return score + ValenceBoostScale * std::pow(float(remainingTriangles), -ValenceBoostPower);
+	}
+
+	int CountTransforms(const unsigned int* indices, const int indexCount, const int vertexCount)
+	{
+		// Each vertex remembers when it entered the FIFO; it is still cached while fewer than SimulatedCacheSize
+		// vertices have entered since.
+		std::vector<int> entered(vertexCount, -MeshOptimiser::SimulatedCacheSize - 1);
+		int transforms = 0;
+
+		for (int i = 0; i < indexCount; ++i)
+		{
+			const unsigned int vertex = indices[i];
+			if (transforms - entered[vertex] > MeshOptimiser::SimulatedCacheSize)
+			{
+				entered[vertex] = transforms;
+				++transforms;
+			}
+		}
+
+		return transforms;
+	}
+
+	template <typename Index>
+	void ReadIndices(const void* source, const int indexCount, std::vector<unsigned int>& indices)
+	{
+		const Index* typed = static_cast<const Index*>(source);
+		for (int i = 0; i < indexCount; ++i)
+		{
+			indices[i] = typed[i];
+		}
+	}
+
+	template <typename Index>
+	void WriteIndices(const std::vector<unsigned int>& indices, void* destination)
+	{
+		Index* typed = static_cast<Index*>(destination);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			typed[i] = Index(indices[i]);
+		}
+	}
+
+	template <typename Vertex>
+	void RemapVertices(Vertex* vertices, const int vertexCount, const std::vector<int>& remap)
+	{
+		const std::vector<Vertex> original(vertices, vertices + vertexCount);
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			vertices[remap[i]] = original[i];
+		}
+	}
+}
+
+MeshOptimiser::MeshOptimiser()
+{
+}
+
+MeshOptimiser::~MeshOptimiser()
+{
+}
+
+void MeshOptimiser::Optimise(MeshData& meshData, const int vertexCount, const int indexCount,
+                             MeshOptimiserStats* stats)
+{
+	std::vector<unsigned int> indices(indexCount);
+	if (meshData.ShortIndices)
+	{
+		ReadIndices<unsigned short>(meshData.IndexData, indexCount, indices);
+	}
+	else
+	{
+		ReadIndices<unsigned long>(meshData.IndexData, indexCount, indices);
+	}
+
+	if (stats)
+	{
+		stats->AcmrBefore = ComputeAcmr(indices.data(), indexCount, vertexCount);
+		stats->AtvrBefore = ComputeAtvr(indices.data(), indexCount, vertexCount);
+	}
+
+	std::vector<unsigned int> optimised(indexCount);
+	OptimiseVertexCache(indices.data(), indexCount, vertexCount, optimised.data());
+
+	std::vector<int> remap;
+	OptimiseVertexFetch(optimised.data(), indexCount, vertexCount, remap);
+
+	if (meshData.FullVertexData)
+	{
+		RemapVertices(meshData.FullVertexData, vertexCount, remap);
+	}
+
+	if (meshData.PosUvVertexData)
+	{
+		RemapVertices(meshData.PosUvVertexData, vertexCount, remap);
+	}
+
+	if (meshData.ShortIndices)
+	{
+		WriteIndices<unsigned short>(optimised, meshData.IndexData);
+	}
+	else
+	{
+		WriteIndices<unsigned long>(optimised, meshData.IndexData);
+	}
+
+	if (stats)
+	{
+		stats->AcmrAfter = ComputeAcmr(optimised.data(), indexCount, vertexCount);
+		stats->AtvrAfter = ComputeAtvr(optimised.data(), indexCount, vertexCount);
+	}
+}
+
+void MeshOptimiser::OptimiseVertexCache(const unsigned int* indices, const int indexCount, const int vertexCount,
+                                        unsigned int* optimised)
+{
+	const int triangleCount = indexCount / 3;
+
+	// Triangles using each vertex, packed into one array. The first remainingTriangles[v] entries of a vertex's
+	// run are the triangles not yet emitted.
+	std::vector<int> remainingTriangles(vertexCount, 0);
+	for (int i = 0; i < indexCount; ++i)
+	{
+		++remainingTriangles[indices[i]];
+	}
+
+	std::vector<int> adjacencyOffsets(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; ++v)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+	}
+
+	std::vector<int> adjacency(indexCount);
+	std::vector<int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (int i = 0; i < indexCount; ++i)
+	{
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (int v = 0; v < vertexCount; ++v)
+	{
+		vertexScores[v] = ScoreVertex(-1, remainingTriangles[v]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (int t = 0; t < triangleCount; ++t)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+			vertexScores[indices[t * 3 + 2]];
+	}
+
+	// Room for the full cache plus the three vertices pushed in front of it.
+	int cache[OptimiserCacheSize + 3];
+	int newCache[OptimiserCacheSize + 3];
+	int cacheCount = 0;
+
+	int bestTriangle = -1;
+	int scanStart = 0;
+
+	for (int output = 0; output < triangleCount; ++output)
+	{
+		if (bestTriangle < 0)
+		{
+			// Nothing in the cache has triangles left, so start again from the best triangle anywhere. Emitted
+			// triangles before scanStart never need looking at again.
+			float bestScore = -1.0f;
+			while (emitted[scanStart])
+			{
+				++scanStart;
+			}
+
+			for (int t = scanStart; t < triangleCount; ++t)
+			{
+				if (!emitted[t] && triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		const unsigned int* triangle = indices + bestTriangle * 3;
+		optimised[output * 3] = triangle[0];
+		optimised[output * 3 + 1] = triangle[1];
+		optimised[output * 3 + 2] = triangle[2];
+		emitted[bestTriangle] = true;
+
+		// Remove the triangle from its vertices' remaining lists.
+		for (int i = 0; i < 3; ++i)
+		{
+			const unsigned int vertex = triangle[i];
+			int* begin = adjacency.data() + adjacencyOffsets[vertex];
+			int& count = remainingTriangles[vertex];
+			for (int j = 0; j < count; ++j)
+			{
+				if (begin[j] == bestTriangle)
+				{
+					begin[j] = begin[count - 1];
+					--count;
+					break;
+				}
+			}
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache.
+		int newCacheCount = 0;
+		for (int i = 0; i < 3; ++i)
+		{
+			newCache[newCacheCount++] = int(triangle[i]);
+		}
+
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			const int vertex = cache[i];
+			if (vertex != int(triangle[0]) && vertex != int(triangle[1]) && vertex != int(triangle[2]))
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+
+		// Rescore everything that was or is in the cache. Vertices that fell out score as uncached.
+		for (int i = 0; i < newCacheCount; ++i)
+		{
+			const int vertex = newCache[i];
+			cachePositions[vertex] = i < OptimiserCacheSize ? i : -1;
+			vertexScores[vertex] = ScoreVertex(cachePositions[vertex], remainingTriangles[vertex]);
+		}
+
+		cacheCount = newCacheCount < OptimiserCacheSize ? newCacheCount : OptimiserCacheSize;
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			cache[i] = newCache[i];
+		}
+
+		// Rescore the triangles around the rescored vertices and pick the best of them for the next step.
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (int i = 0; i < newCacheCount; ++i)
+		{
+			const int vertex = newCache[i];
+			const int* begin = adjacency.data() + adjacencyOffsets[vertex];
+			for (int j = 0; j < remainingTriangles[vertex]; ++j)
+			{
+				const int t = begin[j];
+				const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+					vertexScores[indices[t * 3 + 2]];
+				triangleScores[t] = score;
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+}
+
+void MeshOptimiser::OptimiseVertexFetch(unsigned int* indices, const int indexCount, const int vertexCount,
+                                        std::vector<int>& remap)
+{
+	remap.assign(vertexCount, -1);
+
+	int next = 0;
+	for (int i = 0; i < indexCount; ++i)
+	{
+		int& target = remap[indices[i]];
+		if (target < 0)
+		{
+			target = next++;
+		}
+
+		indices[i] = unsigned(target);
+	}
+
+	// Vertices no triangle uses go to the end.
+	for (int v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] < 0)
+		{
+			remap[v] = next++;
+		}
+	}
+}
+
+float MeshOptimiser::ComputeAcmr(const unsigned int* indices, const int indexCount, const int vertexCount)
+{
+	const int triangleCount = indexCount / 3;
+	return triangleCount > 0 ? float(CountTransforms(indices, indexCount, vertexCount)) / triangleCount : 0.0f;
+}
+
+float MeshOptimiser::ComputeAtvr(const unsigned int* indices, const int indexCount, const int vertexCount)
+{
+	std::vector<bool> used(vertexCount, false);
+	int uniqueCount = 0;
+	for (int i = 0; i < indexCount; ++i)
+	{
+		if (!used[indices[i]])
+		{
+			used[indices[i]] = true;
+			++uniqueCount;
+		}
+	}
+
+	return uniqueCount > 0 ? float(CountTransforms(indices, indexCount, vertexCount)) / uniqueCount : 0.0f;
+}
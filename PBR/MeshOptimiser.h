@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+struct MeshData;
+
+// Average cache miss ratio (transformed vertices per triangle, 0.5 at best) and average transformed vertex ratio
+// (transformed vertices per unique vertex, 1.0 at best), measured with a FIFO post-transform cache of
+// MeshOptimiser::SimulatedCacheSize entries.
+struct MeshOptimiserStats
+{
+	float AcmrBefore;
+	float AtvrBefore;
+	float AcmrAfter;
+	float AtvrAfter;
+};
+
+// Reorders a triangle list for the post-transform vertex cache using Tom Forsyth's linear-speed optimiser, then
+// reorders its vertices into first-use order so vertex fetch walks memory forwards.
+// The mesh renders identically afterwards; only triangle and vertex order change.
+class MeshOptimiser
+{
+	MeshOptimiser();
+	~MeshOptimiser();
+
+public:
+	static const int SimulatedCacheSize = 16;
+
+	// Works on whichever vertex array and index size the MeshData holds. Stats may be null.
+	static void Optimise(MeshData& meshData, int vertexCount, int indexCount, MeshOptimiserStats* stats = nullptr);
+
+	static void OptimiseVertexCache(const unsigned int* indices, int indexCount, int vertexCount,
+	                                unsigned int* optimised);
+	// Fills remap with each vertex's new position and rewrites indices to match.
+	static void OptimiseVertexFetch(unsigned int* indices, int indexCount, int vertexCount, std::vector<int>& remap);
+
+	static float ComputeAcmr(const unsigned int* indices, int indexCount, int vertexCount);
+	static float ComputeAtvr(const unsigned int* indices, int indexCount, int vertexCount);
+};
@@ -0,0 +1,499 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	// Symmetric 4x4 matrix summing the squared distance to a set of planes.
+	struct Quadric
+	{
+		double A00, A01, A02, A03;
+		double A11, A12, A13;
+		double A22, A23;
+		double A33;
+	};
+
+	struct Collapse
+	{
+		unsigned int From;
+		unsigned int To;
+		double Cost;
+
+		bool operator<(const Collapse& other) const
+		{
+			return Cost < other.Cost;
+		}
+	};
+
+	struct Vector
+	{
+		double X, Y, Z;
+	};
+
+	Vector Subtract(const Vector& a, const Vector& b)
+	{
+		const Vector result = { a.X - b.X, a.Y - b.Y, a.Z - b.Z };
+		return result;
+	}
+
+	Vector Cross(const Vector& a, const Vector& b)
+	{
+		const Vector result = { a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X };
+		return result;
+	}
+
+	double Dot(const Vector& a, const Vector& b)
+	{
+		return a.X * b.X + a.Y * b.Y + a.Z * b.Z;
+	}
+
+	void AddPlane(Quadric& q, const Vector& normal, const double distance, const double weight)
+	{
+		q.A00 += weight * normal.X * normal.X;
+		q.A01 += weight * normal.X * normal.Y;
+		q.A02 += weight * normal.X * normal.Z;
+		q.A03 += weight * normal.X * distance;
+		q.A11 += weight * normal.Y * normal.Y;
+		q.A12 += weight * normal.Y * normal.Z;
+		q.A13 += weight * normal.Y * distance;
+		q.A22 += weight * normal.Z * normal.Z;
+		q.A23 += weight * normal.Z * distance;
+		q.A33 += weight * distance * distance;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.A00 += other.A00;
+		q.A01 += other.A01;
+		q.A02 += other.A02;
+		q.A03 += other.A03;
+		q.A11 += other.A11;
+		q.A12 += other.A12;
+		q.A13 += other.A13;
+		q.A22 += other.A22;
+		q.A23 += other.A23;
+		q.A33 += other.A33;
+	}
+
+	double Evaluate(const Quadric& q, const Vector& p)
+	{
+		const double result = q.A00 * p.X * p.X + 2.0 * q.A01 * p.X * p.Y + 2.0 * q.A02 * p.X * p.Z +
+			2.0 * q.A03 * p.X + q.A11 * p.Y * p.Y + 2.0 * q.A12 * p.Y * p.Z + 2.0 * q.A13 * p.Y +
+			q.A22 * p.Z * p.Z + 2.0 * q.A23 * p.Z + q.A33;
+
+		// Rounding can take a perfect fit slightly negative.
+		return result > 0.0 ? result : 0.0;
+	}
+
+	unsigned long long EdgeKey(const unsigned int from, const unsigned int to)
+	{
+		return (static_cast<unsigned long long>(from) << 32) | to;
+	}
+
+	// Vertex to triangle adjacency, packed into one array.
+	void BuildAdjacency(const std::vector<unsigned int>& indices, const int vertexCount, std::vector<int>& offsets,
+	                    std::vector<int>& triangles)
+	{
+		offsets.assign(vertexCount + 1, 0);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			++offsets[indices[i] + 1];
+		}
+
+		for (int v = 0; v < vertexCount; ++v)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+
+		triangles.resize(indices.size());
+		std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			triangles[fill[indices[i]]++] = int(i / 3);
+		}
+	}
+
+	// Whether moving From to To would flip or collapse a triangle that doesn't contain the edge.
+	bool FlipsTriangle(const std::vector<Vector>& points, const std::vector<unsigned int>& indices,
+	                   const std::vector<int>& offsets, const std::vector<int>& triangles,
+	                   const std::vector<bool>& removed, const unsigned int from, const unsigned int to)
+	{
+		for (int i = offsets[from]; i < offsets[from + 1]; ++i)
+		{
+			const int t = triangles[i];
+			if (removed[t])
+			{
+				continue;
+			}
+
+			const unsigned int* triangle = &indices[t * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+			{
+				continue;
+			}
+
+			// Rotate the triangle so From comes first.
+			const int corner = triangle[0] == from ? 0 : triangle[1] == from ? 1 : 2;
+			const Vector& b = points[triangle[(corner + 1) % 3]];
+			const Vector& c = points[triangle[(corner + 2) % 3]];
+
+			const Vector before = Cross(Subtract(b, points[from]), Subtract(c, points[from]));
+			const Vector after = Cross(Subtract(b, points[to]), Subtract(c, points[to]));
+
+			// Reject anything turned more than about 75 degrees, which also catches slivers with no area left.
+			if (Dot(before, after) <= 0.25 * std::sqrt(Dot(before, before) * Dot(after, after)))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+MeshSimplifier::MeshSimplifier()
+{
+}
+
+MeshSimplifier::~MeshSimplifier()
+{
+}
+
+int MeshSimplifier::Simplify(const float* positions, const size_t positionStride, const int vertexCount,
+                             const unsigned int* indices, const int indexCount, const int targetIndexCount,
+                             unsigned int* destination, float* error)
+{
+	std::vector<unsigned int> current(indices, indices + indexCount);
+	double maxError = 0.0;
+
+	std::vector<Vector> points(vertexCount);
+	for (int v = 0; v < vertexCount; ++v)
+	{
+		const float* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) +
+			positionStride * v);
+		points[v].X = position[0];
+		points[v].Y = position[1];
+		points[v].Z = position[2];
+	}
+
+	// Vertices sharing a position, such as the two sides of a UV seam, are wedges of one point. Quadrics and
+	// the closed surface test work on points, with canonical naming the first wedge of each. Positions are
+	// compared on a grid a millionth of the mesh's size across, as generated seams are only equal to rounding.
+	std::vector<unsigned int> canonical(vertexCount);
+	std::vector<unsigned int> wedge(vertexCount);
+	{
+		double extent = 0.0;
+		for (int v = 0; v < vertexCount; ++v)
+		{
+			extent = std::max(extent, std::max(std::fabs(points[v].X), std::max(std::fabs(points[v].Y),
+			                                                                     std::fabs(points[v].Z))));
+		}
+
+		const double scale = extent > 0.0 ? 1e6 / extent : 1.0;
+		std::vector<long long> cells(vertexCount * 3);
+		for (int v = 0; v < vertexCount; ++v)
+		{
+			cells[v * 3] = std::llround(points[v].X * scale);
+			cells[v * 3 + 1] = std::llround(points[v].Y * scale);
+			cells[v * 3 + 2] = std::llround(points[v].Z * scale);
+		}
+
+		std::vector<unsigned int> order(vertexCount);
+		for (int v = 0; v < vertexCount; ++v)
+		{
+			order[v] = unsigned(v);
+		}
+
+		std::sort(order.begin(), order.end(), [&cells](const unsigned int a, const unsigned int b)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (cells[a * 3 + axis] != cells[b * 3 + axis])
+				{
+					return cells[a * 3 + axis] < cells[b * 3 + axis];
+				}
+			}
+
+			return a < b;
+		});
+
+		// Link each run of equal positions into a ring through wedge.
+		for (int i = 0; i < vertexCount;)
+		{
+			int end = i + 1;
+			while (end < vertexCount && cells[order[end] * 3] == cells[order[i] * 3] &&
+				cells[order[end] * 3 + 1] == cells[order[i] * 3 + 1] &&
+				cells[order[end] * 3 + 2] == cells[order[i] * 3 + 2])
+			{
+				++end;
+			}
+
+			for (int j = i; j < end; ++j)
+			{
+				canonical[order[j]] = order[i];
+				wedge[order[j]] = order[j + 1 < end ? j + 1 : i];
+			}
+
+			i = end;
+		}
+	}
+
+	// Each point starts with the planes of the triangles around it, weighted by area.
+	std::vector<Quadric> quadrics(vertexCount, Quadric());
+	for (int i = 0; i < indexCount; i += 3)
+	{
+		const Vector& a = points[current[i]];
+		const Vector normal = Cross(Subtract(points[current[i + 1]], a), Subtract(points[current[i + 2]], a));
+		const double length = std::sqrt(Dot(normal, normal));
+		if (length == 0.0)
+		{
+			continue;
+		}
+
+		const Vector unitNormal = { normal.X / length, normal.Y / length, normal.Z / length };
+		Quadric plane = Quadric();
+		AddPlane(plane, unitNormal, -Dot(unitNormal, a), length * 0.5);
+
+		for (int j = 0; j < 3; ++j)
+		{
+			AddQuadric(quadrics[canonical[current[i + j]]], plane);
+		}
+	}
+
+	// An edge with no twin running the other way is open. Where the points still form a closed surface once
+	// wedges are merged, the open edges are a seam, and a vertex with exactly two wedges can slide along it as
+	// long as its twin does the same. Anything else open is a real border or something stranger, so stays put.
+	std::vector<unsigned long long> edges;
+	std::vector<unsigned long long> pointEdges;
+	for (int i = 0; i < indexCount; i += 3)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			const unsigned int a = current[i + j];
+			const unsigned int b = current[i + (j + 1) % 3];
+			edges.push_back(EdgeKey(a, b));
+			pointEdges.push_back(EdgeKey(canonical[a], canonical[b]));
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+	std::sort(pointEdges.begin(), pointEdges.end());
+
+	enum VertexKind { Manifold, Seam, Locked };
+	std::vector<bool> open(vertexCount, false);
+	std::vector<bool> pointOpen(vertexCount, false);
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		const unsigned int a = static_cast<unsigned int>(edges[i] >> 32);
+		const unsigned int b = static_cast<unsigned int>(edges[i] & 0xFFFFFFFFu);
+		if (!std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a)))
+		{
+			open[a] = true;
+			open[b] = true;
+		}
+
+		const unsigned int pa = static_cast<unsigned int>(pointEdges[i] >> 32);
+		const unsigned int pb = static_cast<unsigned int>(pointEdges[i] & 0xFFFFFFFFu);
+		if (!std::binary_search(pointEdges.begin(), pointEdges.end(), EdgeKey(pb, pa)))
+		{
+			pointOpen[pa] = true;
+			pointOpen[pb] = true;
+		}
+	}
+
+	std::vector<VertexKind> kinds(vertexCount);
+	for (int v = 0; v < vertexCount; ++v)
+	{
+		const bool single = wedge[v] == unsigned(v);
+		const bool pair = !single && wedge[wedge[v]] == unsigned(v);
+		if (single && !open[v])
+		{
+			kinds[v] = Manifold;
+		}
+		else if (pair && !pointOpen[canonical[v]])
+		{
+			kinds[v] = Seam;
+		}
+		else
+		{
+			kinds[v] = Locked;
+		}
+	}
+
+	std::vector<int> offsets;
+	std::vector<int> triangles;
+	std::vector<Collapse> collapses;
+	std::vector<bool> touched(vertexCount);
+	std::vector<bool> removed;
+
+	// Each pass sorts every candidate collapse by cost and takes the cheapest, skipping any near a point an
+	// earlier collapse in the same pass already moved, since their costs are out of date.
+	int triangleCount = indexCount / 3;
+	while (triangleCount * 3 > targetIndexCount)
+	{
+		BuildAdjacency(current, vertexCount, offsets, triangles);
+
+		collapses.clear();
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				const unsigned int a = current[i + j];
+				const unsigned int b = current[i + (j + 1) % 3];
+				const bool seamEdge = !std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a));
+
+				// Interior edges are seen from both triangles, so only take each once.
+				if (a > b && !seamEdge)
+				{
+					continue;
+				}
+
+				Quadric combined = quadrics[canonical[a]];
+				AddQuadric(combined, quadrics[canonical[b]]);
+
+				// Seam vertices may only move along the seam.
+				if (kinds[a] == Manifold || (kinds[a] == Seam && kinds[b] == Seam && seamEdge))
+				{
+					const Collapse collapse = { a, b, Evaluate(combined, points[b]) };
+					collapses.push_back(collapse);
+				}
+
+				if (kinds[b] == Manifold || (kinds[b] == Seam && kinds[a] == Seam && seamEdge))
+				{
+					const Collapse collapse = { b, a, Evaluate(combined, points[a]) };
+					collapses.push_back(collapse);
+				}
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end());
+
+		std::fill(touched.begin(), touched.end(), false);
+		removed.assign(current.size() / 3, false);
+		int collapseCount = 0;
+
+		for (size_t i = 0; i < collapses.size() && triangleCount * 3 > targetIndexCount; ++i)
+		{
+			const Collapse& collapse = collapses[i];
+			if (touched[canonical[collapse.From]] || touched[canonical[collapse.To]])
+			{
+				continue;
+			}
+
+			// A seam vertex takes its twin with it, onto the wedge of To on the twin's side of the seam.
+			unsigned int moves[2][2] = { { collapse.From, collapse.To }, { 0, 0 } };
+			int moveCount = 1;
+			if (kinds[collapse.From] == Seam)
+			{
+				const unsigned int twinFrom = wedge[collapse.From];
+				const unsigned int twinTo = wedge[collapse.To];
+				if (!std::binary_search(edges.begin(), edges.end(), EdgeKey(twinFrom, twinTo)) &&
+					!std::binary_search(edges.begin(), edges.end(), EdgeKey(twinTo, twinFrom)))
+				{
+					continue;
+				}
+
+				moves[1][0] = twinFrom;
+				moves[1][1] = twinTo;
+				moveCount = 2;
+			}
+
+			bool flips = false;
+			for (int m = 0; m < moveCount; ++m)
+			{
+				flips = flips || FlipsTriangle(points, current, offsets, triangles, removed, moves[m][0], moves[m][1]);
+			}
+
+			if (flips)
+			{
+				continue;
+			}
+
+			for (int m = 0; m < moveCount; ++m)
+			{
+				const unsigned int from = moves[m][0];
+				const unsigned int to = moves[m][1];
+
+				for (int j = offsets[from]; j < offsets[from + 1]; ++j)
+				{
+					const int t = triangles[j];
+					if (removed[t])
+					{
+						continue;
+					}
+
+					unsigned int* triangle = &current[t * 3];
+					if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+					{
+						removed[t] = true;
+						--triangleCount;
+						continue;
+					}
+
+					for (int k = 0; k < 3; ++k)
+					{
+						if (triangle[k] == from)
+						{
+							triangle[k] = to;
+						}
+					}
+				}
+
+				// Everything around the moved vertex has changed shape, so leave it for the next pass.
+				for (int j = offsets[from]; j < offsets[from + 1]; ++j)
+				{
+					const unsigned int* triangle = &current[triangles[j] * 3];
+					touched[canonical[triangle[0]]] = true;
+					touched[canonical[triangle[1]]] = true;
+					touched[canonical[triangle[2]]] = true;
+				}
+			}
+
+			AddQuadric(quadrics[canonical[collapse.To]], quadrics[canonical[collapse.From]]);
+			touched[canonical[collapse.From]] = true;
+			maxError = std::max(maxError, collapse.Cost);
+			++collapseCount;
+		}
+
+		// Drop the collapsed triangles.
+		size_t write = 0;
+		for (size_t t = 0; t < removed.size(); ++t)
+		{
+			if (!removed[t])
+			{
+				current[write++] = current[t * 3];
+				current[write++] = current[t * 3 + 1];
+				current[write++] = current[t * 3 + 2];
+			}
+		}
+
+		current.resize(write);
+
+		if (collapseCount == 0)
+		{
+			break;
+		}
+
+		// Seam collapses leave new edges along the seam, so refresh the open edge test.
+		edges.clear();
+		for (size_t t = 0; t < current.size(); t += 3)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				edges.push_back(EdgeKey(current[t + j], current[t + (j + 1) % 3]));
+			}
+		}
+
+		std::sort(edges.begin(), edges.end());
+	}
+
+	std::copy(current.begin(), current.end(), destination);
+
+	if (error)
+	{
+		*error = float(maxError);
+	}
+
+	return int(current.size());
+}
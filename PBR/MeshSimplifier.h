@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// Reduces a triangle list with quadric error metrics (Garland and Heckbert). Each step collapses an edge onto one
+// of its existing vertices, so the result indexes the same vertex buffer and LODs of a mesh can share it.
+// UV seams are simplified by moving the vertices on both sides together; other open borders are never moved.
+class MeshSimplifier
+{
+	MeshSimplifier();
+	~MeshSimplifier();
+
+public:
+	// Positions are three floats at the start of every positionStride bytes. Destination needs room for
+	// indexCount indices. Returns the new index count, which is only above targetIndexCount if no collapse left
+	// is valid. Error, if given, receives the largest quadric error of any collapse made.
+	static int Simplify(const float* positions, size_t positionStride, int vertexCount, const unsigned int* indices,
+	                    int indexCount, int targetIndexCount, unsigned int* destination, float* error = nullptr);
+};
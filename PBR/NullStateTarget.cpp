@@ -0,0 +1,191 @@
+#include "NullStateTarget.h"
+
+NullStateTarget::NullStateTarget()
+{
+	_recording = false;
+	Reset();
+}
+
+NullStateTarget::~NullStateTarget()
+{
+}
+
+void NullStateTarget::SetRecording(const bool recording)
+{
+	_recording = recording;
+}
+
+void NullStateTarget::Reset()
+{
+	for (int i = 0; i < int(StateCommand::Count); ++i)
+	{
+		_counts[i] = 0;
+	}
+
+	_indexCount = 0;
+	_mappedBytes = 0;
+	_commands.clear();
+}
+
+unsigned long long NullStateTarget::GetCount(const StateCommand command) const
+{
+	return _counts[int(command)];
+}
+
+unsigned long long NullStateTarget::GetIndexCount() const
+{
+	return _indexCount;
+}
+
+unsigned long long NullStateTarget::GetMappedBytes() const
+{
+	return _mappedBytes;
+}
+
+const std::vector<RecordedCommand>& NullStateTarget::GetCommands() const
+{
+	return _commands;
+}
+
+void NullStateTarget::SetInputLayout(ID3D11InputLayout* layout)
+{
+	Record(StateCommand::SetInputLayout, 0, 1, layout);
+}
+
+void NullStateTarget::SetVertexShader(ID3D11VertexShader* shader)
+{
+	Record(StateCommand::SetVertexShader, 0, 1, shader);
+}
+
+void NullStateTarget::SetPixelShader(ID3D11PixelShader* shader)
+{
+	Record(StateCommand::SetPixelShader, 0, 1, shader);
+}
+
+void NullStateTarget::SetVertexBuffer(const int slot, ID3D11Buffer* buffer, const unsigned int /*stride*/,
+                                      const unsigned int /*offset*/)
+{
+	Record(StateCommand::SetVertexBuffer, slot, 1, buffer);
+}
+
+void NullStateTarget::SetIndexBuffer(ID3D11Buffer* buffer, const int /*format*/)
+{
+	Record(StateCommand::SetIndexBuffer, 0, 1, buffer);
+}
+
+void NullStateTarget::SetPrimitiveTopology(const int /*topology*/)
+{
+	Record(StateCommand::SetPrimitiveTopology, 0, 1, nullptr);
+}
+
+void NullStateTarget::SetConstantBuffers(const ShaderStage /*stage*/, const int startSlot, const int count,
+                                         ID3D11Buffer* const* buffers, const unsigned int* /*firstConstants*/,
+                                         const unsigned int* /*constantCounts*/)
+{
+	Record(StateCommand::SetConstantBuffers, startSlot, count, buffers[0]);
+}
+
+void NullStateTarget::SetShaderResources(const ShaderStage /*stage*/, const int startSlot, const int count,
+                                         ID3D11ShaderResourceView* const* views)
+{
+	Record(StateCommand::SetShaderResources, startSlot, count, views[0]);
+}
+
+void NullStateTarget::SetSamplers(const ShaderStage /*stage*/, const int startSlot, const int count,
+                                  ID3D11SamplerState* const* samplers)
+{
+	Record(StateCommand::SetSamplers, startSlot, count, samplers[0]);
+}
+
+void* NullStateTarget::Map(ID3D11Buffer* buffer, const unsigned int size)
+{
+	// Nothing reads the data back, so every map can share one block as long as it fits the largest.
+	if (_scratch.size() < size)
+	{
+		_scratch.resize(size);
+	}
+
+	_mappedBytes += size;
+	Record(StateCommand::Map, 0, int(size), buffer);
+	return _scratch.data();
+}
+
+void NullStateTarget::Unmap(ID3D11Buffer* buffer)
+{
+	Record(StateCommand::Unmap, 0, 1, buffer);
+}
+
+void NullStateTarget::DrawIndexed(const int indexCount, const int startIndex)
+{
+	_indexCount += indexCount;
+	Record(StateCommand::DrawIndexed, startIndex, indexCount, nullptr);
+}
+
+void NullStateTarget::DrawIndexedInstanced(const int indexCount, const int instanceCount, const int /*startIndex*/,
+                                           const int /*startInstance*/)
+{
+	_indexCount += static_cast<unsigned long long>(indexCount) * instanceCount;
+	Record(StateCommand::DrawIndexedInstanced, indexCount, instanceCount, nullptr);
+}
+
+CommandList* NullStateTarget::CreateCommandList()
+{
+	return new NullCommandList(_recording);
+}
+
+void NullStateTarget::ExecuteCommandList(CommandList* commandList)
+{
+	const NullStateTarget* list = static_cast<NullStateTarget*>(commandList->GetTarget());
+	Record(StateCommand::ExecuteCommandList, 0, int(list->_commands.size()), commandList);
+
+	for (int i = 0; i < int(StateCommand::Count); ++i)
+	{
+		_counts[i] += list->_counts[i];
+	}
+
+	_indexCount += list->_indexCount;
+	_mappedBytes += list->_mappedBytes;
+	if (_recording)
+	{
+		_commands.insert(_commands.end(), list->_commands.begin(), list->_commands.end());
+	}
+}
+
+void NullStateTarget::Record(const StateCommand command, const int slot, const int count, const void* resource)
+{
+	++_counts[int(command)];
+	if (_recording)
+	{
+		RecordedCommand recorded;
+		recorded.Command = command;
+		recorded.Slot = slot;
+		recorded.Count = count;
+		recorded.Resource = resource;
+		_commands.push_back(recorded);
+	}
+}
+
+NullCommandList::NullCommandList(const bool recording)
+{
+	_target.SetRecording(recording);
+}
+
+NullCommandList::~NullCommandList()
+{
+}
+
+StateTarget* NullCommandList::GetTarget()
+{
+	return &_target;
+}
+
+bool NullCommandList::Begin()
+{
+	_target.Reset();
+	return true;
+}
+
+bool NullCommandList::End()
+{
+	return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "StateCache.h"
+#include <vector>
+
+enum class StateCommand
+{
+	SetInputLayout,
+	SetVertexShader,
+	SetPixelShader,
+	SetVertexBuffer,
+	SetIndexBuffer,
+	SetPrimitiveTopology,
+	SetConstantBuffers,
+	SetShaderResources,
+	SetSamplers,
+	Map,
+	Unmap,
+	DrawIndexed,
+	DrawIndexedInstanced,
+	ExecuteCommandList,
+	Count
+};
+
+// One call received by a NullStateTarget. Slot and Count hold the first slot and number of slots for bindings, 0 and
+// the size for maps, the start index and index count for DrawIndexed, the index and instance counts for
+// DrawIndexedInstanced, and 0 and the number of commands that follow it for ExecuteCommandList. Resource is the first
+// object passed, if any.
+struct RecordedCommand
+{
+	StateCommand Command;
+	int Slot;
+	int Count;
+	const void* Resource;
+};
+
+// A StateTarget with no device behind it. Every call is counted and can optionally be recorded, so the CPU side of
+// a frame can be profiled and checked on machines without a GPU.
+// Maps all hand out the same scratch memory, which is never read back.
+class NullStateTarget : public StateTarget
+{
+public:
+	NullStateTarget();
+	virtual ~NullStateTarget();
+
+	// Recording keeps every command until Reset. Counting alone is cheaper for long benchmarks.
+	void SetRecording(bool recording);
+	// Clears the counts and recorded commands.
+	void Reset();
+
+	unsigned long long GetCount(StateCommand command) const;
+	unsigned long long GetIndexCount() const;
+	unsigned long long GetMappedBytes() const;
+	const std::vector<RecordedCommand>& GetCommands() const;
+
+	void SetInputLayout(ID3D11InputLayout* layout) override;
+	void SetVertexShader(ID3D11VertexShader* shader) override;
+	void SetPixelShader(ID3D11PixelShader* shader) override;
+	void SetVertexBuffer(int slot, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) override;
+	void SetIndexBuffer(ID3D11Buffer* buffer, int format) override;
+	void SetPrimitiveTopology(int topology) override;
+	void SetConstantBuffers(ShaderStage stage, int startSlot, int count, ID3D11Buffer* const* buffers,
+	                        const unsigned int* firstConstants, const unsigned int* constantCounts) override;
+	void SetShaderResources(ShaderStage stage, int startSlot, int count,
+	                        ID3D11ShaderResourceView* const* views) override;
+	void SetSamplers(ShaderStage stage, int startSlot, int count, ID3D11SamplerState* const* samplers) override;
+	void* Map(ID3D11Buffer* buffer, unsigned int size) override;
+	void Unmap(ID3D11Buffer* buffer) override;
+	void DrawIndexed(int indexCount, int startIndex) override;
+	void DrawIndexedInstanced(int indexCount, int instanceCount, int startIndex, int startInstance) override;
+	// Lists are NullStateTargets too, recording if this target is when created. Executing one adds its counts and
+	// commands to this target's.
+	CommandList* CreateCommandList() override;
+	void ExecuteCommandList(CommandList* commandList) override;
+
+private:
+	void Record(StateCommand command, int slot, int count, const void* resource);
+
+	unsigned long long _counts[int(StateCommand::Count)];
+	unsigned long long _indexCount;
+	unsigned long long _mappedBytes;
+	bool _recording;
+	std::vector<RecordedCommand> _commands;
+	std::vector<unsigned char> _scratch;
+};
+
+// A CommandList for NullStateTarget. Begin clears what was recorded last time.
+class NullCommandList : public CommandList
+{
+public:
+	explicit NullCommandList(bool recording);
+	virtual ~NullCommandList();
+
+	StateTarget* GetTarget() override;
+	bool Begin() override;
+	bool End() override;
+
+private:
+	NullStateTarget _target;
+};
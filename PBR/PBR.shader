@@ -1,24 +1,48 @@
-cbuffer ObjectBuffer
+cbuffer ViewBuffer : register(b0)
+{
+    matrix viewMatrix;
+    matrix projectionMatrix;
+	float4 camPos;
+};
+
+// Instanced draws take the world matrix and colour from the vertex stream instead.
+#ifndef INSTANCED
+cbuffer ObjectBuffer : register(b1)
 {
     matrix worldMatrix;
+	float4 objectColour;
 };
+#endif
 
-cbuffer FrameBuffer
+cbuffer LightBuffer : register(b3)
 {
-    matrix viewMatrix;
-    matrix projectionMatrix;
 	float4 lightPositions[4];
 	float4 lightColours[4];
-	float4 camPos;
-	float4 customData;
 };
 
+cbuffer SHBuffer : register(b2)
+{
+	float4 shCoefficients[9];
+	float4 shSettings;
+};
+
+// Packed vertices carry an octahedral encoded normal, see VertexPacking.
 struct VertexInputType
 {
     float4 position : POSITION;
+#ifdef PACKED_VERTICES
+	float2 normal : NORMAL;
+#else
 	float3 normal : NORMAL;
-    float4 color : COLOR;
+#endif
 	float2 uv : TEXCOORD0;
+#ifdef INSTANCED
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
+    float4 color : COLOR;
+#endif
 };
 
 struct PixelInputType
@@ -40,18 +64,38 @@ Texture2D normalMap;
 Texture2D roughnessMap;
 Texture2D metallicMap;
 
+// Keep in sync with VertexPacking::DecodeNormal.
+float3 DecodeNormal(float2 encoded)
+{
+	float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-normal.z);
+	normal.xy += normal.xy >= 0.0f ? -t : t;
+	return normal;
+}
+
 PixelInputType VSMain(VertexInputType input)
 {
 	PixelInputType output;
 
+#ifdef INSTANCED
+	float4x4 world = float4x4(input.world0, input.world1, input.world2, input.world3);
+	output.color = input.color;
+#else
+	float4x4 world = worldMatrix;
+	output.color = objectColour;
+#endif
+
     input.position.w = 1.0f;
 	output.uv = input.uv;
-    output.position = mul(input.position, worldMatrix);
+    output.position = mul(input.position, world);
 	output.worldPos = output.position.xyz;
     output.position = mul(output.position, viewMatrix);
     output.position = mul(output.position, projectionMatrix);
+#ifdef PACKED_VERTICES
+	output.normal = normalize(DecodeNormal(input.normal));
+#else
 	output.normal = normalize(input.normal);
-	output.color = input.color;
+#endif
 
 	return output;
 }
@@ -102,6 +146,21 @@ float GeometrySmith(float3 N, float3 V, float3 L, float roughness)
     return ggx1 * ggx2;
 }
 
+// Irradiance from nine spherical harmonic coefficients that were already convolved with the cosine lobe.
+float3 IrradianceSH(float3 n)
+{
+	float3 result = shCoefficients[0].rgb * 0.282095;
+	result += shCoefficients[1].rgb * (0.488603 * n.y);
+	result += shCoefficients[2].rgb * (0.488603 * n.z);
+	result += shCoefficients[3].rgb * (0.488603 * n.x);
+	result += shCoefficients[4].rgb * (1.092548 * n.x * n.y);
+	result += shCoefficients[5].rgb * (1.092548 * n.y * n.z);
+	result += shCoefficients[6].rgb * (0.315392 * (3.0 * n.z * n.z - 1.0));
+	result += shCoefficients[7].rgb * (1.092548 * n.x * n.z);
+	result += shCoefficients[8].rgb * (0.546274 * (n.x * n.x - n.y * n.y));
+	return max(result, 0.0);
+}
+
 float4 PSMain(PixelInputType input) : SV_TARGET
 {
 	float3 WorldPos = input.worldPos;
@@ -157,7 +216,16 @@ float4 PSMain(PixelInputType input) : SV_TARGET
 	float3 kD = 1.0 - kS;
 	kD *= 1.0 - metallic;
 
-	float3 irradiance = irradianceMap.Sample(textureSampler, N).rgb;
+	float3 irradiance;
+	[branch] if (shSettings.x > 0.0)
+	{
+		irradiance = IrradianceSH(N);
+	}
+	else
+	{
+		irradiance = irradianceMap.SampleLevel(textureSampler, N, 0.0).rgb;
+	}
+
 	float3 diffuse = irradiance * albedo;
 
 	const float MAX_REFLECTION_LOD = 4.0;
@@ -1,6 +1,8 @@
 #include "PBRShader.h"
+#include "StateCache.h"
 #include <D3Dcompiler.h>
 #include "CBuffer.h"
+#include "ConstantRingBuffer.h"
 #include <d3d11.h>
 
 PBRShader::PBRShader() = default;
@@ -15,10 +17,15 @@ PBRShader::~PBRShader()
 }
 
 bool PBRShader::Initialise(ID3D11Device* device, const HWND hwnd)
+{
+	return Initialise(device, hwnd, false, false);
+}
+
+bool PBRShader::Initialise(ID3D11Device* device, const HWND hwnd, const bool instanced, const bool packedVertices)
 {
 	// Now setup the layout of the data that goes into the shader.
 	// This setup needs to match the VertexType stucture in the ModelClass and in the shader.
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[4];
+	D3D11_INPUT_ELEMENT_DESC polygonLayout[8];
 	polygonLayout[0].SemanticName = "POSITION";
 	polygonLayout[0].SemanticIndex = 0;
 	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
@@ -27,31 +34,49 @@ bool PBRShader::Initialise(ID3D11Device* device, const HWND hwnd)
 	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 	polygonLayout[0].InstanceDataStepRate = 0;
 
+	// Packed normals and UVs are expanded to floats by the input assembler.
 	polygonLayout[1].SemanticName = "NORMAL";
 	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[1].Format = packedVertices ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[1].InputSlot = 0;
 	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 	polygonLayout[1].InstanceDataStepRate = 0;
 
-	polygonLayout[2].SemanticName = "COLOR";
+	polygonLayout[2].SemanticName = "TEXCOORD";
 	polygonLayout[2].SemanticIndex = 0;
-	polygonLayout[2].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	polygonLayout[2].Format = packedVertices ? DXGI_FORMAT_R16G16_UNORM : DXGI_FORMAT_R32G32_FLOAT;
 	polygonLayout[2].InputSlot = 0;
 	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 	polygonLayout[2].InstanceDataStepRate = 0;
 
-	polygonLayout[3].SemanticName = "TEXCOORD";
-	polygonLayout[3].SemanticIndex = 0;
-	polygonLayout[3].Format = DXGI_FORMAT_R32G32_FLOAT;
-	polygonLayout[3].InputSlot = 0;
-	polygonLayout[3].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[3].InstanceDataStepRate = 0;
+	// Instances supply the rows of their world matrix and their colour from the second vertex stream.
+	for (int i = 0; i < 5; ++i)
+	{
+		D3D11_INPUT_ELEMENT_DESC& element = polygonLayout[3 + i];
+		element.SemanticName = i < 4 ? "WORLD" : "COLOR";
+		element.SemanticIndex = i < 4 ? i : 0;
+		element.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		element.InputSlot = 1;
+		element.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+		element.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+		element.InstanceDataStepRate = 1;
+	}
 
-	if (!LoadShader(device, hwnd, L"PBR.shader", polygonLayout, 4))
+	D3D_SHADER_MACRO defines[3];
+	int defineCount = 0;
+	if (instanced)
+	{
+		defines[defineCount++] = { "INSTANCED", "1" };
+	}
+	if (packedVertices)
+	{
+		defines[defineCount++] = { "PACKED_VERTICES", "1" };
+	}
+	defines[defineCount] = { nullptr, nullptr };
+
+	if (!LoadShader(device, hwnd, L"PBR.shader", polygonLayout, instanced ? 8 : 3, defines))
 	{
 		return false;
 	}
@@ -77,20 +102,39 @@ bool PBRShader::Initialise(ID3D11Device* device, const HWND hwnd)
 	return !FAILED(result);
 }
 
-bool PBRShader::Render(ID3D11DeviceContext* deviceContext, const int indexCount, CBuffer* frameBuffer,
-                       CBuffer* objectBuffer) const
+bool PBRShader::Render(StateCache* stateCache, const int indexCount, const int startIndex,
+                       CBuffer* viewBuffer, CBuffer* lightBuffer, const ConstantRingBuffer* objectBuffer,
+                       const ConstantRange& objectConstants) const
 {
-	ID3D11Buffer* frameBuff = frameBuffer->GetBuffer();
-	ID3D11Buffer* objectBuff = objectBuffer->GetBuffer();
+	ID3D11Buffer* viewBuff = viewBuffer->GetBuffer();
+	ID3D11Buffer* lightBuff = lightBuffer->GetBuffer();
 
 	// Finanly set the constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(0, 1, &objectBuff);
-	deviceContext->VSSetConstantBuffers(1, 1, &frameBuff);
-	deviceContext->PSSetConstantBuffers(0, 1, &frameBuff);
-	deviceContext->PSSetSamplers(0, 1, &_pSampler);
+	stateCache->SetConstantBuffer(ShaderStage::Vertex, 0, viewBuff);
+	objectBuffer->BindVertexShader(stateCache, 1, objectConstants);
+	stateCache->SetConstantBuffer(ShaderStage::Pixel, 0, viewBuff);
+	stateCache->SetConstantBuffer(ShaderStage::Pixel, 3, lightBuff);
+	stateCache->SetSampler(ShaderStage::Pixel, 0, _pSampler);
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(stateCache, indexCount, startIndex);
+
+	return true;
+}
+
+bool PBRShader::Render(StateCache* stateCache, const int indexCount, const int startIndex,
+                       const int instanceCount, const int startInstance, CBuffer* viewBuffer,
+                       CBuffer* lightBuffer) const
+{
+	ID3D11Buffer* viewBuff = viewBuffer->GetBuffer();
+	ID3D11Buffer* lightBuff = lightBuffer->GetBuffer();
+
+	stateCache->SetConstantBuffer(ShaderStage::Vertex, 0, viewBuff);
+	stateCache->SetConstantBuffer(ShaderStage::Pixel, 0, viewBuff);
+	stateCache->SetConstantBuffer(ShaderStage::Pixel, 3, lightBuff);
+	stateCache->SetSampler(ShaderStage::Pixel, 0, _pSampler);
+
+	RenderShaderInstanced(stateCache, indexCount, startIndex, instanceCount, startInstance);
 
 	return true;
 }
@@ -4,6 +4,8 @@
 
 struct ID3D11SamplerState;
 class CBuffer;
+class ConstantRingBuffer;
+struct ConstantRange;
 struct HWND__;
 
 class PBRShader : public Shader
@@ -13,7 +15,15 @@ public:
 	virtual ~PBRShader();
 
 	bool Initialise(ID3D11Device* device, HWND__* hwnd) override;
-	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, CBuffer* frameBuffer, CBuffer* objectBuffer) const;
+	// The instanced variant reads world matrices and colours from an InstanceBuffer bound to input slot 1 instead of
+	// ObjectBuffer. The packed variant reads PackedVertexType vertices rather than FullVertexType.
+	bool Initialise(ID3D11Device* device, HWND__* hwnd, bool instanced, bool packedVertices);
+	// ObjectBuffer is read from objectConstants, a range of objectBuffer holding an ObjectBufferType.
+	bool Render(StateCache* stateCache, int indexCount, int startIndex, CBuffer* viewBuffer,
+	            CBuffer* lightBuffer, const ConstantRingBuffer* objectBuffer,
+	            const ConstantRange& objectConstants) const;
+	bool Render(StateCache* stateCache, int indexCount, int startIndex, int instanceCount,
+	            int startInstance, CBuffer* viewBuffer, CBuffer* lightBuffer) const;
 
 private:
 	ID3D11SamplerState* _pSampler;
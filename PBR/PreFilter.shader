@@ -1,11 +1,17 @@
-cbuffer FrameBuffer
+cbuffer ViewBuffer
 {
 	matrix viewMatrix;
 	matrix projectionMatrix;
-	float4 lightPositions[4];
-	float4 lightColours[4];
 	float4 camPos;
-	float4 customData;
+};
+
+#define MAX_SAMPLES 1024
+
+// Built by PreFilterSamples. Each entry is a tangent space light direction in xyz and the source mip to read in w.
+cbuffer SampleBuffer : register(b1)
+{
+	float4 samples[MAX_SAMPLES];
+	float4 sampleInfo;
 };
 
 struct VertexInputType
@@ -44,68 +50,26 @@ PixelInputType VSMain(VertexInputType input)
 	return output;
 }
 
-static const float PI = 3.14159265359;
-
-float RadicalInverse_VdC(uint bits)
-{
-	bits = (bits << 16u) | (bits >> 16u);
-	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
-	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
-	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
-	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
-	return float(bits) * 2.3283064365386963e-10; // / 0x100000000
-}
-// ----------------------------------------------------------------------------
-float2 Hammersley(uint i, uint N)
-{
-	return float2(float(i) / float(N), RadicalInverse_VdC(i));
-}
-
-float3 ImportanceSampleGGX(float2 Xi, float3 N, float roughness)
+float4 PSMain(PixelInputType input) : SV_TARGET
 {
-	float a = roughness * roughness;
-
-	float phi = 2.0 * PI * Xi.x;
-	float cosTheta = sqrt((1.0 - Xi.y) / (1.0 + (a*a - 1.0) * Xi.y));
-	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
-
-	// from spherical coordinates to cartesian coordinates
-	float3 H;
-	H.x = cos(phi) * sinTheta;
-	H.y = sin(phi) * sinTheta;
-	H.z = cosTheta;
+	float3 N = normalize(input.localPos);
 
-	// from tangent-space vector to world-space sample vector
+	// N = V = R, so the samples only need rotating into the tangent frame of N.
 	float3 up = abs(N.z) < 0.999 ? float3(0.0, 0.0, 1.0) : float3(1.0, 0.0, 0.0);
 	float3 tangent = normalize(cross(up, N));
 	float3 bitangent = cross(N, tangent);
 
-	float3 sampleVec = tangent * H.x + bitangent * H.y + N * H.z;
-	return normalize(sampleVec);
-}
-
-float4 PSMain(PixelInputType input) : SV_TARGET
-{
-	float roughness = customData.x;
-	float3 N = normalize(input.localPos);
-	float3 R = N;
-	float3 V = R;
-
-	const uint SAMPLE_COUNT = 1024u;
+	uint sampleCount = uint(sampleInfo.x);
 	float totalWeight = 0.0;
 	float3 prefilteredColor = float3(0.0, 0.0, 0.0);
-	for (uint i = 0u; i < SAMPLE_COUNT; ++i)
+	for (uint i = 0u; i < sampleCount; ++i)
 	{
-		float2 Xi = Hammersley(i, SAMPLE_COUNT);
-		float3 H = ImportanceSampleGGX(Xi, N, roughness);
-		float3 L = normalize(2.0 * dot(V, H) * H - V);
-
-		float NdotL = max(dot(N, L), 0.0);
-		if (NdotL > 0.0)
-		{
-			prefilteredColor += shaderTexture.Sample(textureSampler, L).rgb * NdotL;
-			totalWeight += NdotL;
-		}
+		float4 s = samples[i];
+		float3 L = tangent * s.x + bitangent * s.y + N * s.z;
+
+		// Samples below the horizon were dropped when the table was built, so z is NdotL.
+		prefilteredColor += shaderTexture.SampleLevel(textureSampler, L, s.w).rgb * s.z;
+		totalWeight += s.z;
 	}
 	prefilteredColor = prefilteredColor / totalWeight;
 
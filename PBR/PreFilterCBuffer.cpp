@@ -0,0 +1,41 @@
+#include "PreFilterCBuffer.h"
+#include "StateCache.h"
+
+PreFilterCBuffer::PreFilterCBuffer()
+{
+}
+
+PreFilterCBuffer::~PreFilterCBuffer()
+{
+}
+
+bool PreFilterCBuffer::Initialise(ID3D11Device* device)
+{
+	return CBuffer::Initialise(device, sizeof(PreFilterBufferType));
+}
+
+bool PreFilterCBuffer::Update(StateCache* stateCache, const std::vector<PreFilterSample>& samples) const
+{
+	// Lock the constant buffer so it can be written to.
+	PreFilterBufferType* dataPtr = static_cast<PreFilterBufferType*>(
+		stateCache->Map(_pBuffer, sizeof(PreFilterBufferType)));
+	if (!dataPtr)
+	{
+		return false;
+	}
+
+	const size_t sampleCount = samples.size() < size_t(PreFilterSamples::MaxSampleCount)
+		                           ? samples.size()
+		                           : size_t(PreFilterSamples::MaxSampleCount);
+
+	for (size_t i = 0; i < sampleCount; ++i)
+	{
+		dataPtr->Samples[i] = XMFLOAT4(samples[i].x, samples[i].y, samples[i].z, samples[i].Lod);
+	}
+
+	dataPtr->SampleInfo = XMFLOAT4(float(sampleCount), 0.0f, 0.0f, 0.0f);
+
+	stateCache->Unmap(_pBuffer);
+
+	return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CBuffer.h"
+#include "PreFilterSamples.h"
+
+struct PreFilterBufferType
+{
+	XMFLOAT4 Samples[PreFilterSamples::MaxSampleCount];
+	XMFLOAT4 SampleInfo;
+};
+
+// The sample table PreFilter.shader integrates over for the mip being rendered.
+class PreFilterCBuffer : public CBuffer
+{
+public:
+	PreFilterCBuffer();
+	virtual ~PreFilterCBuffer();
+
+	bool Initialise(ID3D11Device* device) override;
+	bool Update(StateCache* stateCache, const std::vector<PreFilterSample>& samples) const;
+};
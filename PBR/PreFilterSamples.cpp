@@ -0,0 +1,70 @@
+#include "PreFilterSamples.h"
+#include "ImportanceSampling.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float PI = 3.14159265359f;
+
+	// Sampling one mip finer than the solid angles match trades a little noise for less blur.
+	const float LodBias = 1.0f;
+
+	float DistributionGGX(const float NdotH, const float roughness)
+	{
+		const float a = roughness * roughness;
+		const float a2 = a * a;
+		const float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+		return a2 / (PI * denom * denom);
+	}
+}
+
+PreFilterSamples::PreFilterSamples()
+{
+}
+
+PreFilterSamples::~PreFilterSamples()
+{
+}
+
+void PreFilterSamples::Generate(const float roughness, int sampleCount, const int sourceSize,
+                                std::vector<PreFilterSample>& samples)
+{
+	sampleCount = std::min(std::max(sampleCount, 1), int(MaxSampleCount));
+	samples.clear();
+
+	const float texelSolidAngle = sourceSize > 0 ? 4.0f * PI / (6.0f * float(sourceSize) * float(sourceSize)) : 0.0f;
+
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		float hx, hy, hz;
+		ImportanceSampleGGX(i, sampleCount, roughness, hx, hy, hz);
+
+		// Reflect V = N about H.
+		PreFilterSample sample;
+		sample.x = 2.0f * hz * hx;
+		sample.y = 2.0f * hz * hy;
+		sample.z = 2.0f * hz * hz - 1.0f;
+		sample.Lod = 0.0f;
+
+		const float length = std::sqrt(sample.x * sample.x + sample.y * sample.y + sample.z * sample.z);
+		sample.x /= length;
+		sample.y /= length;
+		sample.z /= length;
+
+		if (sample.z <= 0.0f)
+		{
+			continue;
+		}
+
+		if (texelSolidAngle > 0.0f && roughness > 0.0f)
+		{
+			// With N = V the pdf of L is D(H) * NdotH / (4 * VdotH) = D(H) / 4.
+			const float pdf = DistributionGGX(hz, roughness) / 4.0f;
+			const float sampleSolidAngle = 1.0f / (float(sampleCount) * pdf + 0.0001f);
+			sample.Lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + LodBias, 0.0f);
+		}
+
+		samples.push_back(sample);
+	}
+}
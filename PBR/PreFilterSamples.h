@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+// A light direction in the tangent space PreFilter.shader integrates in (N = V = R = +Z), and the source cubemap mip
+// to read it from.
+struct PreFilterSample
+{
+	float x;
+	float y;
+	float z;
+	float Lod;
+};
+
+// Sample tables for the pre-filtered specular map. The CPU baker and PreFilter.shader both integrate over the same
+// table, so their results only differ by texture filtering.
+class PreFilterSamples
+{
+	PreFilterSamples();
+	~PreFilterSamples();
+
+public:
+	// Upper limit on the samples per texel, sized to fit the shader's constant buffer.
+	static const int MaxSampleCount = 1024;
+
+	// Builds the GGX importance samples for a roughness, dropping any that fall below the horizon.
+	// With a non-zero sourceSize each sample reads the source mip whose texel solid angle best matches the solid
+	// angle the sample represents (filtered importance sampling). This removes the aliasing of sampling the top
+	// level at high roughness, and gives the same quality with 32 to 64 samples as the unfiltered 1024.
+	static void Generate(float roughness, int sampleCount, int sourceSize, std::vector<PreFilterSample>& samples);
+};
@@ -13,7 +13,7 @@ public:
 	virtual ~PreFilterShader();
 
 	bool Initialise(ID3D11Device* device, HWND__* hwnd) override;
-	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, CBuffer* frameBuffer) const;
+	bool Render(StateCache* stateCache, int indexCount, CBuffer* viewBuffer, CBuffer* sampleBuffer) const;
 
 private:
 	ID3D11SamplerState* _pSampler;
@@ -0,0 +1,220 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct ProfileEvent
+	{
+		const char* Name;
+		unsigned long long Start;
+		unsigned long long End;
+	};
+
+	// One thread's ring of zones. Only its own thread writes Events, publishing each with Written.
+	struct ThreadBuffer
+	{
+		std::vector<ProfileEvent> Events;
+		std::atomic<unsigned long long> Written;
+		int ThreadId;
+		std::string Name;
+	};
+
+	// Buffers outlive their threads, so a capture can still be written once its workers have shut down.
+	struct BufferRegistry
+	{
+		~BufferRegistry()
+		{
+			for (size_t i = 0; i < Buffers.size(); ++i)
+			{
+				delete Buffers[i];
+			}
+		}
+
+		std::mutex Mutex;
+		std::vector<ThreadBuffer*> Buffers;
+	};
+
+	BufferRegistry& GetRegistry()
+	{
+		static BufferRegistry registry;
+		return registry;
+	}
+
+	// The buffer is only created once the thread records a zone, so threads that never do cost no memory.
+	thread_local ThreadBuffer* CurrentBuffer = nullptr;
+	thread_local std::string CurrentName;
+
+	ThreadBuffer* GetThreadBuffer()
+	{
+		if (CurrentBuffer)
+		{
+			return CurrentBuffer;
+		}
+
+		ThreadBuffer* buffer = new ThreadBuffer;
+		buffer->Events.resize(Profiler::EventsPerThread);
+		buffer->Written = 0;
+
+		BufferRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		buffer->ThreadId = int(registry.Buffers.size()) + 1;
+		buffer->Name = CurrentName.empty() ? "Thread " + std::to_string(buffer->ThreadId) : CurrentName;
+		registry.Buffers.push_back(buffer);
+
+		CurrentBuffer = buffer;
+		return buffer;
+	}
+
+	void WriteEscaped(FILE* file, const char* text)
+	{
+		for (; *text; ++text)
+		{
+			if (*text == '"' || *text == '\\')
+			{
+				std::fputc('\\', file);
+			}
+
+			std::fputc(*text, file);
+		}
+	}
+}
+
+std::atomic<bool> Profiler::_capturing(false);
+std::atomic<unsigned long long> Profiler::_captureStart(0);
+std::atomic<unsigned long long> Profiler::_captureEnd(0);
+
+bool Profiler::BeginCapture()
+{
+	if (!PROFILER_ENABLED)
+	{
+		return false;
+	}
+
+	// Events are filtered by time when written out, so the rings never need clearing while other threads use them.
+	_captureStart = GetTimestamp();
+	_captureEnd = 0;
+	_capturing = true;
+	return true;
+}
+
+void Profiler::EndCapture()
+{
+	_capturing = false;
+	_captureEnd = GetTimestamp();
+}
+
+bool Profiler::WriteChromeTrace(const char* fileName)
+{
+	const unsigned long long captureStart = _captureStart;
+	const unsigned long long captureEnd = _capturing ? GetTimestamp() : _captureEnd.load();
+	if (captureStart == 0)
+	{
+		return false;
+	}
+
+	FILE* file = std::fopen(fileName, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	std::fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+
+	BufferRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+
+	std::vector<ProfileEvent> events;
+	for (size_t i = 0; i < registry.Buffers.size(); ++i)
+	{
+		const ThreadBuffer* buffer = registry.Buffers[i];
+
+		// Copy the newest events, then drop any the thread overwrote while they were being copied.
+		const unsigned long long written = buffer->Written.load(std::memory_order_acquire);
+		const unsigned long long capacity = EventsPerThread;
+		const unsigned long long oldest = written > capacity ? written - capacity : 0;
+		events.clear();
+		for (unsigned long long j = oldest; j < written; ++j)
+		{
+			events.push_back(buffer->Events[j % capacity]);
+		}
+
+		const unsigned long long rewritten = buffer->Written.load(std::memory_order_acquire);
+		const unsigned long long overwritten = rewritten > capacity ? rewritten - capacity : 0;
+		if (overwritten > oldest)
+		{
+			events.erase(events.begin(), events.begin() + ptrdiff_t(std::min(overwritten, written) - oldest));
+		}
+
+		events.erase(std::remove_if(events.begin(), events.end(), [&](const ProfileEvent& event)
+		{
+			return event.Start < captureStart || event.End > captureEnd;
+		}), events.end());
+
+		if (events.empty())
+		{
+			continue;
+		}
+
+		// Zones are stored as they end, so put them back in start order, enclosing zones first.
+		std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b)
+		{
+			return a.Start != b.Start ? a.Start < b.Start : a.End > b.End;
+		});
+
+		std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+		             first ? "" : ",\n", buffer->ThreadId);
+		WriteEscaped(file, buffer->Name.c_str());
+		std::fprintf(file, "\"}}");
+		first = false;
+
+		// Chrome traces are in microseconds, so keep the nanoseconds as decimals.
+		for (size_t j = 0; j < events.size(); ++j)
+		{
+			const ProfileEvent& event = events[j];
+			std::fprintf(file, ",\n{\"name\":\"");
+			WriteEscaped(file, event.Name);
+			std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", buffer->ThreadId,
+			             double(event.Start - captureStart) / 1000.0, double(event.End - event.Start) / 1000.0);
+		}
+	}
+
+	std::fprintf(file, "\n]}\n");
+	return std::fclose(file) == 0;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	CurrentName = name;
+
+	if (CurrentBuffer)
+	{
+		std::lock_guard<std::mutex> lock(GetRegistry().Mutex);
+		CurrentBuffer->Name = name;
+	}
+}
+
+unsigned long long Profiler::GetTimestamp()
+{
+	// The steady clock counts from boot, so it is never 0.
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::Record(const char* name, const unsigned long long start, const unsigned long long end)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+
+	const unsigned long long index = buffer->Written.load(std::memory_order_relaxed);
+	ProfileEvent& event = buffer->Events[index % EventsPerThread];
+	event.Name = name;
+	event.Start = start;
+	event.End = end;
+	buffer->Written.store(index + 1, std::memory_order_release);
+}
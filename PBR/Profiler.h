@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+
+// Set to 0 to compile every PROFILE_ZONE out, leaving nothing behind in the code it instruments.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Times the rest of the enclosing scope. name must be a string literal, as only the pointer is kept.
+#if PROFILER_ENABLED
+#define PROFILE_ZONE_JOIN(a, b) a##b
+#define PROFILE_ZONE_VARIABLE(line) PROFILE_ZONE_JOIN(profileZone, line)
+#define PROFILE_ZONE(name) const ProfileZone PROFILE_ZONE_VARIABLE(__LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+// Collects the zones timed on every thread between BeginCapture and EndCapture, for viewing in chrome://tracing or
+// Perfetto. Each thread writes to its own ring buffer, so zones never contend with each other, and only the latest
+// EventsPerThread zones of a thread are kept. Outside a capture a zone costs one relaxed load.
+// Plain C++, so it is shared by the renderer and PBRBake.
+class Profiler
+{
+public:
+	static const int EventsPerThread = 1 << 15;
+
+	// Returns false when zones are compiled out, as there will be nothing to capture.
+	static bool BeginCapture();
+	static void EndCapture();
+	static bool IsCapturing();
+
+	// Writes the last capture as Chrome trace event JSON. Zones still running on other threads are left out.
+	static bool WriteChromeTrace(const char* fileName);
+
+	// Shown as the thread's track name in the trace. name is copied.
+	static void SetThreadName(const char* name);
+
+	// Nanoseconds from a fixed point, never 0.
+	static unsigned long long GetTimestamp();
+	static void Record(const char* name, unsigned long long start, unsigned long long end);
+
+private:
+	static std::atomic<bool> _capturing;
+	static std::atomic<unsigned long long> _captureStart;
+	static std::atomic<unsigned long long> _captureEnd;
+};
+
+// Records a zone from construction to destruction if a capture was running when it started.
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name)
+	{
+		_name = name;
+		_start = Profiler::IsCapturing() ? Profiler::GetTimestamp() : 0;
+	}
+
+	~ProfileZone()
+	{
+		if (_start)
+		{
+			Profiler::Record(_name, _start, Profiler::GetTimestamp());
+		}
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* _name;
+	unsigned long long _start;
+};
+
+inline bool Profiler::IsCapturing()
+{
+	return _capturing.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,151 @@
+#include "RenderTargetPool.h"
+#include "RenderTexture.h"
+#include "DepthBuffer.h"
+
+namespace
+{
+	// About five seconds at 60Hz. Long enough to keep the bake targets around for a re-bake, short enough that a
+	// 2048 texel cube's worth of targets doesn't stay resident forever.
+	const int MaxIdleFrames = 300;
+}
+
+class RenderTextureAllocator : public ResourceAllocator<RenderTexture>
+{
+public:
+	explicit RenderTextureAllocator(ID3D11Device* device)
+	{
+		_pDevice = device;
+	}
+
+	RenderTexture* Create(const ResourceKey& key) override
+	{
+		RenderTexture* renderTexture = new RenderTexture;
+		if (!renderTexture->Initialise(_pDevice, key.Width, key.Height, key.MipLevels, DXGI_FORMAT(key.Format)))
+		{
+			delete renderTexture;
+			return nullptr;
+		}
+
+		return renderTexture;
+	}
+
+	void Destroy(RenderTexture* resource) override
+	{
+		delete resource;
+	}
+
+private:
+	ID3D11Device* _pDevice;
+};
+
+class DepthBufferAllocator : public ResourceAllocator<DepthBuffer>
+{
+public:
+	explicit DepthBufferAllocator(ID3D11Device* device)
+	{
+		_pDevice = device;
+	}
+
+	DepthBuffer* Create(const ResourceKey& key) override
+	{
+		DepthBuffer* depthBuffer = new DepthBuffer;
+		if (!depthBuffer->Initialise(_pDevice, key.Width, key.Height))
+		{
+			delete depthBuffer;
+			return nullptr;
+		}
+
+		return depthBuffer;
+	}
+
+	void Destroy(DepthBuffer* resource) override
+	{
+		delete resource;
+	}
+
+private:
+	ID3D11Device* _pDevice;
+};
+
+RenderTargetPool::RenderTargetPool()
+{
+	_pRenderTextureAllocator = nullptr;
+	_pDepthBufferAllocator = nullptr;
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	// The pools need their allocators to destroy what they hold.
+	_renderTargets.Clear();
+	_depthBuffers.Clear();
+
+	if (_pRenderTextureAllocator)
+	{
+		delete _pRenderTextureAllocator;
+		_pRenderTextureAllocator = nullptr;
+	}
+
+	if (_pDepthBufferAllocator)
+	{
+		delete _pDepthBufferAllocator;
+		_pDepthBufferAllocator = nullptr;
+	}
+}
+
+void RenderTargetPool::Initialise(ID3D11Device* device)
+{
+	_pRenderTextureAllocator = new RenderTextureAllocator(device);
+	_pDepthBufferAllocator = new DepthBufferAllocator(device);
+
+	_renderTargets.Initialise(_pRenderTextureAllocator, MaxIdleFrames);
+	_depthBuffers.Initialise(_pDepthBufferAllocator, MaxIdleFrames);
+}
+
+RenderTexture* RenderTargetPool::AcquireRenderTarget(const int width, const int height, const int mipMaps,
+                                                     const DXGI_FORMAT format)
+{
+	ResourceKey key;
+	key.Width = width;
+	key.Height = height;
+	key.Format = int(format);
+	key.MipLevels = mipMaps;
+
+	return _renderTargets.Acquire(key);
+}
+
+DepthBuffer* RenderTargetPool::AcquireDepthBuffer(const int width, const int height)
+{
+	ResourceKey key;
+	key.Width = width;
+	key.Height = height;
+	key.Format = int(DXGI_FORMAT_D24_UNORM_S8_UINT);
+	key.MipLevels = 1;
+
+	return _depthBuffers.Acquire(key);
+}
+
+void RenderTargetPool::Release(RenderTexture* renderTexture)
+{
+	_renderTargets.Release(renderTexture);
+}
+
+void RenderTargetPool::Release(DepthBuffer* depthBuffer)
+{
+	_depthBuffers.Release(depthBuffer);
+}
+
+void RenderTargetPool::EndFrame()
+{
+	_renderTargets.EndFrame();
+	_depthBuffers.EndFrame();
+}
+
+ResourcePoolStats RenderTargetPool::GetRenderTargetStats() const
+{
+	return _renderTargets.GetStats();
+}
+
+ResourcePoolStats RenderTargetPool::GetDepthBufferStats() const
+{
+	return _depthBuffers.GetStats();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <dxgiformat.h>
+#include "ResourcePool.h"
+
+class RenderTexture;
+class DepthBuffer;
+class RenderTextureAllocator;
+class DepthBufferAllocator;
+struct ID3D11Device;
+
+// Pools the render targets and depth buffers used by offscreen passes such as the IBL bake, so repeated passes and
+// re-bakes reuse textures rather than creating them each time. Owned by D3D, which ends a pool frame every EndScene.
+class RenderTargetPool
+{
+public:
+	RenderTargetPool();
+	~RenderTargetPool();
+
+	void Initialise(ID3D11Device* device);
+
+	RenderTexture* AcquireRenderTarget(int width, int height, int mipMaps = 1,
+	                                   DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_FLOAT);
+	DepthBuffer* AcquireDepthBuffer(int width, int height);
+	void Release(RenderTexture* renderTexture);
+	void Release(DepthBuffer* depthBuffer);
+
+	void EndFrame();
+
+	ResourcePoolStats GetRenderTargetStats() const;
+	ResourcePoolStats GetDepthBufferStats() const;
+
+private:
+	RenderTextureAllocator* _pRenderTextureAllocator;
+	DepthBufferAllocator* _pDepthBufferAllocator;
+	ResourcePool<RenderTexture> _renderTargets;
+	ResourcePool<DepthBuffer> _depthBuffers;
+};
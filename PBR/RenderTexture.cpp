@@ -1,8 +1,17 @@
 #include "RenderTexture.h"
 #include <d3d11.h>
 #include "D3D.h"
+#include "StateCache.h"
+#include "DepthBuffer.h"
 
-RenderTexture::RenderTexture() = default;
+RenderTexture::RenderTexture()
+{
+	_width = 0;
+	_height = 0;
+	_pRenderTargetTexture = nullptr;
+	_pRenderTargetView = nullptr;
+	_pShaderResourceView = nullptr;
+}
 
 RenderTexture::~RenderTexture()
 {
@@ -26,6 +35,12 @@ RenderTexture::~RenderTexture()
 }
 
 bool RenderTexture::Initialise(ID3D11Device* device, const int width, const int height, const int mipMaps)
+{
+	return Initialise(device, width, height, mipMaps, DXGI_FORMAT_R16G16B16A16_FLOAT);
+}
+
+bool RenderTexture::Initialise(ID3D11Device* device, const int width, const int height, const int mipMaps,
+                               const DXGI_FORMAT format)
 {
 	D3D11_TEXTURE2D_DESC textureDesc;
 	D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc;
@@ -42,7 +57,7 @@ bool RenderTexture::Initialise(ID3D11Device* device, const int width, const int
 	textureDesc.Height = height;
 	textureDesc.MipLevels = mipMaps;
 	textureDesc.ArraySize = 1;
-	textureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	textureDesc.Format = format;
 	textureDesc.SampleDesc.Count = 1;
 	textureDesc.Usage = D3D11_USAGE_DEFAULT;
 	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
@@ -95,6 +110,17 @@ void RenderTexture::SetRenderTarget(D3D* d3d, ID3D11DeviceContext* deviceContext
 
 	// Bind the render target view and depth stencil buffer to the output render pipeline.
 	deviceContext->OMSetRenderTargets(1, &_pRenderTargetView, d3d->GetDepthStencilView());
+	d3d->GetStateCache()->Invalidate();
+}
+
+void RenderTexture::SetRenderTarget(D3D* d3d, ID3D11DeviceContext* deviceContext,
+                                    const DepthBuffer* depthBuffer) const
+{
+	d3d->ResizeViewport(_width, _height);
+
+	ID3D11DepthStencilView* depthStencilView = depthBuffer->GetDSV();
+	deviceContext->OMSetRenderTargets(1, &_pRenderTargetView, depthStencilView);
+	d3d->GetStateCache()->Invalidate();
 }
 
 void RenderTexture::ClearRenderTarget(ID3D11DeviceContext* deviceContext, ID3D11DepthStencilView* depthStencilView,
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <dxgiformat.h>
+
 struct ID3D11ShaderResourceView;
 struct ID3D11Device;
 struct ID3D11Texture2D;
@@ -7,6 +9,7 @@ struct ID3D11RenderTargetView;
 struct ID3D11DeviceContext;
 struct ID3D11DepthStencilView;
 class D3D;
+class DepthBuffer;
 
 class RenderTexture
 {
@@ -15,8 +18,11 @@ public:
 	~RenderTexture();
 
 	bool Initialise(ID3D11Device* device, int width, int height, int mipMaps);
+	bool Initialise(ID3D11Device* device, int width, int height, int mipMaps, DXGI_FORMAT format);
 
 	void SetRenderTarget(D3D* d3d, ID3D11DeviceContext* deviceContext) const;
+	// Renders with a depth buffer of the same size rather than resizing the back buffer's.
+	void SetRenderTarget(D3D* d3d, ID3D11DeviceContext* deviceContext, const DepthBuffer* depthBuffer) const;
 	void ClearRenderTarget(ID3D11DeviceContext* deviceContext, ID3D11DepthStencilView* depthStencilView, float red,
 	                       float green, float blue, float alpha) const;
 	ID3D11ShaderResourceView* GetSRV() const;
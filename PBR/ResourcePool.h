@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// What a pooled resource is matched on. Format is the backend's own format value, a DXGI_FORMAT for D3D11.
+struct ResourceKey
+{
+	int Width;
+	int Height;
+	int Format;
+	int MipLevels;
+
+	bool operator==(const ResourceKey& other) const
+	{
+		return Width == other.Width && Height == other.Height && Format == other.Format && MipLevels == other.MipLevels;
+	}
+};
+
+struct ResourcePoolStats
+{
+	// Acquires served from a released resource, and those that had to create one.
+	size_t Hits;
+	size_t Misses;
+	size_t InUse;
+	size_t Free;
+};
+
+// Creates and destroys the resources a ResourcePool hands out.
+// RenderTargetPool implements this with D3D11. The pool itself has no graphics API dependency, so any other
+// implementation, such as one that only counts calls, can drive it on machines without a GPU.
+template <typename T>
+class ResourceAllocator
+{
+public:
+	virtual ~ResourceAllocator()
+	{
+	}
+
+	virtual T* Create(const ResourceKey& key) = 0;
+	virtual void Destroy(T* resource) = 0;
+};
+
+// Recycles resources with matching keys instead of destroying and recreating them between passes and frames.
+// Released resources stay alive until they have gone unused for maxIdleFrames calls to EndFrame.
+// Pools only ever hold a handful of resources, so entries are searched linearly.
+template <typename T>
+class ResourcePool
+{
+public:
+	ResourcePool()
+	{
+		_pAllocator = nullptr;
+		_maxIdleFrames = 0;
+		_frame = 0;
+		_hits = 0;
+		_misses = 0;
+	}
+
+	~ResourcePool()
+	{
+		Clear();
+	}
+
+	void Initialise(ResourceAllocator<T>* allocator, const int maxIdleFrames)
+	{
+		_pAllocator = allocator;
+		_maxIdleFrames = maxIdleFrames;
+	}
+
+	// Returns a free resource matching the key, or creates one. Returns nullptr if creation fails.
+	T* Acquire(const ResourceKey& key)
+	{
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			Entry& entry = _entries[i];
+			if (!entry.InUse && entry.Key == key)
+			{
+				entry.InUse = true;
+				++_hits;
+				return entry.Resource;
+			}
+		}
+
+		++_misses;
+		T* resource = _pAllocator->Create(key);
+		if (!resource)
+		{
+			return nullptr;
+		}
+
+		Entry entry;
+		entry.Resource = resource;
+		entry.Key = key;
+		entry.LastUsedFrame = _frame;
+		entry.InUse = true;
+		_entries.push_back(entry);
+
+		return resource;
+	}
+
+	// Hands a resource back for reuse. Resources that didn't come from this pool are ignored.
+	void Release(T* resource)
+	{
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			Entry& entry = _entries[i];
+			if (entry.Resource == resource)
+			{
+				entry.InUse = false;
+				entry.LastUsedFrame = _frame;
+				return;
+			}
+		}
+	}
+
+	// Advances the frame counter and destroys free resources that have been idle for too long.
+	void EndFrame()
+	{
+		++_frame;
+
+		for (size_t i = 0; i < _entries.size();)
+		{
+			const Entry& entry = _entries[i];
+			if (!entry.InUse && _frame - entry.LastUsedFrame > static_cast<unsigned long long>(_maxIdleFrames))
+			{
+				_pAllocator->Destroy(entry.Resource);
+				_entries[i] = _entries.back();
+				_entries.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	// Destroys every resource, including any still in use.
+	void Clear()
+	{
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			_pAllocator->Destroy(_entries[i].Resource);
+		}
+
+		_entries.clear();
+	}
+
+	ResourcePoolStats GetStats() const
+	{
+		ResourcePoolStats stats;
+		stats.Hits = _hits;
+		stats.Misses = _misses;
+		stats.InUse = 0;
+		stats.Free = 0;
+
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			if (_entries[i].InUse)
+			{
+				++stats.InUse;
+			}
+			else
+			{
+				++stats.Free;
+			}
+		}
+
+		return stats;
+	}
+
+private:
+	struct Entry
+	{
+		T* Resource;
+		ResourceKey Key;
+		unsigned long long LastUsedFrame;
+		bool InUse;
+	};
+
+	ResourceAllocator<T>* _pAllocator;
+	int _maxIdleFrames;
+	unsigned long long _frame;
+	size_t _hits;
+	size_t _misses;
+	std::vector<Entry> _entries;
+};
@@ -0,0 +1,38 @@
+#include "SHCBuffer.h"
+#include "SphericalHarmonics.h"
+#include "StateCache.h"
+
+SHCBuffer::SHCBuffer()
+{
+}
+
+SHCBuffer::~SHCBuffer()
+{
+}
+
+bool SHCBuffer::Initialise(ID3D11Device* device)
+{
+	return CBuffer::Initialise(device, sizeof(SHBufferType));
+}
+
+bool SHCBuffer::Update(StateCache* stateCache, const SHCoefficients& irradiance, const bool enabled) const
+{
+	// Lock the constant buffer so it can be written to.
+	SHBufferType* dataPtr = static_cast<SHBufferType*>(stateCache->Map(_pBuffer, sizeof(SHBufferType)));
+	if (!dataPtr)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < SHCoefficients::Count; ++i)
+	{
+		dataPtr->Coefficients[i] = XMFLOAT4(irradiance.Values[i]);
+	}
+
+	// When disabled the shader falls back to sampling the irradiance cubemap.
+	dataPtr->Settings = XMFLOAT4(enabled ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
+
+	stateCache->Unmap(_pBuffer);
+
+	return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CBuffer.h"
+
+struct SHCoefficients;
+
+struct SHBufferType
+{
+	XMFLOAT4 Coefficients[9];
+	XMFLOAT4 Settings;
+};
+
+// Spherical harmonic irradiance coefficients for PBR.shader. Written once when the skybox is created.
+class SHCBuffer : public CBuffer
+{
+public:
+	SHCBuffer();
+	virtual ~SHCBuffer();
+
+	bool Initialise(ID3D11Device* device) override;
+	bool Update(StateCache* stateCache, const SHCoefficients& irradiance, bool enabled) const;
+};
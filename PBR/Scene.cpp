@@ -0,0 +1,180 @@
+#include "Scene.h"
+#include "Mesh.h"
+
+using namespace DirectX;
+
+Scene::Scene()
+{
+}
+
+Scene::~Scene()
+{
+}
+
+MeshHandle Scene::AddMesh(Mesh* mesh)
+{
+	_meshes.push_back(mesh);
+	return MeshHandle(_meshes.size() - 1);
+}
+
+MaterialHandle Scene::AddMaterial(const Material& material)
+{
+	_materials.push_back(material);
+	return MaterialHandle(_materials.size() - 1);
+}
+
+Mesh* Scene::GetMesh(const MeshHandle mesh) const
+{
+	return _meshes[mesh];
+}
+
+const Material& Scene::GetMaterial(const MaterialHandle material) const
+{
+	return _materials[material];
+}
+
+int Scene::GetMeshCount() const
+{
+	return int(_meshes.size());
+}
+
+int Scene::GetMaterialCount() const
+{
+	return int(_materials.size());
+}
+
+EntityHandle Scene::CreateEntity(const XMFLOAT3 position, const MeshHandle mesh, const MaterialHandle material)
+{
+	unsigned int slotIndex;
+	if (!_freeSlots.empty())
+	{
+		slotIndex = _freeSlots.back();
+		_freeSlots.pop_back();
+	}
+	else
+	{
+		slotIndex = unsigned(_slots.size());
+		Slot slot;
+		slot.DenseIndex = 0;
+		slot.Generation = 0;
+		_slots.push_back(slot);
+	}
+
+	Slot& slot = _slots[slotIndex];
+	slot.DenseIndex = unsigned(_denseToSlot.size());
+
+	_denseToSlot.push_back(slotIndex);
+	_positionsX.push_back(position.x);
+	_positionsY.push_back(position.y);
+	_positionsZ.push_back(position.z);
+	_boundingRadii.push_back(_meshes[mesh]->GetBoundingRadius());
+	_meshHandles.push_back(mesh);
+	_materialHandles.push_back(material);
+
+	EntityHandle handle;
+	handle.Index = slotIndex;
+	handle.Generation = slot.Generation;
+	return handle;
+}
+
+bool Scene::DestroyEntity(const EntityHandle entity)
+{
+	if (!IsValid(entity))
+	{
+		return false;
+	}
+
+	Slot& slot = _slots[entity.Index];
+	const unsigned int dense = slot.DenseIndex;
+	const unsigned int last = unsigned(_denseToSlot.size() - 1);
+
+	// Fill the hole with the last entity and point its slot at the new position.
+	if (dense != last)
+	{
+		_denseToSlot[dense] = _denseToSlot[last];
+		_positionsX[dense] = _positionsX[last];
+		_positionsY[dense] = _positionsY[last];
+		_positionsZ[dense] = _positionsZ[last];
+		_boundingRadii[dense] = _boundingRadii[last];
+		_meshHandles[dense] = _meshHandles[last];
+		_materialHandles[dense] = _materialHandles[last];
+		_slots[_denseToSlot[dense]].DenseIndex = dense;
+	}
+
+	_denseToSlot.pop_back();
+	_positionsX.pop_back();
+	_positionsY.pop_back();
+	_positionsZ.pop_back();
+	_boundingRadii.pop_back();
+	_meshHandles.pop_back();
+	_materialHandles.pop_back();
+
+	++slot.Generation;
+	_freeSlots.push_back(entity.Index);
+	return true;
+}
+
+bool Scene::IsValid(const EntityHandle entity) const
+{
+	return entity.Index < _slots.size() && _slots[entity.Index].Generation == entity.Generation;
+}
+
+bool Scene::SetPosition(const EntityHandle entity, const XMFLOAT3 position)
+{
+	if (!IsValid(entity))
+	{
+		return false;
+	}
+
+	const unsigned int dense = _slots[entity.Index].DenseIndex;
+	_positionsX[dense] = position.x;
+	_positionsY[dense] = position.y;
+	_positionsZ[dense] = position.z;
+	return true;
+}
+
+bool Scene::SetMaterial(const EntityHandle entity, const MaterialHandle material)
+{
+	if (!IsValid(entity))
+	{
+		return false;
+	}
+
+	_materialHandles[_slots[entity.Index].DenseIndex] = material;
+	return true;
+}
+
+int Scene::GetEntityCount() const
+{
+	return int(_denseToSlot.size());
+}
+
+const float* Scene::GetPositionsX() const
+{
+	return _positionsX.data();
+}
+
+const float* Scene::GetPositionsY() const
+{
+	return _positionsY.data();
+}
+
+const float* Scene::GetPositionsZ() const
+{
+	return _positionsZ.data();
+}
+
+const float* Scene::GetBoundingRadii() const
+{
+	return _boundingRadii.data();
+}
+
+const MeshHandle* Scene::GetMeshHandles() const
+{
+	return _meshHandles.data();
+}
+
+const MaterialHandle* Scene::GetMaterialHandles() const
+{
+	return _materialHandles.data();
+}
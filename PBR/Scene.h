@@ -0,0 +1,80 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+class Mesh;
+
+// What a model is drawn with, apart from its geometry.
+struct Material
+{
+	DirectX::XMFLOAT4 Colour;
+};
+
+typedef int MeshHandle;
+typedef int MaterialHandle;
+
+// Refers to an entity in a Scene. A handle to a destroyed entity stays invalid even after its slot is reused, as
+// the slot's generation no longer matches.
+struct EntityHandle
+{
+	unsigned int Index;
+	unsigned int Generation;
+};
+
+// Every model in the world, stored as parallel arrays so per-frame passes such as culling, batching and instance
+// filling stream through memory instead of visiting one heap object per model.
+// Entities are kept densely packed; destroying one moves the last entity into its place, so the order of the
+// arrays is not stable and entities should be held by handle.
+class Scene
+{
+public:
+	Scene();
+	~Scene();
+
+	// Meshes are not owned by the scene.
+	MeshHandle AddMesh(Mesh* mesh);
+	MaterialHandle AddMaterial(const Material& material);
+	Mesh* GetMesh(MeshHandle mesh) const;
+	const Material& GetMaterial(MaterialHandle material) const;
+	int GetMeshCount() const;
+	int GetMaterialCount() const;
+
+	EntityHandle CreateEntity(DirectX::XMFLOAT3 position, MeshHandle mesh, MaterialHandle material);
+	// Returns false if the handle is stale.
+	bool DestroyEntity(EntityHandle entity);
+	bool IsValid(EntityHandle entity) const;
+	bool SetPosition(EntityHandle entity, DirectX::XMFLOAT3 position);
+	bool SetMaterial(EntityHandle entity, MaterialHandle material);
+
+	int GetEntityCount() const;
+	const float* GetPositionsX() const;
+	const float* GetPositionsY() const;
+	const float* GetPositionsZ() const;
+	// Bounding sphere radius around each position, taken from the entity's mesh.
+	const float* GetBoundingRadii() const;
+	const MeshHandle* GetMeshHandles() const;
+	const MaterialHandle* GetMaterialHandles() const;
+
+private:
+	struct Slot
+	{
+		unsigned int DenseIndex;
+		unsigned int Generation;
+	};
+
+	std::vector<Slot> _slots;
+	std::vector<unsigned int> _freeSlots;
+
+	// Entity data, indexed densely. _denseToSlot maps back to the slot so a moved entity's handle can follow it.
+	std::vector<unsigned int> _denseToSlot;
+	std::vector<float> _positionsX;
+	std::vector<float> _positionsY;
+	std::vector<float> _positionsZ;
+	std::vector<float> _boundingRadii;
+	std::vector<MeshHandle> _meshHandles;
+	std::vector<MaterialHandle> _materialHandles;
+
+	std::vector<Mesh*> _meshes;
+	std::vector<Material> _materials;
+};
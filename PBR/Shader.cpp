@@ -1,4 +1,5 @@
 #include "Shader.h"
+#include "StateCache.h"
 #include <D3Dcompiler.h>
 #include <d3d11.h>
 #include <fstream>
@@ -27,7 +28,8 @@ Shader::~Shader()
 }
 
 bool Shader::LoadShader(ID3D11Device* device, const HWND hwnd, const LPCWSTR shaderFileName,
-                        D3D11_INPUT_ELEMENT_DESC* inputLayout, const int inputCount)
+                        D3D11_INPUT_ELEMENT_DESC* inputLayout, const int inputCount,
+                        const D3D_SHADER_MACRO* defines)
 {
 	ID3D10Blob* errorMessage;
 	ID3D10Blob* vertexShaderBuffer;
@@ -39,7 +41,7 @@ bool Shader::LoadShader(ID3D11Device* device, const HWND hwnd, const LPCWSTR sha
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	HRESULT result = D3DCompileFromFile(shaderFileName, nullptr, nullptr, "VSMain", "vs_5_0",
+	HRESULT result = D3DCompileFromFile(shaderFileName, defines, nullptr, "VSMain", "vs_5_0",
 	                                    D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
@@ -58,7 +60,7 @@ bool Shader::LoadShader(ID3D11Device* device, const HWND hwnd, const LPCWSTR sha
 	}
 
 	// Compile the pixel shader code.
-	result = D3DCompileFromFile(shaderFileName, nullptr, nullptr, "PSMain", "ps_5_0",
+	result = D3DCompileFromFile(shaderFileName, defines, nullptr, "PSMain", "ps_5_0",
 	                            D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
@@ -140,15 +142,26 @@ void Shader::OutputShaderErrorMessage(ID3D10Blob* errorMessage, const HWND hwnd,
 	MessageBox(hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
 }
 
-void Shader::RenderShader(ID3D11DeviceContext* deviceContext, const int indexCount) const
+void Shader::RenderShader(StateCache* stateCache, const int indexCount, const int startIndex) const
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(_pLayout);
+	stateCache->SetInputLayout(_pLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(_pVertexShader, nullptr, 0);
-	deviceContext->PSSetShader(_pPixelShader, nullptr, 0);
+	stateCache->SetVertexShader(_pVertexShader);
+	stateCache->SetPixelShader(_pPixelShader);
 
 	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	stateCache->DrawIndexed(indexCount, startIndex);
+}
+
+void Shader::RenderShaderInstanced(StateCache* stateCache, const int indexCount, const int startIndex,
+                                   const int instanceCount, const int startInstance) const
+{
+	stateCache->SetInputLayout(_pLayout);
+
+	stateCache->SetVertexShader(_pVertexShader);
+	stateCache->SetPixelShader(_pPixelShader);
+
+	stateCache->DrawIndexedInstanced(indexCount, instanceCount, startIndex, startInstance);
 }
@@ -3,11 +3,12 @@
 struct HWND__;
 struct ID3D11Device;
 struct ID3D10Blob;
-struct ID3D11DeviceContext;
 struct ID3D11VertexShader;
 struct ID3D11PixelShader;
 struct ID3D11InputLayout;
 struct D3D11_INPUT_ELEMENT_DESC;
+struct _D3D_SHADER_MACRO;
+class StateCache;
 
 class Shader
 {
@@ -19,9 +20,11 @@ protected:
 	~Shader();
 
 	void OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND__* hwnd, const wchar_t* shaderFilename) const;
-	void RenderShader(ID3D11DeviceContext*, int) const;
+	void RenderShader(StateCache* stateCache, int indexCount, int startIndex = 0) const;
+	void RenderShaderInstanced(StateCache* stateCache, int indexCount, int startIndex, int instanceCount,
+	                           int startInstance) const;
 	bool LoadShader(ID3D11Device* device, HWND__* hwnd, const wchar_t* shaderFileName,
-	                D3D11_INPUT_ELEMENT_DESC* inputLayout, int inputCount);
+	                D3D11_INPUT_ELEMENT_DESC* inputLayout, int inputCount, const _D3D_SHADER_MACRO* defines = nullptr);
 
 	ID3D11VertexShader* _pVertexShader;
 	ID3D11PixelShader* _pPixelShader;
@@ -1,10 +1,77 @@
 #include "Shapes.h"
 #include <cmath>
-#include "Model.h"
 #include "Graphics.h"
+#include "MeshArena.h"
 
 using namespace DirectX;
 
+namespace
+{
+	void* AllocateIndices(MeshArena& arena, MeshData& meshData, const int vertexCount, const int indexCount)
+	{
+		meshData.ShortIndices = Shapes::UseShortIndices(vertexCount);
+		if (meshData.ShortIndices)
+		{
+			return arena.Allocate<unsigned short>(indexCount);
+		}
+
+		return arena.Allocate<unsigned long>(indexCount);
+	}
+
+	template <typename Index>
+	void WriteCubeIndices(Index* indices)
+	{
+		int index = 0;
+		for (int i = 0; i < 6; ++i)
+		{
+			indices[index++] = Index(i * 4);
+			indices[index++] = Index(i * 4 + 1);
+			indices[index++] = Index(i * 4 + 3);
+
+			indices[index++] = Index(i * 4 + 1);
+			indices[index++] = Index(i * 4 + 2);
+			indices[index++] = Index(i * 4 + 3);
+		}
+	}
+
+	template <typename Index>
+	int WriteSphereIndices(Index* indices, const int sliceCount, const int stackCount, const int vertexCount)
+	{
+		int index = 0;
+		for (int i = 1; i <= sliceCount; i++)
+		{
+			indices[index++] = 0;
+			indices[index++] = Index(i + 1);
+			indices[index++] = Index(i);
+		}
+		int baseIndex = 1;
+		const int ringVertexCount = sliceCount + 1;
+		for (int i = 0; i < stackCount - 2; i++)
+		{
+			for (int j = 0; j < sliceCount; j++)
+			{
+				indices[index++] = Index(baseIndex + i * ringVertexCount + j);
+				indices[index++] = Index(baseIndex + i * ringVertexCount + j + 1);
+				indices[index++] = Index(baseIndex + (i + 1) * ringVertexCount + j);
+
+				indices[index++] = Index(baseIndex + (i + 1) * ringVertexCount + j);
+				indices[index++] = Index(baseIndex + i * ringVertexCount + j + 1);
+				indices[index++] = Index(baseIndex + (i + 1) * ringVertexCount + j + 1);
+			}
+		}
+		const int southPoleIndex = vertexCount - 1;
+		baseIndex = southPoleIndex - ringVertexCount;
+		for (int i = 0; i < sliceCount; i++)
+		{
+			indices[index++] = Index(southPoleIndex);
+			indices[index++] = Index(baseIndex + i);
+			indices[index++] = Index(baseIndex + i + 1);
+		}
+
+		return index;
+	}
+}
+
 Shapes::Shapes()
 {
 }
@@ -14,10 +81,28 @@ Shapes::~Shapes()
 {
 }
 
-void Shapes::CreateCube(MeshData& meshData, int& vertexCount, int& indexCount)
+bool Shapes::UseShortIndices(const int vertexCount)
+{
+	return vertexCount <= 0xFFFF;
+}
+
+void Shapes::GetCubeCounts(int& vertexCount, int& indexCount)
 {
 	vertexCount = 24;
 	indexCount = 36;
+}
+
+void Shapes::GetSphereCounts(const int sliceCount, const int stackCount, int& vertexCount, int& indexCount)
+{
+	// A ring of sliceCount + 1 vertices, with the seam duplicated, between each pair of stacks plus the two poles.
+	vertexCount = (stackCount - 1) * (sliceCount + 1) + 2;
+	// A triangle per slice in each polar cap and two per slice in every other stack.
+	indexCount = sliceCount * 6 * (stackCount - 1);
+}
+
+void Shapes::CreateCube(MeshArena& arena, MeshData& meshData, int& vertexCount, int& indexCount)
+{
+	GetCubeCounts(vertexCount, indexCount);
 
 	const float length = 1.0f;
 	const float width = 1.0f;
@@ -33,7 +118,7 @@ void Shapes::CreateCube(MeshData& meshData, int& vertexCount, int& indexCount)
 	XMFLOAT3 p6 = XMFLOAT3(length * .5f, width * .5f, -height * .5f);
 	XMFLOAT3 p7 = XMFLOAT3(-length * .5f, width * .5f, -height * .5f);
 
-	PosUvVertexType* vertices = new PosUvVertexType[24];
+	PosUvVertexType* vertices = arena.Allocate<PosUvVertexType>(vertexCount);
 
 	vertices[0].Position = p0;
 	vertices[1].Position = p1;
@@ -79,26 +164,26 @@ void Shapes::CreateCube(MeshData& meshData, int& vertexCount, int& indexCount)
 	}
 
 	meshData.PosUvVertexData = vertices;
+	meshData.FullVertexData = nullptr;
 
-	meshData.IndexData = new unsigned long[36];
-	int index = 0;
-	for (int i = 0; i < 6; ++i)
+	meshData.IndexData = AllocateIndices(arena, meshData, vertexCount, indexCount);
+	if (meshData.ShortIndices)
 	{
-		meshData.IndexData[index++] = i * 4;
-		meshData.IndexData[index++] = i * 4 + 1;
-		meshData.IndexData[index++] = i * 4 + 3;
-
-		meshData.IndexData[index++] = i * 4 + 1;
-		meshData.IndexData[index++] = i * 4 + 2;
-		meshData.IndexData[index++] = i * 4 + 3;
+		WriteCubeIndices(static_cast<unsigned short*>(meshData.IndexData));
+	}
+	else
+	{
+		WriteCubeIndices(static_cast<unsigned long*>(meshData.IndexData));
 	}
 }
 
-void Shapes::CreateSphere(MeshData& meshData, float radius, int sliceCount, int stackCount, int& vertexCount,
-                          int& indexCount)
+void Shapes::CreateSphere(MeshArena& arena, MeshData& meshData, float radius, int sliceCount, int stackCount,
+                          int& vertexCount, int& indexCount)
 {
-	FullVertexType* vertices = new FullVertexType[sliceCount * stackCount + 1];
-	meshData.IndexData = new unsigned long[sliceCount * 6 + (stackCount - 2) * sliceCount * 6];
+	GetSphereCounts(sliceCount, stackCount, vertexCount, indexCount);
+
+	FullVertexType* vertices = arena.Allocate<FullVertexType>(vertexCount);
+	meshData.IndexData = AllocateIndices(arena, meshData, vertexCount, indexCount);
 
 	vertices[0].Position = XMFLOAT3(0.0f, radius, 0.0f);
 	vertices[0].Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
@@ -132,40 +217,15 @@ void Shapes::CreateSphere(MeshData& meshData, float radius, int sliceCount, int
 	vertices[vertexIndex].Normal = XMFLOAT3(0.0f, -1.0f, 0.0f);
 	vertices[vertexIndex].Uv = XMFLOAT2(0.0f, 1.0f);
 
-	++vertexIndex;
+	meshData.PosUvVertexData = nullptr;
 	meshData.FullVertexData = vertices;
-	vertexCount = vertexIndex;
 
-	int index = 0;
-	for (int i = 1; i <= sliceCount; i++)
+	if (meshData.ShortIndices)
 	{
-		meshData.IndexData[index++] = 0;
-		meshData.IndexData[index++] = i + 1;
-		meshData.IndexData[index++] = i;
+		WriteSphereIndices(static_cast<unsigned short*>(meshData.IndexData), sliceCount, stackCount, vertexCount);
 	}
-	int baseIndex = 1;
-	const int ringVertexCount = sliceCount + 1;
-	for (int i = 0; i < stackCount - 2; i++)
+	else
 	{
-		for (int j = 0; j < sliceCount; j++)
-		{
-			meshData.IndexData[index++] = baseIndex + i * ringVertexCount + j;
-			meshData.IndexData[index++] = baseIndex + i * ringVertexCount + j + 1;
-			meshData.IndexData[index++] = baseIndex + (i + 1) * ringVertexCount + j;
-
-			meshData.IndexData[index++] = baseIndex + (i + 1) * ringVertexCount + j;
-			meshData.IndexData[index++] = baseIndex + i * ringVertexCount + j + 1;
-			meshData.IndexData[index++] = baseIndex + (i + 1) * ringVertexCount + j + 1;
-		}
+		WriteSphereIndices(static_cast<unsigned long*>(meshData.IndexData), sliceCount, stackCount, vertexCount);
 	}
-	const int southPoleIndex = vertexIndex - 1;
-	baseIndex = southPoleIndex - ringVertexCount;
-	for (int i = 0; i < sliceCount; i++)
-	{
-		meshData.IndexData[index++] = southPoleIndex;
-		meshData.IndexData[index++] = baseIndex + i;
-		meshData.IndexData[index++] = baseIndex + i + 1;
-	}
-
-	indexCount = index;
 }
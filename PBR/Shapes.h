@@ -1,14 +1,23 @@
 #pragma once
 
 struct MeshData;
+class MeshArena;
 
+// Builds meshes into memory taken from a caller-provided MeshArena, sized exactly from the counts below.
+// Indices are 16-bit whenever the vertex count allows it; MeshData::ShortIndices says which was used.
 class Shapes
 {
 	Shapes();
 	~Shapes();
 
 public:
-	static void CreateSphere(MeshData& meshData, float radius, int sliceCount, int stackCount, int& vertexCount,
-	                         int& indexCount);
-	static void CreateCube(MeshData& meshData, int& vertexCount, int& indexCount);
+	static void GetSphereCounts(int sliceCount, int stackCount, int& vertexCount, int& indexCount);
+	static void GetCubeCounts(int& vertexCount, int& indexCount);
+
+	static void CreateSphere(MeshArena& arena, MeshData& meshData, float radius, int sliceCount, int stackCount,
+	                         int& vertexCount, int& indexCount);
+	static void CreateCube(MeshArena& arena, MeshData& meshData, int& vertexCount, int& indexCount);
+
+	// 0xFFFF is left free, as it is the strip cut value for 16-bit indices.
+	static bool UseShortIndices(int vertexCount);
 };
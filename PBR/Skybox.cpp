@@ -1,31 +1,171 @@
 #include "Skybox.h"
 #include "Shapes.h"
+#include "MeshArena.h"
 #include <dxgiformat.h>
 #include "D3D.h"
 #include "Graphics.h"
 #include "Texture.h"
 #include "RenderTexture.h"
+#include "RenderTargetPool.h"
+#include "DepthBuffer.h"
 #include "Cubemap.h"
 #include "SkyboxShader.h"
 #include "RectToCubemapShader.h"
-#include "FrameCBuffer.h"
+#include "ViewCBuffer.h"
 #include "Camera.h"
 #include "IrradianceShader.h"
 #include "PreFilterShader.h"
 #include "IntegrateBRDFShader.h"
+#include "IBLBaker.h"
+#include "IBLCache.h"
+#include "Profiler.h"
+#include "CpuTexture.h"
+#include "DDSFile.h"
+#include "SphericalHarmonics.h"
+#include "SHCBuffer.h"
+#include "PreFilterSamples.h"
+#include "PreFilterCBuffer.h"
+#include "BrdfLut.h"
+#include "BrdfLutTable.h"
+#include "StateCache.h"
+#include "JobSystem.h"
 #include <d3d11.h>
 
 const int SkyboxSize = 2048;
 const int IrradianceSize = 32;
 const int PreFilterSize = 256;
+const int PreFilterMipLevels = 5;
 const int BrdfLookupSize = 512;
+const int BrdfSampleCount = 1024;
+
+// Filtered importance sampling reads a mip of the environment chosen per sample, so it needs far fewer samples than
+// reading the top level every time.
+const bool FilteredPreFilter = true;
+const int PreFilterSampleCount = FilteredPreFilter ? 64 : 1024;
 
 const LPCWSTR SkyboxTexture = L"environment.dds";
 
-Skybox::Skybox() = default;
+// How diffuse lighting is produced. Convolution renders Irradiance.shader into a cubemap, SphericalHarmonicsMap
+// rebuilds that cubemap from nine SH coefficients, and SphericalHarmonics hands the coefficients to PBR.shader so no
+// irradiance cubemap exists at all.
+enum class IrradianceMode
+{
+	Convolution,
+	SphericalHarmonicsMap,
+	SphericalHarmonics
+};
+
+const IrradianceMode Irradiance = IrradianceMode::SphericalHarmonics;
+
+// Where the split sum BRDF lookup table comes from. Shader renders IntegrateBRDF.shader at startup, Cpu integrates it
+// with BrdfLut, and Embedded uses the table PBRBake --brdf-header compiled into BrdfLutTable.h, so startup does no
+// work for it at all.
+enum class BrdfLookupSource
+{
+	Shader,
+	Cpu,
+	Embedded
+};
+
+const BrdfLookupSource BrdfLookup = BrdfLookupSource::Embedded;
+
+namespace
+{
+	// Takes six face targets and a matching depth buffer from the pool for one pass of the bake.
+	bool AcquireFaces(RenderTargetPool* pool, const int size, std::vector<RenderTexture*>& faces,
+	                  DepthBuffer*& depthBuffer)
+	{
+		faces.clear();
+		for (int i = 0; i < 6; ++i)
+		{
+			RenderTexture* renderTexture = pool->AcquireRenderTarget(size, size);
+			if (!renderTexture)
+			{
+				return false;
+			}
+
+			faces.push_back(renderTexture);
+		}
+
+		depthBuffer = pool->AcquireDepthBuffer(size, size);
+		return depthBuffer != nullptr;
+	}
+
+	void ReleaseFaces(RenderTargetPool* pool, std::vector<RenderTexture*>& faces, DepthBuffer*& depthBuffer)
+	{
+		for (size_t i = 0; i < faces.size(); ++i)
+		{
+			pool->Release(faces[i]);
+		}
+
+		faces.clear();
+
+		pool->Release(depthBuffer);
+		depthBuffer = nullptr;
+	}
+
+	// Describes the bake so the cache can tell when it is out of date. Sample counts match the bake shaders.
+	IBLBakeSettings CreateBakeSettings(const bool convolveIrradiance)
+	{
+		IBLBakeSettings settings;
+		settings.SkyboxSize = SkyboxSize;
+		settings.IrradianceSize = IrradianceSize;
+		settings.PreFilterSize = PreFilterSize;
+		settings.PreFilterMipLevels = PreFilterMipLevels;
+		settings.BrdfLookupSize = BrdfLookupSize;
+		settings.PreFilter = FilteredPreFilter
+			                     ? PreFilterMethod::FilteredImportanceSampling
+			                     : PreFilterMethod::ImportanceSampling;
+		settings.PreFilterSampleCount = PreFilterSampleCount;
+		settings.Irradiance = convolveIrradiance ? IrradianceMethod::Convolution : IrradianceMethod::SphericalHarmonics;
+		return settings;
+	}
+}
+
+// Bound for the sky and every lighting map until the bake replaces them, a dim grey so unbaked models are still lit.
+const float PlaceholderColour[4] = {0.2f, 0.2f, 0.2f, 1.0f};
+
+Skybox::Skybox()
+{
+	_pVertexBuffer = nullptr;
+	_pIndexBuffer = nullptr;
+	_shortIndices = false;
+	_pCubeMap = nullptr;
+	_pIrradianceMap = nullptr;
+	_pPreFilterMap = nullptr;
+	_pBrdfLUT = nullptr;
+	_pPlaceholder = nullptr;
+	_pSHBuffer = nullptr;
+	_pSkyboxShader = nullptr;
+	_pViewBuffer = nullptr;
+	_pHwnd = nullptr;
+	_pJobs = nullptr;
+	_bakeStage = BakeStage::Done;
+	_source = SourceResult();
+	_lighting = LightingResult();
+	_lightingPending = false;
+	_convolveIrradiance = Irradiance == IrradianceMode::Convolution;
+	_pBakeCamera = nullptr;
+	_pBakeViewBuffer = nullptr;
+	_pBakingPreFilter = nullptr;
+	_pPreFilterShader = nullptr;
+	_pSampleBuffer = nullptr;
+	_preFilterMip = 0;
+}
 
 Skybox::~Skybox()
 {
+	// The jobs write into this object, so they have to finish before anything goes.
+	if (_pJobs)
+	{
+		_pJobs->Wait(_sourceJobs);
+		_pJobs->Wait(_lightingJobs);
+		_pJobs->Wait(_cacheJobs);
+	}
+
+	ReleaseSource();
+	ReleaseLighting();
+
 	if (_pIndexBuffer)
 	{
 		_pIndexBuffer->Release();
@@ -44,6 +184,53 @@ Skybox::~Skybox()
 		_pSkyboxShader = nullptr;
 	}
 
+	if (_pSHBuffer)
+	{
+		delete _pSHBuffer;
+		_pSHBuffer = nullptr;
+	}
+
+	if (_pPlaceholder)
+	{
+		delete _pPlaceholder;
+		_pPlaceholder = nullptr;
+	}
+
+	if (_pBakeCamera)
+	{
+		delete _pBakeCamera;
+		_pBakeCamera = nullptr;
+	}
+
+	if (_pBakeViewBuffer)
+	{
+		delete _pBakeViewBuffer;
+		_pBakeViewBuffer = nullptr;
+	}
+
+	if (_pBakingPreFilter)
+	{
+		delete _pBakingPreFilter;
+		_pBakingPreFilter = nullptr;
+	}
+
+	if (_pPreFilterShader)
+	{
+		delete _pPreFilterShader;
+		_pPreFilterShader = nullptr;
+	}
+
+	if (_pSampleBuffer)
+	{
+		delete _pSampleBuffer;
+		_pSampleBuffer = nullptr;
+	}
+
+	ReleaseCubeMaps();
+}
+
+void Skybox::ReleaseCubeMaps()
+{
 	if (_pCubeMap)
 	{
 		delete _pCubeMap;
@@ -69,21 +256,42 @@ Skybox::~Skybox()
 	}
 }
 
-bool Skybox::Initialise(D3D* d3d, const HWND hwnd, FrameCBuffer* frameBuffer, Camera* camera)
+void Skybox::ReleaseSource()
+{
+	delete _source.CubeMap;
+	delete _source.IrradianceMap;
+	delete _source.PreFilterMap;
+	delete _source.BrdfLUT;
+	delete _source.Image;
+	_source = SourceResult();
+}
+
+void Skybox::ReleaseLighting()
+{
+	delete _lighting.IrradianceMap;
+	delete _lighting.BrdfLUT;
+	_lighting = LightingResult();
+}
+
+bool Skybox::Initialise(D3D* d3d, const HWND hwnd, ViewCBuffer* viewBuffer, JobSystem* jobs)
 {
+	PROFILE_ZONE("Skybox::Initialise");
+
 	ID3D11Device* device = d3d->GetDevice();
 	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
 	D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	_pFrameBuffer = frameBuffer;
-	_pCamera = camera;
+	_pViewBuffer = viewBuffer;
+	_pHwnd = hwnd;
+	_pJobs = jobs;
 
+	MeshArena arena;
 	MeshData meshData;
 
 	int vertexCount, indexCount;
-	Shapes::CreateCube(meshData, vertexCount, indexCount);
+	Shapes::CreateCube(arena, meshData, vertexCount, indexCount);
 
 	PosUvVertexType* vertices = meshData.PosUvVertexData;
-	unsigned long* indices = meshData.IndexData;
+	_shortIndices = meshData.ShortIndices;
 
 	// Set up the description of the static vertex buffer.
 	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -107,14 +315,14 @@ bool Skybox::Initialise(D3D* d3d, const HWND hwnd, FrameCBuffer* frameBuffer, Ca
 
 	// Set up the description of the static index buffer.
 	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long) * indexCount;
+	indexBufferDesc.ByteWidth = (_shortIndices ? sizeof(unsigned short) : sizeof(unsigned long)) * indexCount;
 	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	indexBufferDesc.CPUAccessFlags = 0;
 	indexBufferDesc.MiscFlags = 0;
 	indexBufferDesc.StructureByteStride = 0;
 
 	// Give the subresource structure a pointer to the index data.
-	indexData.pSysMem = indices;
+	indexData.pSysMem = meshData.IndexData;
 	indexData.SysMemPitch = 0;
 	indexData.SysMemSlicePitch = 0;
 
@@ -131,273 +339,644 @@ bool Skybox::Initialise(D3D* d3d, const HWND hwnd, FrameCBuffer* frameBuffer, Ca
 		return false;
 	}
 
-	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	delete[] vertices;
-	vertices = nullptr;
+	// A single texel cube stands in for the sky, irradiance and pre-filtered maps until they are baked.
+	CpuTexture placeholder;
+	placeholder.Initialise(1, 1, 1, 6);
+	for (int face = 0; face < 6; ++face)
+	{
+		float* texel = placeholder.GetPixels(face, 0);
+		for (int channel = 0; channel < CpuTexture::ChannelCount; ++channel)
+		{
+			texel[channel] = PlaceholderColour[channel];
+		}
+	}
 
-	delete[] indices;
-	indices = nullptr;
+	_pPlaceholder = new Cubemap;
+	if (!_pPlaceholder->Initialise(device, placeholder))
+	{
+		return false;
+	}
 
-	CreateCubeMap(d3d, hwnd);
+	// Disabled until the coefficients are projected, so PBR.shader samples the placeholder instead.
+	_pSHBuffer = new SHCBuffer;
+	const SHCoefficients noIrradiance = {};
+	if (!_pSHBuffer->Initialise(device) || !_pSHBuffer->Update(d3d->GetStateCache(), noIrradiance, false))
+	{
+		return false;
+	}
 
-	return true;
-}
+	// The embedded table is built in, so it is always available. The other sources replace it once they are ready.
+	_pBrdfLUT = new Texture;
+	if (!_pBrdfLUT->Initialise(device, BrdfLutTableSize, BrdfLutTableSize, BrdfLutTable))
+	{
+		return false;
+	}
 
-bool Skybox::CreateCubeMap(D3D* d3d, const HWND hwnd)
-{
-	std::vector<RenderTexture*> cubeFaces;
-	ID3D11Device* device = d3d->GetDevice();
-	ID3D11DeviceContext* deviceContext = d3d->GetDeviceContext();
+	_pBakeCamera = new Camera;
+	_pBakeCamera->Initialise(1, 1, ScreenNear, ScreenDepth);
+	_pBakeCamera->SetFOV(90.0f);
 
-	// Load initial image.
-	Texture* image = new Texture;
-	const HRESULT result = image->Initialise(device, SkyboxTexture);
-	if (!result)
+	_pBakeViewBuffer = new ViewCBuffer;
+	if (!_pBakeViewBuffer->Initialise(device))
 	{
 		return false;
 	}
 
-	// Create faces
-	for (int i = 0; i < 6; ++i)
+	// The device is free threaded, so the jobs create their textures directly. Only the passes that draw are left
+	// for Update, as the immediate context can't be shared.
+	_bakeStage = BakeStage::Loading;
+	_pJobs->RunBackground([this, device]()
 	{
-		RenderTexture* renderTexture = new RenderTexture;
-		renderTexture->Initialise(device, SkyboxSize, SkyboxSize, 1);
-		cubeFaces.push_back(renderTexture);
+		LoadSource(device);
+	}, &_sourceJobs);
+
+	if (Irradiance != IrradianceMode::Convolution)
+	{
+		_pJobs->RunBackground([this, device]()
+		{
+			CreateSphericalHarmonics(device);
+		}, &_lightingJobs);
 	}
 
-	RectToCubemapShader* shader = new RectToCubemapShader;
-	if (!shader->Initialise(device, hwnd))
+	if (BrdfLookup == BrdfLookupSource::Cpu)
 	{
-		return false;
+		_pJobs->RunBackground([this, device]()
+		{
+			CreateBrdfLookup(device);
+		}, &_lightingJobs);
 	}
 
-	BindMesh(deviceContext);
+	_lightingPending = Irradiance != IrradianceMode::Convolution || BrdfLookup == BrdfLookupSource::Cpu;
+	return true;
+}
 
-	ID3D11ShaderResourceView* srv = image->GetSRV();
-	deviceContext->PSSetShaderResources(0, 1, &srv);
+bool Skybox::Update(D3D* d3d)
+{
+	if (IsBakeComplete())
+	{
+		return true;
+	}
 
-	const float lastFov = _pCamera->GetFOV();
-	const float lastAspect = _pCamera->GetAspectRatio();
-	_pCamera->SetFOV(90.0f);
-	_pCamera->SetAspectRatio(1.0f);
+	PROFILE_ZONE("Skybox::Update");
 
-	// Render
-	for (int i = 0; i < 6; ++i)
+	if (_lightingPending && _lightingJobs.IsDone())
 	{
-		RenderTexture* texture = cubeFaces[i];
+		_lightingPending = false;
+		if (!SwapInLighting(d3d->GetStateCache()))
+		{
+			return false;
+		}
+	}
 
-		texture->SetRenderTarget(d3d, deviceContext);
-		texture->ClearRenderTarget(deviceContext, d3d->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 1.0f);
+	// A projection that failed after the environment stage, or with the maps already cached, still needs the
+	// convolution. It takes this frame's pass, and the stages carry on after.
+	if (_convolveIrradiance && !_pIrradianceMap && _pCubeMap && _bakeStage != BakeStage::Irradiance)
+	{
+		const bool result = RenderIrradianceMap(d3d);
+		d3d->SetBackBufferRenderTarget();
+		return result;
+	}
 
-		if (i == 0) _pCamera->SetRotation(0.0f, 90.0f, 0.0f); // front
-		if (i == 1) _pCamera->SetRotation(0.0f, 270.0f, 0.0f); // back
-		if (i == 2) _pCamera->SetRotation(-90.0f, 0.0f, 0.0f); // top
-		if (i == 3) _pCamera->SetRotation(90.0f, 0.0f, 0.0f); // bottom
-		if (i == 4) _pCamera->SetRotation(0.0f, 0.0f, 0.0f); // left
-		if (i == 5) _pCamera->SetRotation(0.0f, 180.0f, 0.0f); // right
+	// One stage a frame keeps each hitch down to a single pass, and the frame still draws with what is finished.
+	bool result = true;
+	switch (_bakeStage)
+	{
+	case BakeStage::Loading:
+		if (!_sourceJobs.IsDone())
+		{
+			return true;
+		}
 
-		if (!_pCamera->Render(deviceContext, _pFrameBuffer))
+		if (!SwapInSource())
 		{
 			return false;
 		}
 
-		if (!shader->Render(deviceContext, 36, _pFrameBuffer))
+		// The cache holds every map the GPU would bake.
+		_bakeStage = _pCubeMap ? BakeStage::Done : BakeStage::Environment;
+		return true;
+
+	case BakeStage::Environment:
+		result = RenderEnvironmentMap(d3d);
+		_bakeStage = _convolveIrradiance ? BakeStage::Irradiance : BakeStage::PreFilter;
+		break;
+
+	case BakeStage::Irradiance:
+		result = RenderIrradianceMap(d3d);
+		_bakeStage = BakeStage::PreFilter;
+		break;
+
+	case BakeStage::PreFilter:
+		result = RenderPreFilterMip(d3d);
+		if (_pPreFilterMap)
 		{
-			return false;
+			_bakeStage = BrdfLookup == BrdfLookupSource::Shader ? BakeStage::BrdfLookup : BakeStage::SaveCache;
+		}
+		break;
+
+	case BakeStage::BrdfLookup:
+		result = RenderBrdfLookup(d3d);
+		_bakeStage = BakeStage::SaveCache;
+		break;
+
+	case BakeStage::SaveCache:
+		// Store the results for the next launch. Failing to write the cache isn't fatal. Only the maps the GPU baked
+		// are stored, the rest are cheap to rebuild.
+		// This frame only queues the GPU copies. They are read back over the frames after and written out by a job.
+		// Whether the irradiance was convolved is part of the key, so the projection has to have finished first.
+		if (_lightingPending)
+		{
+			return true;
 		}
-	}
 
-	delete shader;
-	delete image;
+		if (_source.CacheAvailable)
+		{
+			PROFILE_ZONE("Skybox begin cache save");
+			_cache.SetSettings(CreateBakeSettings(_convolveIrradiance));
+			_cache.BeginSave(d3d->GetDevice(), d3d->GetDeviceContext(), _pCubeMap->GetTexture(),
+			                 _convolveIrradiance ? _pIrradianceMap->GetTexture() : nullptr,
+			                 _pPreFilterMap->GetTexture(),
+			                 BrdfLookup == BrdfLookupSource::Shader ? _pBrdfLUT->GetTexture() : nullptr);
+		}
 
-	_pCubeMap = new Cubemap;
-	if (!_pCubeMap->Initialise(device, deviceContext, cubeFaces, SkyboxSize, SkyboxSize, 1))
-	{
-		return false;
-	}
+		_bakeStage = BakeStage::ReadCache;
+		return true;
 
-	for (int i = 0; i < 6; ++i)
+	case BakeStage::ReadCache:
 	{
-		delete cubeFaces[i];
-		RenderTexture* renderTexture = new RenderTexture;
-		renderTexture->Initialise(device, IrradianceSize, IrradianceSize, 1);
-		cubeFaces[i] = renderTexture;
-	}
+		PROFILE_ZONE("Skybox read back cache");
+		_cache.UpdateSave(d3d->GetDeviceContext(), *_pJobs, _cacheJobs);
+		if (!_cache.IsSaving())
+		{
+			_bakeStage = BakeStage::Done;
+		}
 
-	IrradianceShader* irradianceShader = new IrradianceShader;
-	if (!irradianceShader->Initialise(device, hwnd))
-	{
-		return false;
+		return true;
 	}
 
-	srv = _pCubeMap->GetSRV();
-	deviceContext->PSSetShaderResources(0, 1, &srv);
+	case BakeStage::Done:
+		return true;
+	}
 
-	// Render
-	for (int i = 0; i < 6; ++i)
-	{
-		RenderTexture* texture = cubeFaces[i];
+	d3d->SetBackBufferRenderTarget();
+	return result;
+}
 
-		texture->SetRenderTarget(d3d, deviceContext);
-		texture->ClearRenderTarget(deviceContext, d3d->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 1.0f);
+bool Skybox::IsBakeComplete() const
+{
+	return _bakeStage == BakeStage::Done && !_lightingPending && (!_convolveIrradiance || _pIrradianceMap);
+}
 
-		if (i == 0) _pCamera->SetRotation(0.0f, 90.0f, 0.0f); // front
-		if (i == 1) _pCamera->SetRotation(0.0f, 270.0f, 0.0f); // back
-		if (i == 2) _pCamera->SetRotation(-90.0f, 0.0f, 0.0f); // top
-		if (i == 3) _pCamera->SetRotation(90.0f, 0.0f, 0.0f); // bottom
-		if (i == 4) _pCamera->SetRotation(0.0f, 0.0f, 0.0f); // left
-		if (i == 5) _pCamera->SetRotation(0.0f, 180.0f, 0.0f); // right
+void Skybox::LoadSource(ID3D11Device* device)
+{
+	PROFILE_ZONE("Skybox::LoadSource");
 
-		if (!_pCamera->Render(deviceContext, _pFrameBuffer))
+	// Skip the bake entirely if the results are already on disk.
+	const bool convolution = Irradiance == IrradianceMode::Convolution;
+	_source.CacheAvailable = _cache.Initialise(SkyboxTexture, CreateBakeSettings(convolution));
+	if (_source.CacheAvailable)
+	{
+		if (LoadCache(device, convolution))
 		{
-			return false;
+			return;
 		}
 
-		if (!irradianceShader->Render(deviceContext, 36, _pFrameBuffer))
+		// A source the projection can't read was convolved instead last time, and cached under that key.
+		if (!convolution)
 		{
-			return false;
+			_cache.SetSettings(CreateBakeSettings(true));
+			if (LoadCache(device, true))
+			{
+				return;
+			}
+
+			_cache.SetSettings(CreateBakeSettings(false));
 		}
 	}
 
-	delete irradianceShader;
+	_source.Image = new Texture;
+	_source.Loaded = _source.Image->Initialise(device, SkyboxTexture);
+}
 
-	_pIrradianceMap = new Cubemap;
-	if (!_pIrradianceMap->Initialise(device, deviceContext, cubeFaces, IrradianceSize, IrradianceSize, 1))
+bool Skybox::LoadCache(ID3D11Device* device, const bool irradiance)
+{
+	_source.CubeMap = new Cubemap;
+	_source.IrradianceMap = irradiance ? new Cubemap : nullptr;
+	_source.PreFilterMap = new Cubemap;
+	_source.BrdfLUT = BrdfLookup == BrdfLookupSource::Shader ? new Texture : nullptr;
+
+	if (_cache.Load(device, _source.CubeMap, _source.IrradianceMap, _source.PreFilterMap, _source.BrdfLUT))
 	{
-		return false;
+		_source.Loaded = true;
+		return true;
 	}
 
-	PreFilterShader* preFilterShader = new PreFilterShader;
-	if (!preFilterShader->Initialise(device, hwnd))
+	const bool cacheAvailable = _source.CacheAvailable;
+	ReleaseSource();
+	_source.CacheAvailable = cacheAvailable;
+	return false;
+}
+
+bool Skybox::SwapInSource()
+{
+	if (!_source.Loaded)
 	{
 		return false;
 	}
 
-	_pPreFilterMap = new Cubemap;
-	if (!_pPreFilterMap->Initialise(device, deviceContext, std::vector<RenderTexture*>(), PreFilterSize, PreFilterSize, 5))
+	if (_source.CubeMap)
 	{
-		return false;
+		_pCubeMap = _source.CubeMap;
+		_pIrradianceMap = _source.IrradianceMap;
+		_pPreFilterMap = _source.PreFilterMap;
+		_source.CubeMap = nullptr;
+		_source.IrradianceMap = nullptr;
+		_source.PreFilterMap = nullptr;
 	}
 
-	// Render
-	for (int mip = 0; mip < 5; ++mip)
+	if (_source.BrdfLUT)
 	{
-		const unsigned int mipWidth = unsigned int(PreFilterSize * std::pow(0.5, mip));
-		const unsigned int mipHeight = unsigned int(PreFilterSize * std::pow(0.5, mip));
+		delete _pBrdfLUT;
+		_pBrdfLUT = _source.BrdfLUT;
+		_source.BrdfLUT = nullptr;
+	}
 
-		for (int i = 0; i < 6; ++i)
+	return true;
+}
+
+void Skybox::CreateSphericalHarmonics(ID3D11Device* device)
+{
+	PROFILE_ZONE("Skybox::CreateSphericalHarmonics");
+
+	// Project the source image rather than the environment cubemap. It covers the same sphere and is already in
+	// system memory, where the cubemap would need a readback from the GPU.
+	CpuTexture equirect;
+	if (!DDSFile::Load(Texture::GetFullPath(SkyboxTexture).c_str(), equirect))
+	{
+		return;
+	}
+
+	SHCoefficients radiance;
+	SphericalHarmonics::ProjectEquirect(equirect, *_pJobs, radiance);
+	SphericalHarmonics::ConvolveIrradiance(radiance, _lighting.Irradiance);
+
+	if (Irradiance == IrradianceMode::SphericalHarmonicsMap)
+	{
+		CpuTexture irradianceMap;
+		SphericalHarmonics::CreateIrradianceMap(_lighting.Irradiance, IrradianceSize, irradianceMap);
+
+		_lighting.IrradianceMap = new Cubemap;
+		if (!_lighting.IrradianceMap->Initialise(device, irradianceMap))
 		{
-			delete cubeFaces[i];
-			RenderTexture* renderTexture = new RenderTexture;
-			renderTexture->Initialise(device, mipWidth, mipHeight, 1);
-			cubeFaces[i] = renderTexture;
+			return;
 		}
+	}
 
-		const float roughness = float(mip) / 4.0f;
-		_pFrameBuffer->SetCustomFloat(0, roughness);
+	_lighting.HarmonicsCreated = true;
+}
 
-		for (int i = 0; i < 6; ++i)
-		{
-			RenderTexture* texture = cubeFaces[i];
+void Skybox::CreateBrdfLookup(ID3D11Device* device)
+{
+	PROFILE_ZONE("Skybox::CreateBrdfLookup");
 
-			texture->SetRenderTarget(d3d, deviceContext);
-			texture->ClearRenderTarget(deviceContext, d3d->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 1.0f);
+	std::vector<float> scaleBias;
+	BrdfLut::Generate(BrdfLookupSize, BrdfSampleCount, *_pJobs, scaleBias);
 
-			if (i == 0) _pCamera->SetRotation(0.0f, 90.0f, 0.0f); // front
-			if (i == 1) _pCamera->SetRotation(0.0f, 270.0f, 0.0f); // back
-			if (i == 2) _pCamera->SetRotation(-90.0f, 0.0f, 0.0f); // top
-			if (i == 3) _pCamera->SetRotation(90.0f, 0.0f, 0.0f); // bottom
-			if (i == 4) _pCamera->SetRotation(0.0f, 0.0f, 0.0f); // left
-			if (i == 5) _pCamera->SetRotation(0.0f, 180.0f, 0.0f); // right
+	std::vector<uint16_t> texels;
+	BrdfLut::ToHalf(scaleBias, texels);
+
+	_lighting.BrdfLUT = new Texture;
+	_lighting.BrdfCreated = _lighting.BrdfLUT->Initialise(device, BrdfLookupSize, BrdfLookupSize, texels.data());
+}
 
-			if (!_pCamera->Render(deviceContext, _pFrameBuffer))
+bool Skybox::SwapInLighting(StateCache* stateCache)
+{
+	if (Irradiance != IrradianceMode::Convolution)
+	{
+		// DDSFile only reads uncompressed sources, so a block compressed sky can't be projected, and the SH map can
+		// fail to create. Neither is fatal. The irradiance is convolved on the GPU instead, and the SH constants stay
+		// disabled so PBR.shader samples that map.
+		if (!_lighting.HarmonicsCreated)
+		{
+			_convolveIrradiance = true;
+		}
+		else
+		{
+			if (_lighting.IrradianceMap)
 			{
-				return false;
+				delete _pIrradianceMap;
+				_pIrradianceMap = _lighting.IrradianceMap;
+				_lighting.IrradianceMap = nullptr;
 			}
 
-			if (!preFilterShader->Render(deviceContext, 36, _pFrameBuffer))
+			if (!_pSHBuffer->Update(stateCache, _lighting.Irradiance,
+			                        Irradiance == IrradianceMode::SphericalHarmonics))
 			{
 				return false;
 			}
 		}
+	}
+
+	if (BrdfLookup == BrdfLookupSource::Cpu)
+	{
+		if (!_lighting.BrdfCreated)
+		{
+			return false;
+		}
+
+		delete _pBrdfLUT;
+		_pBrdfLUT = _lighting.BrdfLUT;
+		_lighting.BrdfLUT = nullptr;
+	}
+
+	return true;
+}
 
-		_pPreFilterMap->Copy(deviceContext, cubeFaces, mipWidth, mipHeight, mip);
+bool Skybox::RenderFaces(D3D* d3d, const int size, const DrawFunction& draw, std::vector<RenderTexture*>& faces,
+                         DepthBuffer*& depthBuffer)
+{
+	ID3D11DeviceContext* deviceContext = d3d->GetDeviceContext();
+	StateCache* stateCache = d3d->GetStateCache();
+
+	// Targets come from the pool, so each pass and any later re-bake reuse textures of the same size.
+	if (!AcquireFaces(d3d->GetRenderTargetPool(), size, faces, depthBuffer))
+	{
+		return false;
 	}
 
-	delete preFilterShader;
+	BindMesh(stateCache);
 
 	for (int i = 0; i < 6; ++i)
 	{
-		delete cubeFaces[i];
+		RenderTexture* texture = faces[i];
+
+		texture->SetRenderTarget(d3d, deviceContext, depthBuffer);
+		texture->ClearRenderTarget(deviceContext, depthBuffer->GetDSV(), 0.0f, 0.0f, 0.0f, 1.0f);
+
+		if (i == 0) _pBakeCamera->SetRotation(0.0f, 90.0f, 0.0f); // front
+		if (i == 1) _pBakeCamera->SetRotation(0.0f, 270.0f, 0.0f); // back
+		if (i == 2) _pBakeCamera->SetRotation(-90.0f, 0.0f, 0.0f); // top
+		if (i == 3) _pBakeCamera->SetRotation(90.0f, 0.0f, 0.0f); // bottom
+		if (i == 4) _pBakeCamera->SetRotation(0.0f, 0.0f, 0.0f); // left
+		if (i == 5) _pBakeCamera->SetRotation(0.0f, 180.0f, 0.0f); // right
+
+		if (!_pBakeCamera->Render(stateCache, _pBakeViewBuffer))
+		{
+			return false;
+		}
+
+		if (!draw())
+		{
+			return false;
+		}
 	}
 
-	IntegrateBRDFShader* integrateBrdfShader = new IntegrateBRDFShader;
-	if (!integrateBrdfShader->Initialise(device, hwnd))
+	return true;
+}
+
+bool Skybox::RenderEnvironmentMap(D3D* d3d)
+{
+	// Zones time the CPU side of each pass. The GPU finishes the work later, mostly in the next Present.
+	PROFILE_ZONE("Skybox::RenderEnvironmentMap");
+
+	ID3D11Device* device = d3d->GetDevice();
+	ID3D11DeviceContext* deviceContext = d3d->GetDeviceContext();
+	StateCache* stateCache = d3d->GetStateCache();
+	std::vector<RenderTexture*> faces;
+	DepthBuffer* depthBuffer = nullptr;
+
+	RectToCubemapShader* shader = new RectToCubemapShader;
+	ID3D11ShaderResourceView* image = _source.Image->GetSRV();
+	bool result = shader->Initialise(device, _pHwnd) && RenderFaces(d3d, SkyboxSize, [&]()
 	{
-		return false;
+		stateCache->SetShaderResource(ShaderStage::Pixel, 0, image);
+		return shader->Render(stateCache, 36, _pBakeViewBuffer);
+	}, faces, depthBuffer);
+
+	delete shader;
+
+	if (result)
+	{
+		Cubemap* cubeMap = new Cubemap;
+		result = cubeMap->Initialise(device, deviceContext, faces, SkyboxSize, SkyboxSize, 1, FilteredPreFilter);
+		if (result)
+		{
+			_pCubeMap = cubeMap;
+		}
+		else
+		{
+			delete cubeMap;
+		}
 	}
 
-	_pBrdfLUT = new RenderTexture;
-	if (!_pBrdfLUT->Initialise(device, BrdfLookupSize, BrdfLookupSize, 1))
+	ReleaseFaces(d3d->GetRenderTargetPool(), faces, depthBuffer);
+
+	// The source image is only needed for this pass.
+	delete _source.Image;
+	_source.Image = nullptr;
+	return result;
+}
+
+bool Skybox::RenderIrradianceMap(D3D* d3d)
+{
+	PROFILE_ZONE("Skybox::RenderIrradianceMap");
+
+	ID3D11Device* device = d3d->GetDevice();
+	ID3D11DeviceContext* deviceContext = d3d->GetDeviceContext();
+	StateCache* stateCache = d3d->GetStateCache();
+	std::vector<RenderTexture*> faces;
+	DepthBuffer* depthBuffer = nullptr;
+
+	IrradianceShader* shader = new IrradianceShader;
+	ID3D11ShaderResourceView* environment = _pCubeMap->GetSRV();
+	bool result = shader->Initialise(device, _pHwnd) && RenderFaces(d3d, IrradianceSize, [&]()
 	{
-		return false;
+		stateCache->SetShaderResource(ShaderStage::Pixel, 0, environment);
+		return shader->Render(stateCache, 36, _pBakeViewBuffer);
+	}, faces, depthBuffer);
+
+	delete shader;
+
+	if (result)
+	{
+		Cubemap* irradianceMap = new Cubemap;
+		result = irradianceMap->Initialise(device, deviceContext, faces, IrradianceSize, IrradianceSize, 1, false);
+		if (result)
+		{
+			_pIrradianceMap = irradianceMap;
+		}
+		else
+		{
+			delete irradianceMap;
+		}
 	}
 
-	_pBrdfLUT->SetRenderTarget(d3d, deviceContext);
-	_pBrdfLUT->ClearRenderTarget(deviceContext, d3d->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 1.0f);
+	ReleaseFaces(d3d->GetRenderTargetPool(), faces, depthBuffer);
+	return result;
+}
 
-	_pCamera->SetRotation(0.0f, 0.0f, 0.0f);
-	if (!_pCamera->Render(deviceContext, _pFrameBuffer))
+bool Skybox::RenderPreFilterMip(D3D* d3d)
+{
+	PROFILE_ZONE("Skybox::RenderPreFilterMip");
+
+	ID3D11Device* device = d3d->GetDevice();
+	ID3D11DeviceContext* deviceContext = d3d->GetDeviceContext();
+	StateCache* stateCache = d3d->GetStateCache();
+
+	if (_preFilterMip == 0)
+	{
+		_pPreFilterShader = new PreFilterShader;
+		_pSampleBuffer = new PreFilterCBuffer;
+		_pBakingPreFilter = new Cubemap;
+		if (!_pPreFilterShader->Initialise(device, _pHwnd) || !_pSampleBuffer->Initialise(device) ||
+		    !_pBakingPreFilter->Initialise(device, deviceContext, std::vector<RenderTexture*>(), PreFilterSize,
+		                                   PreFilterSize, PreFilterMipLevels, false))
+		{
+			return false;
+		}
+	}
+
+	const int mip = _preFilterMip;
+	const int mipSize = PreFilterSize >> mip;
+
+	// The same table IBLBaker integrates over for this mip.
+	std::vector<PreFilterSample> samples;
+	const float roughness = float(mip) / float(PreFilterMipLevels - 1);
+	PreFilterSamples::Generate(roughness, PreFilterSampleCount, FilteredPreFilter ? SkyboxSize : 0, samples);
+	if (!_pSampleBuffer->Update(stateCache, samples))
 	{
 		return false;
 	}
 
-	if (!integrateBrdfShader->Render(deviceContext, 36, _pFrameBuffer))
+	std::vector<RenderTexture*> faces;
+	DepthBuffer* depthBuffer = nullptr;
+	ID3D11ShaderResourceView* environment = _pCubeMap->GetSRV();
+	const bool result = RenderFaces(d3d, mipSize, [&]()
+	{
+		stateCache->SetShaderResource(ShaderStage::Pixel, 0, environment);
+		return _pPreFilterShader->Render(stateCache, 36, _pBakeViewBuffer, _pSampleBuffer);
+	}, faces, depthBuffer);
+
+	if (result)
+	{
+		_pBakingPreFilter->Copy(deviceContext, faces, mipSize, mipSize, mip);
+	}
+
+	ReleaseFaces(d3d->GetRenderTargetPool(), faces, depthBuffer);
+	if (!result)
 	{
 		return false;
 	}
 
-	delete integrateBrdfShader;
+	// PBR.shader picks a mip by roughness, so the map is only swapped in once every mip is filled.
+	if (++_preFilterMip == PreFilterMipLevels)
+	{
+		_pPreFilterMap = _pBakingPreFilter;
+		_pBakingPreFilter = nullptr;
 
-	_pCamera->SetFOV(lastFov);
-	_pCamera->SetAspectRatio(lastAspect);
+		delete _pPreFilterShader;
+		_pPreFilterShader = nullptr;
 
-	// Cleanup
-	d3d->SetBackBufferRenderTarget();
+		delete _pSampleBuffer;
+		_pSampleBuffer = nullptr;
+	}
 
 	return true;
 }
 
-void Skybox::BindMesh(ID3D11DeviceContext* deviceContext) const
+bool Skybox::RenderBrdfLookup(D3D* d3d)
 {
-	unsigned int stride = sizeof(PosUvVertexType);
-	unsigned int offset = 0;
+	PROFILE_ZONE("Skybox::RenderBrdfLookup");
+
+	ID3D11Device* device = d3d->GetDevice();
+	ID3D11DeviceContext* deviceContext = d3d->GetDeviceContext();
+	StateCache* stateCache = d3d->GetStateCache();
+	RenderTargetPool* pool = d3d->GetRenderTargetPool();
+
+	IntegrateBRDFShader* shader = new IntegrateBRDFShader;
+	RenderTexture* target = pool->AcquireRenderTarget(BrdfLookupSize, BrdfLookupSize);
+	DepthBuffer* depthBuffer = pool->AcquireDepthBuffer(BrdfLookupSize, BrdfLookupSize);
+
+	bool result = target && depthBuffer && shader->Initialise(device, _pHwnd);
+	if (result)
+	{
+		target->SetRenderTarget(d3d, deviceContext, depthBuffer);
+		target->ClearRenderTarget(deviceContext, depthBuffer->GetDSV(), 0.0f, 0.0f, 0.0f, 1.0f);
+
+		BindMesh(stateCache);
+		_pBakeCamera->SetRotation(0.0f, 0.0f, 0.0f);
+		result = _pBakeCamera->Render(stateCache, _pBakeViewBuffer) && shader->Render(stateCache, 36, _pBakeViewBuffer);
+	}
+
+	delete shader;
+
+	if (result)
+	{
+		// Keep a read-only copy of the lookup table so it matches what the cache loads.
+		Texture* brdfLut = new Texture;
+		result = brdfLut->Initialise(device, deviceContext, target);
+		if (result)
+		{
+			delete _pBrdfLUT;
+			_pBrdfLUT = brdfLut;
+		}
+		else
+		{
+			delete brdfLut;
+		}
+	}
+
+	if (target)
+	{
+		pool->Release(target);
+	}
+
+	if (depthBuffer)
+	{
+		pool->Release(depthBuffer);
+	}
+
+	return result;
+}
 
-	deviceContext->IASetVertexBuffers(0, 1, &_pVertexBuffer, &stride, &offset);
-	deviceContext->IASetIndexBuffer(_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+void Skybox::BindMesh(StateCache* stateCache) const
+{
+	stateCache->SetVertexBuffer(0, _pVertexBuffer, sizeof(PosUvVertexType), 0);
+	stateCache->SetIndexBuffer(_pIndexBuffer, _shortIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT);
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
-bool Skybox::Render(ID3D11DeviceContext* deviceContext) const
+bool Skybox::Render(StateCache* stateCache) const
 {
-	BindMesh(deviceContext);
+	PROFILE_ZONE("Skybox::Render");
+
+	BindMesh(stateCache);
 
-	ID3D11ShaderResourceView* texture = _pCubeMap->GetSRV();
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	// Until the environment map is baked the sky is the placeholder's flat colour.
+	ID3D11ShaderResourceView* texture = (_pCubeMap ? _pCubeMap : _pPlaceholder)->GetSRV();
+	stateCache->SetShaderResource(ShaderStage::Pixel, 0, texture);
 
-	const bool result = _pSkyboxShader->Render(deviceContext, 36, _pFrameBuffer);
+	const bool result = _pSkyboxShader->Render(stateCache, 36, _pViewBuffer);
 	if (!result)
 	{
 		return false;
 	}
 
-	ID3D11ShaderResourceView* irradiance = _pIrradianceMap->GetSRV();
-	ID3D11ShaderResourceView* preFilter = _pPreFilterMap->GetSRV();
-	ID3D11ShaderResourceView* brdfLut = _pBrdfLUT->GetSRV();
+	BindLighting(stateCache);
+	return true;
+}
 
-	deviceContext->PSSetShaderResources(0, 1, &irradiance);
-	deviceContext->PSSetShaderResources(1, 1, &preFilter);
-	deviceContext->PSSetShaderResources(2, 1, &brdfLut);
+void Skybox::BindLighting(StateCache* stateCache) const
+{
+	// Maps still baking are lit by the placeholder. There is no irradiance map when PBR.shader evaluates the
+	// spherical harmonics itself, so the placeholder fills that slot unless the projection failed and was convolved.
+	ID3D11ShaderResourceView* irradiance = (_pIrradianceMap ? _pIrradianceMap : _pPlaceholder)->GetSRV();
+	ID3D11ShaderResourceView* preFilter = (_pPreFilterMap ? _pPreFilterMap : _pPlaceholder)->GetSRV();
+	ID3D11ShaderResourceView* brdfLut = _pBrdfLUT->GetSRV();
+	ID3D11Buffer* shBuffer = _pSHBuffer->GetBuffer();
 
-	return true;
+	stateCache->SetShaderResource(ShaderStage::Pixel, 0, irradiance);
+	stateCache->SetShaderResource(ShaderStage::Pixel, 1, preFilter);
+	stateCache->SetShaderResource(ShaderStage::Pixel, 2, brdfLut);
+	stateCache->SetConstantBuffer(ShaderStage::Pixel, 2, shBuffer);
 }
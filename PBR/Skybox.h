@@ -1,39 +1,140 @@
 #pragma once
 
+#include "IBLCache.h"
+#include "JobSystem.h"
+#include "SphericalHarmonics.h"
+#include <functional>
+#include <vector>
+
 struct HWND__;
-struct ID3D11DeviceContext;
 struct ID3D11Device;
 struct ID3D11Buffer;
-struct ID3D11Texture2D;
 class Texture;
 class D3D;
 class Cubemap;
 class SkyboxShader;
-class RectToCubemapShader;
-class FrameCBuffer;
+class PreFilterShader;
+class PreFilterCBuffer;
+class ViewCBuffer;
 class Camera;
 class RenderTexture;
+class DepthBuffer;
+class StateCache;
+class SHCBuffer;
 
+// Draws the environment and holds the image based lighting PBR.shader samples.
+// The lighting is baked in the background. Initialise only creates a constant colour placeholder, jobs load the
+// cache or source image and build the CPU side of the lighting, and Update runs the GPU passes one stage a frame.
+// Each map replaces the placeholder between frames once it is finished, so the first frame doesn't wait on the bake.
 class Skybox
 {
 public:
 	Skybox();
 	~Skybox();
 
-	bool Initialise(D3D* d3d, HWND__* hwnd, FrameCBuffer* frameBuffer, Camera* camera);
-	bool Render(ID3D11DeviceContext* deviceContext) const;
+	// The CPU side of the bake, such as the BRDF lookup and spherical harmonic projection, runs on jobs.
+	bool Initialise(D3D* d3d, HWND__* hwnd, ViewCBuffer* viewBuffer, JobSystem* jobs);
+	// Advances the bake and swaps in whatever has finished. Call before the frame draws anything, as the passes
+	// change the render target. Returns false if the bake failed.
+	bool Update(D3D* d3d);
+	bool IsBakeComplete() const;
+
+	// Draws the sky, then leaves the lighting bound for the models drawn after it.
+	bool Render(StateCache* stateCache) const;
+	// Binds the irradiance, pre-filtered and BRDF maps and the spherical harmonics that PBR.shader lights with.
+	void BindLighting(StateCache* stateCache) const;
 
 private:
-	bool CreateCubeMap(D3D* d3d, HWND__* hwnd);
-	void BindMesh(ID3D11DeviceContext* deviceContext) const;
+	typedef std::function<bool()> DrawFunction;
+
+	enum class BakeStage
+	{
+		Loading,
+		Environment,
+		Irradiance,
+		PreFilter,
+		BrdfLookup,
+		SaveCache,
+		ReadCache,
+		Done
+	};
+
+	// Written by the source job, and only read once _sourceJobs is done. Either the cached maps or the source image
+	// are loaded.
+	struct SourceResult
+	{
+		bool Loaded;
+		bool CacheAvailable;
+		Cubemap* CubeMap;
+		Cubemap* IrradianceMap;
+		Cubemap* PreFilterMap;
+		Texture* BrdfLUT;
+		Texture* Image;
+	};
+
+	// Written by the lighting jobs, and only read once _lightingJobs is done.
+	struct LightingResult
+	{
+		bool HarmonicsCreated;
+		bool BrdfCreated;
+		SHCoefficients Irradiance;
+		Cubemap* IrradianceMap;
+		Texture* BrdfLUT;
+	};
+
+	void LoadSource(ID3D11Device* device);
+	// Loads the cached maps under the cache's current key, with the irradiance map if it was convolved.
+	bool LoadCache(ID3D11Device* device, bool irradiance);
+	void CreateSphericalHarmonics(ID3D11Device* device);
+	void CreateBrdfLookup(ID3D11Device* device);
+	void ReleaseSource();
+	void ReleaseLighting();
+	bool SwapInSource();
+	bool SwapInLighting(StateCache* stateCache);
+
+	bool RenderEnvironmentMap(D3D* d3d);
+	bool RenderIrradianceMap(D3D* d3d);
+	bool RenderPreFilterMip(D3D* d3d);
+	bool RenderBrdfLookup(D3D* d3d);
+	// Calls draw for six pooled targets of the given size, with the bake camera looking down each face's axis. The
+	// caller copies the faces out and releases them.
+	bool RenderFaces(D3D* d3d, int size, const DrawFunction& draw, std::vector<RenderTexture*>& faces,
+	                 DepthBuffer*& depthBuffer);
+	void ReleaseCubeMaps();
+	void BindMesh(StateCache* stateCache) const;
 
 	ID3D11Buffer* _pVertexBuffer;
 	ID3D11Buffer* _pIndexBuffer;
+	bool _shortIndices;
 	Cubemap* _pCubeMap;
 	Cubemap* _pIrradianceMap;
 	Cubemap* _pPreFilterMap;
-	RenderTexture* _pBrdfLUT;
+	Texture* _pBrdfLUT;
+	// Bound in place of any map that isn't ready yet.
+	Cubemap* _pPlaceholder;
+	SHCBuffer* _pSHBuffer;
 	SkyboxShader* _pSkyboxShader;
-	FrameCBuffer* _pFrameBuffer;
-	Camera* _pCamera;
+	ViewCBuffer* _pViewBuffer;
+	HWND__* _pHwnd;
+	JobSystem* _pJobs;
+
+	BakeStage _bakeStage;
+	IBLCache _cache;
+	JobCounter _sourceJobs;
+	SourceResult _source;
+	JobCounter _lightingJobs;
+	LightingResult _lighting;
+	bool _lightingPending;
+	// Set for IrradianceMode::Convolution, and for the other modes if the spherical harmonics couldn't be projected.
+	bool _convolveIrradiance;
+	// Counts the job writing the cache files, which reads from _cache.
+	JobCounter _cacheJobs;
+	// The passes render through their own camera and view constants, so the scene's are left alone.
+	Camera* _pBakeCamera;
+	ViewCBuffer* _pBakeViewBuffer;
+	// Filled a mip a frame, and only swapped in once every mip is done.
+	Cubemap* _pBakingPreFilter;
+	PreFilterShader* _pPreFilterShader;
+	PreFilterCBuffer* _pSampleBuffer;
+	int _preFilterMip;
 };
@@ -0,0 +1,420 @@
+#include "SphericalHarmonics.h"
+#include "CpuTexture.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SPHERICAL_HARMONICS_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const float PI = 3.14159265359f;
+
+	// One sum per coefficient and channel.
+	const int SumCount = SHCoefficients::Count * 3;
+
+	// Rows projected by one job.
+	const int BandSize = 16;
+
+	// Normalisation constants of the real spherical harmonic basis.
+	const float Y0 = 0.282095f;
+	const float Y1 = 0.488603f;
+	const float Y2 = 1.092548f;
+	const float Y20 = 0.315392f;
+	const float Y22 = 0.546274f;
+
+	struct Float3
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	// A cube face direction before normalisation is Origin + u * UAxis + v * VAxis, with u and v in [-1, 1].
+	// These match the orientation Skybox::RenderFaces renders each face with.
+	struct FaceAxes
+	{
+		Float3 Origin;
+		Float3 UAxis;
+		Float3 VAxis;
+	};
+
+	const FaceAxes CubeFaces[6] =
+	{
+		{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f } },
+		{ { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, -1.0f, 0.0f } },
+		{ { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+		{ { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+		{ { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } },
+		{ { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } }
+	};
+
+	void GetBasis(const float x, const float y, const float z, float* basis)
+	{
+		basis[0] = Y0;
+		basis[1] = Y1 * y;
+		basis[2] = Y1 * z;
+		basis[3] = Y1 * x;
+		basis[4] = Y2 * x * y;
+		basis[5] = Y2 * y * z;
+		basis[6] = Y20 * (3.0f * z * z - 1.0f);
+		basis[7] = Y2 * x * z;
+		basis[8] = Y22 * (x * x - y * y);
+	}
+
+	void AccumulateTexel(const float x, const float y, const float z, const float weight, const float* texel,
+	                     float* sums)
+	{
+		float basis[SHCoefficients::Count];
+		GetBasis(x, y, z, basis);
+
+		for (int i = 0; i < SHCoefficients::Count; ++i)
+		{
+			const float scaled = basis[i] * weight;
+			sums[i * 3 + 0] += scaled * texel[0];
+			sums[i * 3 + 1] += scaled * texel[1];
+			sums[i * 3 + 2] += scaled * texel[2];
+		}
+	}
+
+#ifdef SPHERICAL_HARMONICS_SSE
+	// Accumulates four texels at once. Directions, weights and colours are one texel per lane.
+	void AccumulateTexels(const __m128 x, const __m128 y, const __m128 z, const __m128 weight, const __m128 r,
+	                      const __m128 g, const __m128 b, __m128* sums)
+	{
+		__m128 basis[SHCoefficients::Count];
+		basis[0] = _mm_set1_ps(Y0);
+		basis[1] = _mm_mul_ps(_mm_set1_ps(Y1), y);
+		basis[2] = _mm_mul_ps(_mm_set1_ps(Y1), z);
+		basis[3] = _mm_mul_ps(_mm_set1_ps(Y1), x);
+		basis[4] = _mm_mul_ps(_mm_set1_ps(Y2), _mm_mul_ps(x, y));
+		basis[5] = _mm_mul_ps(_mm_set1_ps(Y2), _mm_mul_ps(y, z));
+		basis[6] = _mm_mul_ps(_mm_set1_ps(Y20), _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(z, z)),
+		                                                   _mm_set1_ps(1.0f)));
+		basis[7] = _mm_mul_ps(_mm_set1_ps(Y2), _mm_mul_ps(x, z));
+		basis[8] = _mm_mul_ps(_mm_set1_ps(Y22), _mm_sub_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+
+		for (int i = 0; i < SHCoefficients::Count; ++i)
+		{
+			const __m128 scaled = _mm_mul_ps(basis[i], weight);
+			sums[i * 3 + 0] = _mm_add_ps(sums[i * 3 + 0], _mm_mul_ps(scaled, r));
+			sums[i * 3 + 1] = _mm_add_ps(sums[i * 3 + 1], _mm_mul_ps(scaled, g));
+			sums[i * 3 + 2] = _mm_add_ps(sums[i * 3 + 2], _mm_mul_ps(scaled, b));
+		}
+	}
+
+	// Loads four RGBA texels and returns them as one register per channel.
+	void LoadTexels(const float* texels, __m128& r, __m128& g, __m128& b)
+	{
+		__m128 t0 = _mm_loadu_ps(texels);
+		__m128 t1 = _mm_loadu_ps(texels + 4);
+		__m128 t2 = _mm_loadu_ps(texels + 8);
+		__m128 t3 = _mm_loadu_ps(texels + 12);
+		_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+		r = t0;
+		g = t1;
+		b = t2;
+	}
+
+	float HorizontalSum(const __m128 value)
+	{
+		float lanes[4];
+		_mm_storeu_ps(lanes, value);
+		return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+#endif
+
+	// Per band running totals. Rows are summed in single precision and added here in double precision so large
+	// sources don't lose the contribution of dim texels.
+	struct Accumulator
+	{
+		double Sums[SumCount];
+		double Weight;
+	};
+
+	void AddRow(Accumulator& accumulator, const float* rowSums, const double rowWeight)
+	{
+		for (int i = 0; i < SumCount; ++i)
+		{
+			accumulator.Sums[i] += rowSums[i];
+		}
+
+		accumulator.Weight += rowWeight;
+	}
+
+	void ProjectCubeRow(const CpuTexture& cubemap, const int mip, const int face, const int y, Accumulator& accumulator)
+	{
+		const int size = cubemap.GetWidth(mip);
+		const float* texels = cubemap.GetPixels(face, mip) + size_t(y) * size * CpuTexture::ChannelCount;
+		const FaceAxes& axes = CubeFaces[face];
+
+		// Everything that only depends on the row.
+		const float texelSize = 2.0f / float(size);
+		const float v = (float(y) + 0.5f) * texelSize - 1.0f;
+		const Float3 rowOrigin = { axes.Origin.x + v * axes.VAxis.x, axes.Origin.y + v * axes.VAxis.y,
+		                           axes.Origin.z + v * axes.VAxis.z };
+		const float texelArea = texelSize * texelSize;
+
+		float rowSums[SumCount] = {};
+		double rowWeight = 0.0;
+		int x = 0;
+
+#ifdef SPHERICAL_HARMONICS_SSE
+		__m128 sums[SumCount];
+		for (int i = 0; i < SumCount; ++i)
+		{
+			sums[i] = _mm_setzero_ps();
+		}
+
+		__m128 weights = _mm_setzero_ps();
+		const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		for (; x + 4 <= size; x += 4)
+		{
+			const __m128 u = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(x)), laneOffsets),
+			                                       _mm_set1_ps(texelSize)), one);
+
+			const __m128 dx = _mm_add_ps(_mm_set1_ps(rowOrigin.x), _mm_mul_ps(u, _mm_set1_ps(axes.UAxis.x)));
+			const __m128 dy = _mm_add_ps(_mm_set1_ps(rowOrigin.y), _mm_mul_ps(u, _mm_set1_ps(axes.UAxis.y)));
+			const __m128 dz = _mm_add_ps(_mm_set1_ps(rowOrigin.z), _mm_mul_ps(u, _mm_set1_ps(axes.UAxis.z)));
+
+			// The solid angle of a texel is its area divided by the cube of its distance from the centre.
+			const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+			                                        _mm_mul_ps(dz, dz));
+			const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+			const __m128 weight = _mm_mul_ps(_mm_set1_ps(texelArea),
+			                                 _mm_mul_ps(invLength, _mm_mul_ps(invLength, invLength)));
+
+			__m128 r, g, b;
+			LoadTexels(texels + size_t(x) * CpuTexture::ChannelCount, r, g, b);
+
+			AccumulateTexels(_mm_mul_ps(dx, invLength), _mm_mul_ps(dy, invLength), _mm_mul_ps(dz, invLength), weight,
+			                 r, g, b, sums);
+			weights = _mm_add_ps(weights, weight);
+		}
+
+		for (int i = 0; i < SumCount; ++i)
+		{
+			rowSums[i] = HorizontalSum(sums[i]);
+		}
+
+		rowWeight = HorizontalSum(weights);
+#endif
+
+		// Whatever doesn't fill a full vector.
+		for (; x < size; ++x)
+		{
+			const float u = (float(x) + 0.5f) * texelSize - 1.0f;
+			const float dx = rowOrigin.x + u * axes.UAxis.x;
+			const float dy = rowOrigin.y + u * axes.UAxis.y;
+			const float dz = rowOrigin.z + u * axes.UAxis.z;
+			const float invLength = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+			const float weight = texelArea * invLength * invLength * invLength;
+
+			AccumulateTexel(dx * invLength, dy * invLength, dz * invLength, weight,
+			                texels + size_t(x) * CpuTexture::ChannelCount, rowSums);
+			rowWeight += weight;
+		}
+
+		AddRow(accumulator, rowSums, rowWeight);
+	}
+
+	void ProjectEquirectRow(const CpuTexture& equirect, const int y, const std::vector<float>& cosPhi,
+	                        const std::vector<float>& sinPhi, Accumulator& accumulator)
+	{
+		const int width = equirect.GetWidth();
+		const int height = equirect.GetHeight();
+		const float* texels = equirect.GetPixels(0, 0) + size_t(y) * width * CpuTexture::ChannelCount;
+
+		// RectToCubemap.shader maps asin(direction.y) to v, so each row is a line of latitude.
+		const float latitude = ((float(y) + 0.5f) / float(height) - 0.5f) * PI;
+		const float dy = std::sin(latitude);
+		const float cosLatitude = std::cos(latitude);
+		const float weight = cosLatitude * (2.0f * PI / float(width)) * (PI / float(height));
+
+		float rowSums[SumCount] = {};
+		int x = 0;
+
+#ifdef SPHERICAL_HARMONICS_SSE
+		__m128 sums[SumCount];
+		for (int i = 0; i < SumCount; ++i)
+		{
+			sums[i] = _mm_setzero_ps();
+		}
+
+		const __m128 weights = _mm_set1_ps(weight);
+		const __m128 dyLanes = _mm_set1_ps(dy);
+		const __m128 cosLatitudeLanes = _mm_set1_ps(cosLatitude);
+
+		for (; x + 4 <= width; x += 4)
+		{
+			const __m128 dx = _mm_mul_ps(cosLatitudeLanes, _mm_loadu_ps(cosPhi.data() + x));
+			const __m128 dz = _mm_mul_ps(cosLatitudeLanes, _mm_loadu_ps(sinPhi.data() + x));
+
+			__m128 r, g, b;
+			LoadTexels(texels + size_t(x) * CpuTexture::ChannelCount, r, g, b);
+
+			AccumulateTexels(dx, dyLanes, dz, weights, r, g, b, sums);
+		}
+
+		for (int i = 0; i < SumCount; ++i)
+		{
+			rowSums[i] = HorizontalSum(sums[i]);
+		}
+#endif
+
+		for (; x < width; ++x)
+		{
+			AccumulateTexel(cosLatitude * cosPhi[x], dy, cosLatitude * sinPhi[x], weight,
+			                texels + size_t(x) * CpuTexture::ChannelCount, rowSums);
+		}
+
+		AddRow(accumulator, rowSums, double(weight) * width);
+	}
+
+	// Projects bands of rows as jobs, then combines the per-band totals in order, so the result doesn't depend on
+	// the number of threads.
+	template <typename RowFunction>
+	void ProjectRows(const int rowCount, JobSystem& jobs, const RowFunction& projectRow, SHCoefficients& radiance)
+	{
+		const int bandCount = (rowCount + BandSize - 1) / BandSize;
+		std::vector<Accumulator> accumulators(bandCount, Accumulator());
+		jobs.ParallelFor(rowCount, BandSize, [&](const int first, const int last)
+		{
+			Accumulator& accumulator = accumulators[first / BandSize];
+			for (int row = first; row < last; ++row)
+			{
+				projectRow(row, accumulator);
+			}
+		});
+
+		Accumulator total = Accumulator();
+		for (int i = 0; i < bandCount; ++i)
+		{
+			for (int j = 0; j < SumCount; ++j)
+			{
+				total.Sums[j] += accumulators[i].Sums[j];
+			}
+
+			total.Weight += accumulators[i].Weight;
+		}
+
+		// The discrete weights don't sum to exactly 4 PI, so rescale them to cover the sphere.
+		const double scale = total.Weight > 0.0 ? 4.0 * double(PI) / total.Weight : 0.0;
+		for (int i = 0; i < SHCoefficients::Count; ++i)
+		{
+			radiance.Values[i][0] = float(total.Sums[i * 3 + 0] * scale);
+			radiance.Values[i][1] = float(total.Sums[i * 3 + 1] * scale);
+			radiance.Values[i][2] = float(total.Sums[i * 3 + 2] * scale);
+			radiance.Values[i][3] = 0.0f;
+		}
+	}
+}
+
+SphericalHarmonics::SphericalHarmonics() = default;
+
+SphericalHarmonics::~SphericalHarmonics()
+{
+}
+
+void SphericalHarmonics::ProjectCubemap(const CpuTexture& cubemap, const int mip, JobSystem& jobs,
+                                        SHCoefficients& radiance)
+{
+	const int size = cubemap.GetHeight(mip);
+	ProjectRows(size * 6, jobs, [&](const int row, Accumulator& accumulator)
+	{
+		ProjectCubeRow(cubemap, mip, row / size, row % size, accumulator);
+	}, radiance);
+}
+
+void SphericalHarmonics::ProjectEquirect(const CpuTexture& equirect, JobSystem& jobs, SHCoefficients& radiance)
+{
+	// Longitude only depends on the column, so its sine and cosine are shared by every row.
+	const int width = equirect.GetWidth();
+	std::vector<float> cosPhi(width);
+	std::vector<float> sinPhi(width);
+	for (int x = 0; x < width; ++x)
+	{
+		const float phi = ((float(x) + 0.5f) / float(width) - 0.5f) * 2.0f * PI;
+		cosPhi[x] = std::cos(phi);
+		sinPhi[x] = std::sin(phi);
+	}
+
+	ProjectRows(equirect.GetHeight(), jobs, [&](const int row, Accumulator& accumulator)
+	{
+		ProjectEquirectRow(equirect, row, cosPhi, sinPhi, accumulator);
+	}, radiance);
+}
+
+void SphericalHarmonics::ConvolveIrradiance(const SHCoefficients& radiance, SHCoefficients& irradiance)
+{
+	// Cosine lobe band factors (PI, 2 PI / 3, PI / 4), divided through by PI.
+	const float bandScale[SHCoefficients::Count] =
+	{
+		1.0f,
+		2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+		0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+	};
+
+	for (int i = 0; i < SHCoefficients::Count; ++i)
+	{
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			irradiance.Values[i][channel] = radiance.Values[i][channel] * bandScale[i];
+		}
+	}
+}
+
+void SphericalHarmonics::Evaluate(const SHCoefficients& coefficients, const float x, const float y, const float z,
+                                  float* rgb)
+{
+	float basis[SHCoefficients::Count];
+	GetBasis(x, y, z, basis);
+
+	rgb[0] = rgb[1] = rgb[2] = 0.0f;
+	for (int i = 0; i < SHCoefficients::Count; ++i)
+	{
+		rgb[0] += coefficients.Values[i][0] * basis[i];
+		rgb[1] += coefficients.Values[i][1] * basis[i];
+		rgb[2] += coefficients.Values[i][2] * basis[i];
+	}
+}
+
+void SphericalHarmonics::CreateIrradianceMap(const SHCoefficients& irradiance, const int size, CpuTexture& cubemap)
+{
+	cubemap.Initialise(size, size, 1, 6);
+
+	const float texelSize = 2.0f / float(size);
+	for (int face = 0; face < 6; ++face)
+	{
+		const FaceAxes& axes = CubeFaces[face];
+		float* pixels = cubemap.GetPixels(face, 0);
+
+		for (int y = 0; y < size; ++y)
+		{
+			const float v = (float(y) + 0.5f) * texelSize - 1.0f;
+			for (int x = 0; x < size; ++x)
+			{
+				const float u = (float(x) + 0.5f) * texelSize - 1.0f;
+				const float dx = axes.Origin.x + u * axes.UAxis.x + v * axes.VAxis.x;
+				const float dy = axes.Origin.y + u * axes.UAxis.y + v * axes.VAxis.y;
+				const float dz = axes.Origin.z + u * axes.UAxis.z + v * axes.VAxis.z;
+				const float invLength = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+
+				float* pixel = pixels + (size_t(y) * size + x) * CpuTexture::ChannelCount;
+				Evaluate(irradiance, dx * invLength, dy * invLength, dz * invLength, pixel);
+
+				// Ringing in the truncated expansion can dip below zero opposite very bright sources.
+				pixel[0] = std::max(pixel[0], 0.0f);
+				pixel[1] = std::max(pixel[1], 0.0f);
+				pixel[2] = std::max(pixel[2], 0.0f);
+				pixel[3] = 1.0f;
+			}
+		}
+	}
+}
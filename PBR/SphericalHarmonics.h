@@ -0,0 +1,38 @@
+#pragma once
+
+class CpuTexture;
+class JobSystem;
+
+// RGB coefficients of an order 3 (L2) spherical harmonic expansion, nine per channel.
+// The fourth component is unused so the array can be copied straight into a float4[9] constant buffer.
+struct SHCoefficients
+{
+	static const int Count = 9;
+
+	float Values[Count][4];
+};
+
+// Spherical harmonic projection of environment lighting.
+// Projecting the environment once and convolving the nine coefficients with the cosine lobe gives the same diffuse
+// irradiance as Irradiance.shader to within the L2 approximation error, in milliseconds rather than seconds.
+// Projection is vectorised four texels at a time and split into bands of rows that run as jobs.
+class SphericalHarmonics
+{
+	SphericalHarmonics();
+	~SphericalHarmonics();
+
+public:
+	// Projects radiance, weighting each cube texel by its solid angle. Faces are expected in D3D11 order.
+	static void ProjectCubemap(const CpuTexture& cubemap, int mip, JobSystem& jobs, SHCoefficients& radiance);
+	// Projects radiance from a latitude-longitude image laid out the way RectToCubemap.shader samples it.
+	static void ProjectEquirect(const CpuTexture& equirect, JobSystem& jobs, SHCoefficients& radiance);
+
+	// Convolves radiance with the clamped cosine lobe. The result is scaled by 1 / PI so that it matches the values
+	// Irradiance.shader stores, and can be multiplied by albedo directly.
+	static void ConvolveIrradiance(const SHCoefficients& radiance, SHCoefficients& irradiance);
+
+	static void Evaluate(const SHCoefficients& coefficients, float x, float y, float z, float* rgb);
+
+	// Rebuilds an irradiance cubemap from convolved coefficients.
+	static void CreateIrradianceMap(const SHCoefficients& irradiance, int size, CpuTexture& cubemap);
+};
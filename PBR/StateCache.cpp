@@ -0,0 +1,368 @@
+#include "StateCache.h"
+
+StateCache::StateCache()
+{
+	_pTarget = nullptr;
+	_stats.Requested = 0;
+	_stats.Forwarded = 0;
+	_stats.Elided = 0;
+
+	for (int stage = 0; stage < StageCount; ++stage)
+	{
+		for (int type = 0; type < SlotTypeCount; ++type)
+		{
+			SlotState& state = _slots[stage][type];
+			for (int i = 0; i < SlotCount; ++i)
+			{
+				state.Bound[i] = Binding();
+				state.Pending[i] = Binding();
+			}
+		}
+	}
+
+	Invalidate();
+}
+
+StateCache::~StateCache()
+{
+}
+
+void StateCache::Initialise(StateTarget* target)
+{
+	_pTarget = target;
+	Invalidate();
+}
+
+void StateCache::Invalidate()
+{
+	_pLayout = nullptr;
+	_pVertexShader = nullptr;
+	_pPixelShader = nullptr;
+	_pIndexBuffer = nullptr;
+	_indexFormat = 0;
+	_topology = 0;
+
+	_layoutKnown = false;
+	_vertexShaderKnown = false;
+	_pixelShaderKnown = false;
+	_indexBufferKnown = false;
+	_topologyKnown = false;
+
+	for (int i = 0; i < SlotCount; ++i)
+	{
+		_pVertexBuffers[i] = nullptr;
+		_vertexStrides[i] = 0;
+		_vertexOffsets[i] = 0;
+		_vertexBufferKnown[i] = false;
+	}
+
+	// Pending bindings are kept, as they are still what the next draw wants, and every slot is checked again then.
+	for (int stage = 0; stage < StageCount; ++stage)
+	{
+		for (int type = 0; type < SlotTypeCount; ++type)
+		{
+			SlotState& state = _slots[stage][type];
+			for (int i = 0; i < SlotCount; ++i)
+			{
+				state.Known[i] = false;
+			}
+
+			state.DirtyStart = 0;
+			state.DirtyEnd = SlotCount;
+		}
+	}
+}
+
+void StateCache::SetInputLayout(ID3D11InputLayout* layout)
+{
+	++_stats.Requested;
+	if (_layoutKnown && layout == _pLayout)
+	{
+		return;
+	}
+
+	_pLayout = layout;
+	_layoutKnown = true;
+	_pTarget->SetInputLayout(layout);
+	++_stats.Forwarded;
+}
+
+void StateCache::SetVertexShader(ID3D11VertexShader* shader)
+{
+	++_stats.Requested;
+	if (_vertexShaderKnown && shader == _pVertexShader)
+	{
+		return;
+	}
+
+	_pVertexShader = shader;
+	_vertexShaderKnown = true;
+	_pTarget->SetVertexShader(shader);
+	++_stats.Forwarded;
+}
+
+void StateCache::SetPixelShader(ID3D11PixelShader* shader)
+{
+	++_stats.Requested;
+	if (_pixelShaderKnown && shader == _pPixelShader)
+	{
+		return;
+	}
+
+	_pPixelShader = shader;
+	_pixelShaderKnown = true;
+	_pTarget->SetPixelShader(shader);
+	++_stats.Forwarded;
+}
+
+void StateCache::SetVertexBuffer(const int slot, ID3D11Buffer* buffer, const unsigned int stride,
+                                 const unsigned int offset)
+{
+	++_stats.Requested;
+	if (slot < SlotCount)
+	{
+		if (_vertexBufferKnown[slot] && buffer == _pVertexBuffers[slot] && stride == _vertexStrides[slot] &&
+		    offset == _vertexOffsets[slot])
+		{
+			return;
+		}
+
+		_pVertexBuffers[slot] = buffer;
+		_vertexStrides[slot] = stride;
+		_vertexOffsets[slot] = offset;
+		_vertexBufferKnown[slot] = true;
+	}
+
+	_pTarget->SetVertexBuffer(slot, buffer, stride, offset);
+	++_stats.Forwarded;
+}
+
+void StateCache::SetIndexBuffer(ID3D11Buffer* buffer, const int format)
+{
+	++_stats.Requested;
+	if (_indexBufferKnown && buffer == _pIndexBuffer && format == _indexFormat)
+	{
+		return;
+	}
+
+	_pIndexBuffer = buffer;
+	_indexFormat = format;
+	_indexBufferKnown = true;
+	_pTarget->SetIndexBuffer(buffer, format);
+	++_stats.Forwarded;
+}
+
+void StateCache::SetPrimitiveTopology(const int topology)
+{
+	++_stats.Requested;
+	if (_topologyKnown && topology == _topology)
+	{
+		return;
+	}
+
+	_topology = topology;
+	_topologyKnown = true;
+	_pTarget->SetPrimitiveTopology(topology);
+	++_stats.Forwarded;
+}
+
+void StateCache::SetConstantBuffer(const ShaderStage stage, const int slot, ID3D11Buffer* buffer)
+{
+	SetConstantBuffer(stage, slot, buffer, 0, 0);
+}
+
+void StateCache::SetConstantBuffer(const ShaderStage stage, const int slot, ID3D11Buffer* buffer,
+                                   const unsigned int firstConstant, const unsigned int constantCount)
+{
+	Binding binding;
+	binding.Resource = buffer;
+	binding.FirstConstant = firstConstant;
+	binding.ConstantCount = constantCount;
+	SetSlot(stage, ConstantBufferSlots, slot, binding);
+}
+
+void StateCache::SetShaderResource(const ShaderStage stage, const int slot, ID3D11ShaderResourceView* view)
+{
+	Binding binding;
+	binding.Resource = view;
+	binding.FirstConstant = 0;
+	binding.ConstantCount = 0;
+	SetSlot(stage, ShaderResourceSlots, slot, binding);
+}
+
+void StateCache::SetSampler(const ShaderStage stage, const int slot, ID3D11SamplerState* sampler)
+{
+	Binding binding;
+	binding.Resource = sampler;
+	binding.FirstConstant = 0;
+	binding.ConstantCount = 0;
+	SetSlot(stage, SamplerSlots, slot, binding);
+}
+
+void* StateCache::Map(ID3D11Buffer* buffer, const unsigned int size)
+{
+	return _pTarget->Map(buffer, size);
+}
+
+void StateCache::Unmap(ID3D11Buffer* buffer)
+{
+	_pTarget->Unmap(buffer);
+}
+
+CommandList* StateCache::CreateCommandList()
+{
+	return _pTarget->CreateCommandList();
+}
+
+void StateCache::ExecuteCommandList(CommandList* commandList)
+{
+	_pTarget->ExecuteCommandList(commandList);
+}
+
+void StateCache::DrawIndexed(const int indexCount, const int startIndex)
+{
+	FlushSlots();
+	_pTarget->DrawIndexed(indexCount, startIndex);
+}
+
+void StateCache::DrawIndexedInstanced(const int indexCount, const int instanceCount, const int startIndex,
+                                      const int startInstance)
+{
+	FlushSlots();
+	_pTarget->DrawIndexedInstanced(indexCount, instanceCount, startIndex, startInstance);
+}
+
+StateCacheStats StateCache::GetStats() const
+{
+	StateCacheStats stats = _stats;
+	stats.Elided = stats.Requested - stats.Forwarded;
+	return stats;
+}
+
+void StateCache::SetSlot(const ShaderStage stage, const SlotType type, const int slot, const Binding& binding)
+{
+	++_stats.Requested;
+
+	// Slots past the cached range are rare enough to send straight through.
+	if (slot >= SlotCount)
+	{
+		ForwardSlots(stage, type, slot, 1, &binding);
+		return;
+	}
+
+	SlotState& state = _slots[int(stage)][type];
+	state.Pending[slot] = binding;
+	if (state.DirtyStart > slot)
+	{
+		state.DirtyStart = slot;
+	}
+
+	if (state.DirtyEnd < slot + 1)
+	{
+		state.DirtyEnd = slot + 1;
+	}
+}
+
+void StateCache::FlushSlots()
+{
+	for (int stage = 0; stage < StageCount; ++stage)
+	{
+		for (int type = 0; type < SlotTypeCount; ++type)
+		{
+			SlotState& state = _slots[stage][type];
+			if (state.DirtyStart < state.DirtyEnd)
+			{
+				FlushSlots(ShaderStage(stage), SlotType(type), state);
+			}
+		}
+	}
+}
+
+void StateCache::FlushSlots(const ShaderStage stage, const SlotType type, SlotState& state)
+{
+	int slot = state.DirtyStart;
+	while (slot < state.DirtyEnd)
+	{
+		if (!IsChanged(state, slot))
+		{
+			++slot;
+			continue;
+		}
+
+		// Extend the run over following changed slots. Offset and whole constant buffer bindings go in separate
+		// calls, as one call binds either every buffer by offset or none.
+		const bool offsets = state.Pending[slot].ConstantCount != 0;
+		int end = slot + 1;
+		while (end < state.DirtyEnd && (state.Pending[end].ConstantCount != 0) == offsets && IsChanged(state, end))
+		{
+			++end;
+		}
+
+		ForwardSlots(stage, type, slot, end - slot, &state.Pending[slot]);
+
+		for (int i = slot; i < end; ++i)
+		{
+			state.Bound[i] = state.Pending[i];
+			state.Known[i] = true;
+		}
+
+		slot = end;
+	}
+
+	state.DirtyStart = SlotCount;
+	state.DirtyEnd = 0;
+}
+
+bool StateCache::IsChanged(const SlotState& state, const int slot)
+{
+	// An unknown slot is only sent when something is wanted in it.
+	if (!state.Known[slot])
+	{
+		return state.Pending[slot].Resource != nullptr;
+	}
+
+	return !(state.Pending[slot] == state.Bound[slot]);
+}
+
+void StateCache::ForwardSlots(const ShaderStage stage, const SlotType type, const int startSlot, const int count,
+                              const Binding* bindings)
+{
+	if (type == ConstantBufferSlots)
+	{
+		ID3D11Buffer* buffers[SlotCount];
+		unsigned int firstConstants[SlotCount];
+		unsigned int constantCounts[SlotCount];
+		for (int i = 0; i < count; ++i)
+		{
+			buffers[i] = static_cast<ID3D11Buffer*>(bindings[i].Resource);
+			firstConstants[i] = bindings[i].FirstConstant;
+			constantCounts[i] = bindings[i].ConstantCount;
+		}
+
+		const bool offsets = bindings[0].ConstantCount != 0;
+		_pTarget->SetConstantBuffers(stage, startSlot, count, buffers, offsets ? firstConstants : nullptr,
+		                             offsets ? constantCounts : nullptr);
+	}
+	else if (type == ShaderResourceSlots)
+	{
+		ID3D11ShaderResourceView* views[SlotCount];
+		for (int i = 0; i < count; ++i)
+		{
+			views[i] = static_cast<ID3D11ShaderResourceView*>(bindings[i].Resource);
+		}
+
+		_pTarget->SetShaderResources(stage, startSlot, count, views);
+	}
+	else
+	{
+		ID3D11SamplerState* samplers[SlotCount];
+		for (int i = 0; i < count; ++i)
+		{
+			samplers[i] = static_cast<ID3D11SamplerState*>(bindings[i].Resource);
+		}
+
+		_pTarget->SetSamplers(stage, startSlot, count, samplers);
+	}
+
+	++_stats.Forwarded;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+struct ID3D11Buffer;
+struct ID3D11InputLayout;
+struct ID3D11PixelShader;
+struct ID3D11SamplerState;
+struct ID3D11ShaderResourceView;
+struct ID3D11VertexShader;
+
+enum class ShaderStage
+{
+	Vertex,
+	Pixel
+};
+
+class CommandList;
+
+// Receives the state changes, buffer writes and draws that get through a StateCache.
+// D3D11StateTarget forwards them to a device context. NullStateTarget only counts and records them, so everything
+// drawn through the cache can run on machines without a GPU.
+// Format and topology are the backend's own values, a DXGI_FORMAT and D3D11_PRIMITIVE_TOPOLOGY for D3D11.
+class StateTarget
+{
+public:
+	virtual ~StateTarget()
+	{
+	}
+
+	virtual void SetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void SetVertexShader(ID3D11VertexShader* shader) = 0;
+	virtual void SetPixelShader(ID3D11PixelShader* shader) = 0;
+	virtual void SetVertexBuffer(int slot, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) = 0;
+	virtual void SetIndexBuffer(ID3D11Buffer* buffer, int format) = 0;
+	virtual void SetPrimitiveTopology(int topology) = 0;
+	// firstConstants and constantCounts are null when every buffer is bound whole.
+	virtual void SetConstantBuffers(ShaderStage stage, int startSlot, int count, ID3D11Buffer* const* buffers,
+	                                const unsigned int* firstConstants, const unsigned int* constantCounts) = 0;
+	virtual void SetShaderResources(ShaderStage stage, int startSlot, int count,
+	                                ID3D11ShaderResourceView* const* views) = 0;
+	virtual void SetSamplers(ShaderStage stage, int startSlot, int count, ID3D11SamplerState* const* samplers) = 0;
+	// Maps a dynamic buffer for writing, discarding its contents. size is the number of bytes that will be written.
+	// Returns nullptr on failure.
+	virtual void* Map(ID3D11Buffer* buffer, unsigned int size) = 0;
+	virtual void Unmap(ID3D11Buffer* buffer) = 0;
+	virtual void DrawIndexed(int indexCount, int startIndex) = 0;
+	virtual void DrawIndexedInstanced(int indexCount, int instanceCount, int startIndex, int startInstance) = 0;
+
+	// Creates a list that records for this target on another thread, or returns nullptr if that isn't supported.
+	virtual CommandList* CreateCommandList() = 0;
+	// Plays back a list created by this target whose recording has ended. Leaves this target's state as it was.
+	virtual void ExecuteCommandList(CommandList* commandList) = 0;
+};
+
+// Draws recorded through its own target, on any thread, to be executed on the target that created it later.
+// Begin and execution belong to the thread that owns the creating target, End and the recording itself to any one
+// thread at a time. Each recording starts from default state, apart from the render targets, viewports and raster
+// state, which are copied from the creating target by Begin. A StateCache recording into the list must be
+// invalidated after each Begin.
+class CommandList
+{
+public:
+	virtual ~CommandList()
+	{
+	}
+
+	virtual StateTarget* GetTarget() = 0;
+	// Starts a new recording, dropping the last one.
+	virtual bool Begin() = 0;
+	virtual bool End() = 0;
+};
+
+struct StateCacheStats
+{
+	// State changes asked of the cache, and the calls that were made on the target for them. Slots that were set
+	// separately but sent in one call, and sets that changed nothing, are counted as elided.
+	unsigned long long Requested;
+	unsigned long long Forwarded;
+	unsigned long long Elided;
+};
+
+// Sits between the renderer and the device context, dropping state changes that wouldn't change anything.
+// Shaders, input layout and input assembler state are filtered as they are set. Constant buffer, shader resource
+// and sampler slots are held until the next draw, then each contiguous run of changed slots goes out in one call.
+// Anything that changes device state behind the cache's back must be followed by Invalidate, as must render target
+// changes, which can silently unbind shader resources.
+class StateCache
+{
+public:
+	static const int SlotCount = 16;
+
+	StateCache();
+	~StateCache();
+
+	void Initialise(StateTarget* target);
+	// Forgets what is bound, so the next change to each piece of state is forwarded whatever it is.
+	void Invalidate();
+
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetVertexBuffer(int slot, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(ID3D11Buffer* buffer, int format);
+	void SetPrimitiveTopology(int topology);
+	void SetConstantBuffer(ShaderStage stage, int slot, ID3D11Buffer* buffer);
+	// Binds constantCount 16 byte constants of the buffer, starting from firstConstant.
+	void SetConstantBuffer(ShaderStage stage, int slot, ID3D11Buffer* buffer, unsigned int firstConstant,
+	                       unsigned int constantCount);
+	void SetShaderResource(ShaderStage stage, int slot, ID3D11ShaderResourceView* view);
+	void SetSampler(ShaderStage stage, int slot, ID3D11SamplerState* sampler);
+
+	// Passed straight to the target. Mapping doesn't change what is bound, so it isn't counted in the stats.
+	void* Map(ID3D11Buffer* buffer, unsigned int size);
+	void Unmap(ID3D11Buffer* buffer);
+
+	// Passed straight to the target. Executing a list leaves the target's state as it was, so the cache stays valid.
+	CommandList* CreateCommandList();
+	void ExecuteCommandList(CommandList* commandList);
+
+	void DrawIndexed(int indexCount, int startIndex);
+	void DrawIndexedInstanced(int indexCount, int instanceCount, int startIndex, int startInstance);
+
+	StateCacheStats GetStats() const;
+
+private:
+	static const int StageCount = 2;
+
+	// One bound slot. FirstConstant and ConstantCount are only used by constant buffers, and are both 0 when the
+	// whole buffer is bound.
+	struct Binding
+	{
+		void* Resource;
+		unsigned int FirstConstant;
+		unsigned int ConstantCount;
+
+		bool operator==(const Binding& other) const
+		{
+			return Resource == other.Resource && FirstConstant == other.FirstConstant &&
+			       ConstantCount == other.ConstantCount;
+		}
+	};
+
+	enum SlotType
+	{
+		ConstantBufferSlots,
+		ShaderResourceSlots,
+		SamplerSlots,
+		SlotTypeCount
+	};
+
+	// The bindings of one slot type in one stage: what the target has, and what the next draw needs.
+	struct SlotState
+	{
+		Binding Bound[SlotCount];
+		Binding Pending[SlotCount];
+		bool Known[SlotCount];
+		int DirtyStart;
+		int DirtyEnd;
+	};
+
+	void SetSlot(ShaderStage stage, SlotType type, int slot, const Binding& binding);
+	void FlushSlots();
+	void FlushSlots(ShaderStage stage, SlotType type, SlotState& state);
+	static bool IsChanged(const SlotState& state, int slot);
+	void ForwardSlots(ShaderStage stage, SlotType type, int startSlot, int count, const Binding* bindings);
+
+	StateTarget* _pTarget;
+
+	ID3D11InputLayout* _pLayout;
+	ID3D11VertexShader* _pVertexShader;
+	ID3D11PixelShader* _pPixelShader;
+	ID3D11Buffer* _pVertexBuffers[SlotCount];
+	unsigned int _vertexStrides[SlotCount];
+	unsigned int _vertexOffsets[SlotCount];
+	ID3D11Buffer* _pIndexBuffer;
+	int _indexFormat;
+	int _topology;
+
+	// Input stage state is known once set, until the next Invalidate.
+	bool _layoutKnown;
+	bool _vertexShaderKnown;
+	bool _pixelShaderKnown;
+	bool _vertexBufferKnown[SlotCount];
+	bool _indexBufferKnown;
+	bool _topologyKnown;
+
+	SlotState _slots[StageCount][SlotTypeCount];
+	StateCacheStats _stats;
+};
@@ -1,8 +1,26 @@
 #include "System.h"
 #include "Graphics.h"
 #include "Input.h"
+#include "Profiler.h"
+#include <cwchar>
 
-System::System() = default;
+System::System()
+{
+	_applicationName = nullptr;
+	_pHinstance = nullptr;
+	_pHwnd = nullptr;
+	_pInput = nullptr;
+	_pGraphics = nullptr;
+	_traceFramesLeft = 0;
+	_pTraceFileName = nullptr;
+	_traceKeyDown = false;
+	_titleFrames = 0;
+	_titleConstantBytes = 0;
+	_titleInstanceBytes = 0;
+	_titleSkippedUploads = 0;
+	_titleStateChanges = 0;
+	_titleElidedStateChanges = 0;
+}
 
 System::~System()
 {
@@ -23,6 +41,14 @@ System::~System()
 
 bool System::Initialise()
 {
+	// Capture everything up to the end of the first frame, which includes loading and the start of the skybox bake.
+	Profiler::SetThreadName("Main");
+	if (Profiler::BeginCapture())
+	{
+		_traceFramesLeft = 1;
+		_pTraceFileName = "startup_trace.json";
+	}
+
 	// Initialize the width and height of the screen to zero before sending the variables into the function.
 	int screenWidth = 0;
 	int screenHeight = 0;
@@ -62,7 +88,7 @@ bool System::Initialise()
 	return true;
 }
 
-void System::Run() const
+void System::Run()
 {
 	MSG msg;
 
@@ -93,6 +119,9 @@ void System::Run() const
 			{
 				done = true;
 			}
+
+			UpdateTrace();
+			UpdateTitle();
 		}
 
 		// Check if the user pressed escape and wants to quit.
@@ -105,6 +134,8 @@ void System::Run() const
 
 bool System::Frame() const
 {
+	PROFILE_ZONE("System::Frame");
+
 	int mouseX, mouseY;
 
 	// Do the input frame processing.
@@ -134,6 +165,59 @@ bool System::Frame() const
 	return true;
 }
 
+void System::UpdateTrace()
+{
+	if (_traceFramesLeft > 0 && --_traceFramesLeft == 0)
+	{
+		// Failing to write the trace isn't fatal.
+		Profiler::EndCapture();
+		Profiler::WriteChromeTrace(_pTraceFileName);
+	}
+
+	// Only start on the frame F11 goes down, so holding it doesn't capture over and over.
+	const bool keyDown = _pInput->IsKeyDown(DIK_F11);
+	if (keyDown && !_traceKeyDown && _traceFramesLeft == 0 && Profiler::BeginCapture())
+	{
+		_traceFramesLeft = TraceFrameCount;
+		_pTraceFileName = "frame_trace.json";
+	}
+
+	_traceKeyDown = keyDown;
+}
+
+void System::UpdateTitle()
+{
+	_titleConstantBytes += _pGraphics->GetConstantUploadBytes();
+	_titleInstanceBytes += _pGraphics->GetInstanceUploadBytes();
+	_titleSkippedUploads += _pGraphics->GetSkippedUploads();
+
+	const StateCacheStats stateStats = _pGraphics->GetStateStats();
+	_titleStateChanges += stateStats.Requested;
+	_titleElidedStateChanges += stateStats.Elided;
+	if (++_titleFrames < TitleFrameCount)
+	{
+		return;
+	}
+
+	// Setting the title goes through the window's message queue, so it is only done every so often.
+	const CullingStats culling = _pGraphics->GetCullingStats();
+	const double frames = _titleFrames;
+	wchar_t title[256];
+	swprintf_s(title, L"%ls - %ls, %d visible, %d culled | Per frame: %.2f KB constants, %.2f KB instances, "
+	           L"%.1f uploads skipped, %.0f of %.0f state changes elided", _applicationName,
+	           _pGraphics->IsInstanced() ? L"instanced" : L"one draw per model", culling.Visible, culling.Culled,
+	           _titleConstantBytes / frames / 1024.0, _titleInstanceBytes / frames / 1024.0,
+	           _titleSkippedUploads / frames, _titleElidedStateChanges / frames, _titleStateChanges / frames);
+	SetWindowText(_pHwnd, title);
+
+	_titleFrames = 0;
+	_titleConstantBytes = 0;
+	_titleInstanceBytes = 0;
+	_titleSkippedUploads = 0;
+	_titleStateChanges = 0;
+	_titleElidedStateChanges = 0;
+}
+
 LRESULT CALLBACK System::MessageHandler(const HWND hwnd, const UINT umsg, const WPARAM wparam,
                                         const LPARAM lparam) const
 {
@@ -1,10 +1,16 @@
 #include "Texture.h"
 #include "DDSTextureLoader.h"
+#include "RenderTexture.h"
+#include "Profiler.h"
 #include <sstream>
 
 using namespace DirectX;
 
-Texture::Texture() = default;
+Texture::Texture()
+{
+	_pTexture = nullptr;
+	_pTextureSrv = nullptr;
+}
 
 Texture::~Texture()
 {
@@ -23,28 +29,17 @@ Texture::~Texture()
 
 bool Texture::Initialise(ID3D11Device* device, const wchar_t* fileName)
 {
-	const std::wstring relPath = std::wstring(fileName);
-	std::wstringstream str;
+	PROFILE_ZONE("Texture::Initialise");
 
-	// Since we're running DirectX, we don't have to worry about the lack of cross-platform for this API:
-	const HMODULE module = GetModuleHandle(nullptr);
-	if (module != nullptr)
-	{
-		WCHAR exePath[MAX_PATH];
-		GetModuleFileName(module, exePath, (sizeof(exePath)));
-		const std::wstring::size_type pos = std::wstring(exePath).find_last_of(L"\\/");
-		str << std::wstring(exePath).substr(0, pos);
-		str << "\\";
-		str << relPath;
-	}
-	else
+	const std::wstring fullPath = GetFullPath(fileName);
+	if (fullPath.empty())
 	{
 		return false;
 	}
 
 	// Load the texture in.
 	ID3D11Resource* texture;
-	const HRESULT result = CreateDDSTextureFromFile(device, str.str().c_str(), &texture, &_pTextureSrv);
+	const HRESULT result = CreateDDSTextureFromFile(device, fullPath.c_str(), &texture, &_pTextureSrv);
 	if (FAILED(result))
 	{
 		return false;
@@ -55,6 +50,78 @@ bool Texture::Initialise(ID3D11Device* device, const wchar_t* fileName)
 	return true;
 }
 
+bool Texture::Initialise(ID3D11Device* device, ID3D11DeviceContext* context, RenderTexture* source)
+{
+	D3D11_TEXTURE2D_DESC textureDesc;
+	source->GetTexture()->GetDesc(&textureDesc);
+
+	// Same layout as the render target, but only readable by shaders.
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	HRESULT result = device->CreateTexture2D(&textureDesc, nullptr, &_pTexture);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	context->CopyResource(_pTexture, source->GetTexture());
+
+	result = device->CreateShaderResourceView(_pTexture, nullptr, &_pTextureSrv);
+	return !FAILED(result);
+}
+
+bool Texture::Initialise(ID3D11Device* device, const int width, const int height, const uint16_t* texels)
+{
+	D3D11_TEXTURE2D_DESC textureDesc;
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_R16G16_FLOAT;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA data;
+	data.pSysMem = texels;
+	data.SysMemPitch = UINT(width * 2 * sizeof(uint16_t));
+	data.SysMemSlicePitch = 0;
+
+	HRESULT result = device->CreateTexture2D(&textureDesc, &data, &_pTexture);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	result = device->CreateShaderResourceView(_pTexture, nullptr, &_pTextureSrv);
+	return !FAILED(result);
+}
+
+std::wstring Texture::GetFullPath(const wchar_t* fileName)
+{
+	const std::wstring relPath = std::wstring(fileName);
+	std::wstringstream str;
+
+	// Since we're running DirectX, we don't have to worry about the lack of cross-platform for this API:
+	const HMODULE module = GetModuleHandle(nullptr);
+	if (module == nullptr)
+	{
+		return std::wstring();
+	}
+
+	WCHAR exePath[MAX_PATH];
+	GetModuleFileName(module, exePath, (sizeof(exePath)));
+	const std::wstring::size_type pos = std::wstring(exePath).find_last_of(L"\\/");
+	str << std::wstring(exePath).substr(0, pos);
+	str << "\\";
+	str << relPath;
+
+	return str.str();
+}
+
 ID3D11Texture2D* Texture::GetTexture() const
 {
 	return _pTexture;
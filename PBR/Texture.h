@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 struct ID3D11Device;
+struct ID3D11DeviceContext;
 struct ID3D11Texture2D;
 struct ID3D11ShaderResourceView;
+class RenderTexture;
 
 class Texture
 {
@@ -11,6 +16,11 @@ public:
 	~Texture();
 
 	bool Initialise(ID3D11Device* device, const wchar_t* fileName);
+	bool Initialise(ID3D11Device* device, ID3D11DeviceContext* context, RenderTexture* source);
+	// Two channel half float texture, such as the BRDF lookup table.
+	bool Initialise(ID3D11Device* device, int width, int height, const uint16_t* texels);
+
+	static std::wstring GetFullPath(const wchar_t* fileName);
 
 	ID3D11Texture2D* GetTexture() const;
 	ID3D11ShaderResourceView* GetSRV() const;
@@ -0,0 +1,109 @@
+#include "VertexPacking.h"
+#include "Graphics.h"
+#include <cmath>
+
+namespace
+{
+	short EncodeSnorm16(float value)
+	{
+		value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+		return short(std::floor(value * 32767.0f + 0.5f));
+	}
+
+	float DecodeSnorm16(const short value)
+	{
+		// Matches the D3D conversion rule, where both -32768 and -32767 map to -1.
+		const float decoded = float(value) / 32767.0f;
+		return decoded < -1.0f ? -1.0f : decoded;
+	}
+
+	float SignNotZero(const float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+VertexPacking::VertexPacking()
+{
+}
+
+VertexPacking::~VertexPacking()
+{
+}
+
+void VertexPacking::Pack(const FullVertexType* vertices, const int count, PackedVertexType* packed)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		const FullVertexType& vertex = vertices[i];
+		PackedVertexType& packedVertex = packed[i];
+
+		packedVertex.Position = vertex.Position;
+		EncodeNormal(vertex.Normal.x, vertex.Normal.y, vertex.Normal.z, packedVertex.Normal);
+		packedVertex.Uv[0] = EncodeUnorm16(vertex.Uv.x);
+		packedVertex.Uv[1] = EncodeUnorm16(vertex.Uv.y);
+	}
+}
+
+void VertexPacking::Unpack(const PackedVertexType* packed, const int count, FullVertexType* vertices)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		const PackedVertexType& packedVertex = packed[i];
+		FullVertexType& vertex = vertices[i];
+
+		float normal[3];
+		DecodeNormal(packedVertex.Normal, normal);
+
+		vertex.Position = packedVertex.Position;
+		vertex.Normal = XMFLOAT3(normal[0], normal[1], normal[2]);
+		vertex.Uv = XMFLOAT2(DecodeUnorm16(packedVertex.Uv[0]), DecodeUnorm16(packedVertex.Uv[1]));
+	}
+}
+
+void VertexPacking::EncodeNormal(const float x, const float y, const float z, short encoded[2])
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the upper one.
+	const float invLength = 1.0f / (std::fabs(x) + std::fabs(y) + std::fabs(z));
+	float u = x * invLength;
+	float v = y * invLength;
+
+	if (z < 0.0f)
+	{
+		const float foldedU = (1.0f - std::fabs(v)) * SignNotZero(u);
+		const float foldedV = (1.0f - std::fabs(u)) * SignNotZero(v);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	encoded[0] = EncodeSnorm16(u);
+	encoded[1] = EncodeSnorm16(v);
+}
+
+void VertexPacking::DecodeNormal(const short encoded[2], float normal[3])
+{
+	// Keep in sync with DecodeNormal in PBR.shader.
+	float x = DecodeSnorm16(encoded[0]);
+	float y = DecodeSnorm16(encoded[1]);
+	const float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+	const float t = z < 0.0f ? -z : 0.0f;
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	const float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+	normal[0] = x * invLength;
+	normal[1] = y * invLength;
+	normal[2] = z * invLength;
+}
+
+unsigned short VertexPacking::EncodeUnorm16(float value)
+{
+	value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+	return static_cast<unsigned short>(value * 65535.0f + 0.5f);
+}
+
+float VertexPacking::DecodeUnorm16(const unsigned short value)
+{
+	return float(value) / 65535.0f;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+struct FullVertexType;
+struct PackedVertexType;
+
+// Converts between FullVertexType and the quantised PackedVertexType.
+// Normals are octahedral encoded into two snorm16 values and UVs are stored as unorm16, which the input assembler
+// expands back to floats, so the vertex shader only has to unfold the octahedron. Unorm16 UVs cover [0, 1], the
+// range every generated shape uses; coordinates outside it are clamped.
+class VertexPacking
+{
+	VertexPacking();
+	~VertexPacking();
+
+public:
+	static void Pack(const FullVertexType* vertices, int count, PackedVertexType* packed);
+	static void Unpack(const PackedVertexType* packed, int count, FullVertexType* vertices);
+
+	// Expects a unit length normal.
+	static void EncodeNormal(float x, float y, float z, short encoded[2]);
+	static void DecodeNormal(const short encoded[2], float normal[3]);
+
+	static unsigned short EncodeUnorm16(float value);
+	static float DecodeUnorm16(unsigned short value);
+};
@@ -0,0 +1,55 @@
+#include "ViewCBuffer.h"
+#include "StateCache.h"
+
+ViewCBuffer::ViewCBuffer()
+{
+	_cameraVersion = 0;
+	_stats.Uploads = 0;
+	_stats.SkippedUploads = 0;
+	_stats.UploadBytes = 0;
+}
+
+ViewCBuffer::~ViewCBuffer()
+{
+}
+
+bool ViewCBuffer::Initialise(ID3D11Device* device)
+{
+	return CBuffer::Initialise(device, sizeof(ViewBufferType));
+}
+
+bool ViewCBuffer::Update(StateCache* stateCache, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, const XMFLOAT3 camPos, const unsigned long long cameraVersion)
+{
+	if (cameraVersion == _cameraVersion)
+	{
+		++_stats.SkippedUploads;
+		return true;
+	}
+
+	// Transpose the matrices to prepare them for the shader.
+	viewMatrix = XMMatrixTranspose(viewMatrix);
+	projectionMatrix = XMMatrixTranspose(projectionMatrix);
+
+	// Lock the constant buffer so it can be written to.
+	ViewBufferType* matrixPtr = static_cast<ViewBufferType*>(stateCache->Map(_pBuffer, sizeof(ViewBufferType)));
+	if (!matrixPtr)
+	{
+		return false;
+	}
+
+	matrixPtr->View = viewMatrix;
+	matrixPtr->Projection = projectionMatrix;
+	matrixPtr->CamPos = XMFLOAT4(camPos.x, camPos.y, camPos.z, 0.0f);
+
+	stateCache->Unmap(_pBuffer);
+
+	_cameraVersion = cameraVersion;
+	++_stats.Uploads;
+	_stats.UploadBytes += sizeof(ViewBufferType);
+	return true;
+}
+
+CBufferStats ViewCBuffer::GetStats() const
+{
+	return _stats;
+}
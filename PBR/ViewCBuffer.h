@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CBuffer.h"
+
+struct ViewBufferType
+{
+	XMMATRIX View;
+	XMMATRIX Projection;
+	XMFLOAT4 CamPos;
+};
+
+// The camera's matrices and position, the only frame constants that change from one view to the next. Only uploads
+// when the camera's version has changed since the last upload.
+class ViewCBuffer : public CBuffer
+{
+public:
+	ViewCBuffer();
+	virtual ~ViewCBuffer();
+
+	bool Initialise(ID3D11Device* device) override;
+	// cameraVersion is Camera::GetVersion, which changes whenever the matrices or position passed with it do.
+	bool Update(StateCache* stateCache, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, XMFLOAT3 camPos,
+	            unsigned long long cameraVersion);
+
+	CBufferStats GetStats() const;
+
+private:
+	unsigned long long _cameraVersion;
+	CBufferStats _stats;
+};
@@ -0,0 +1,469 @@
+#include "IBLBaker.h"
+#include "CpuTexture.h"
+#include "DDSFile.h"
+#include "BrdfLut.h"
+#include "EquirectToCubemap.h"
+#include "DrawBenchmark.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double GetElapsedSeconds(const Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	void PrintUsage()
+	{
+		std::printf("Usage: PBRBake <environment.dds> <output directory> [--threads N] [--sh] [--filtered] "
+		            "[--trace <trace.json>]\n");
+		std::printf("Bakes the environment cubemap, irradiance map, pre-filtered specular map and BRDF lookup table.\n");
+		std::printf("--sh builds the irradiance map from spherical harmonics instead of brute force convolution.\n");
+		std::printf("--filtered pre-filters with 64 filtered importance samples instead of 1024 plain ones.\n");
+		std::printf("--trace writes a Chrome trace of the bake, for chrome://tracing or Perfetto.\n");
+		std::printf("\n");
+		std::printf("Usage: PBRBake --brdf-header <header.h> [--size N] [--threads N]\n");
+		std::printf("Writes the BRDF lookup table as a constexpr array for Skybox to compile in.\n");
+		std::printf("\n");
+		std::printf("Usage: PBRBake --convert <equirect.dds> <cubemap.dds> [--size N] [--threads N]\n");
+		std::printf("Converts an equirectangular image to a half float cubemap, 2048 texels per face by default.\n");
+		std::printf("\n");
+		std::printf("Usage: PBRBake --benchmark <environment.dds> [--threads N] [--sh] [--filtered] "
+		            "[--trace <trace.json>]\n");
+		std::printf("Times each bake stage with 1, 2, 4 and so on up to N threads, every core by default.\n");
+		std::printf("\n");
+		std::printf("Usage: PBRBake --draws <count> [--meshes N] [--frames N] [--threads N] [--trace <trace.json>]\n");
+		std::printf("Records the renderer's non-instanced frame against a null device, straight into it and split "
+		            "across 2, 4 and so on up to N command lists.\n");
+	}
+
+	// Reads the options shared by a full bake and the benchmark, starting from argv[first].
+	bool ParseBakeOptions(const int argc, char** argv, const int first, IBLBakeSettings& settings, int& threadCount,
+	                      const char*& traceFileName)
+	{
+		for (int i = first; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			{
+				threadCount = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--sh") == 0)
+			{
+				settings.Irradiance = IrradianceMethod::SphericalHarmonics;
+			}
+			else if (std::strcmp(argv[i], "--filtered") == 0)
+			{
+				settings.PreFilter = PreFilterMethod::FilteredImportanceSampling;
+				settings.PreFilterSampleCount = 64;
+			}
+			else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			{
+				traceFileName = argv[++i];
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Ends the capture started for --trace, if there was one.
+	bool WriteTrace(const char* traceFileName)
+	{
+		if (!traceFileName)
+		{
+			return true;
+		}
+
+		Profiler::EndCapture();
+		if (!Profiler::WriteChromeTrace(traceFileName))
+		{
+			std::fprintf(stderr, "Could not write %s.\n", traceFileName);
+			return false;
+		}
+
+		return true;
+	}
+
+	int WriteBrdfHeader(const int argc, char** argv)
+	{
+		IBLBakeSettings settings;
+		settings.BrdfLookupSize = 128;
+		int threadCount = 0;
+
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			{
+				settings.BrdfLookupSize = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			{
+				threadCount = std::atoi(argv[++i]);
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		JobSystem jobs;
+		jobs.Initialise(threadCount);
+
+		const Clock::time_point start = Clock::now();
+		std::vector<float> scaleBias;
+		BrdfLut::Generate(settings.BrdfLookupSize, settings.BrdfSampleCount, jobs, scaleBias);
+		std::printf("BRDF lookup table: %.3fs\n", GetElapsedSeconds(start));
+
+		if (!BrdfLut::WriteHeader(argv[2], settings.BrdfLookupSize, settings.BrdfSampleCount, scaleBias))
+		{
+			std::fprintf(stderr, "Could not write %s.\n", argv[2]);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	int ConvertEquirect(const int argc, char** argv)
+	{
+		if (argc < 4)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		IBLBakeSettings settings;
+		int threadCount = 0;
+		for (int i = 4; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			{
+				settings.SkyboxSize = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			{
+				threadCount = std::atoi(argv[++i]);
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		CpuTexture equirect;
+		if (!DDSFile::Load(argv[2], equirect))
+		{
+			std::fprintf(stderr, "Could not load %s.\n", argv[2]);
+			return 1;
+		}
+
+		JobSystem jobs;
+		jobs.Initialise(threadCount);
+
+		const Clock::time_point start = Clock::now();
+		std::vector<uint16_t> texels;
+		EquirectToCubemap::Convert(equirect, settings.SkyboxSize, jobs, texels);
+		std::printf("Environment map: %.3fs\n", GetElapsedSeconds(start));
+
+		if (!DDSFile::Save(argv[3], texels.data(), settings.SkyboxSize, settings.SkyboxSize, 1, 6,
+		                   DDSFormat::R16G16B16A16Float, true))
+		{
+			std::fprintf(stderr, "Could not write %s.\n", argv[3]);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	int Benchmark(const int argc, char** argv)
+	{
+		IBLBakeSettings settings;
+		int maxThreadCount = 0;
+		const char* traceFileName = nullptr;
+		if (!ParseBakeOptions(argc, argv, 3, settings, maxThreadCount, traceFileName))
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		if (maxThreadCount <= 0)
+		{
+			maxThreadCount = std::max(1, int(std::thread::hardware_concurrency()));
+		}
+
+		if (traceFileName)
+		{
+			Profiler::BeginCapture();
+		}
+
+		// Loading maps the file and converts it to floats in place, which is single threaded.
+		const Clock::time_point loadStart = Clock::now();
+		CpuTexture equirect;
+		if (!DDSFile::Load(argv[2], equirect))
+		{
+			std::fprintf(stderr, "Could not load %s.\n", argv[2]);
+			return 1;
+		}
+
+		std::printf("Loaded %s in %.3fs.\n\n", argv[2], GetElapsedSeconds(loadStart));
+		std::printf("Threads  Environment  Irradiance  Pre-filter  BRDF LUT     Total  Speedup\n");
+
+		double singleThreadTotal = 0.0;
+		for (int threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreadCount))
+		{
+			JobSystem jobs;
+			jobs.Initialise(threadCount);
+
+			IBLBaker baker;
+			baker.Initialise(settings, &jobs);
+
+			CpuTexture environment, irradiance, preFilter, brdfLut;
+			double seconds[4];
+
+			Clock::time_point start = Clock::now();
+			baker.CreateEnvironmentMap(equirect, environment);
+			seconds[0] = GetElapsedSeconds(start);
+
+			start = Clock::now();
+			baker.CreateIrradianceMap(environment, irradiance);
+			seconds[1] = GetElapsedSeconds(start);
+
+			start = Clock::now();
+			baker.CreatePreFilterMap(environment, preFilter);
+			seconds[2] = GetElapsedSeconds(start);
+
+			start = Clock::now();
+			baker.CreateBrdfLUT(brdfLut);
+			seconds[3] = GetElapsedSeconds(start);
+
+			const double total = seconds[0] + seconds[1] + seconds[2] + seconds[3];
+			if (threadCount == 1)
+			{
+				singleThreadTotal = total;
+			}
+
+			std::printf("%7d  %10.3fs  %9.3fs  %9.3fs  %7.3fs  %7.3fs  %6.2fx\n", threadCount, seconds[0], seconds[1],
+			            seconds[2], seconds[3], total, singleThreadTotal / total);
+
+			if (threadCount == maxThreadCount)
+			{
+				break;
+			}
+		}
+
+		return WriteTrace(traceFileName) ? 0 : 1;
+	}
+
+	int BenchmarkDraws(const int argc, char** argv)
+	{
+		const int drawCount = std::atoi(argv[2]);
+		int meshCount = 1;
+		int frameCount = 1000;
+		int threadCount = 0;
+		const char* traceFileName = nullptr;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--meshes") == 0 && i + 1 < argc)
+			{
+				meshCount = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			{
+				frameCount = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			{
+				threadCount = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			{
+				traceFileName = argv[++i];
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		if (drawCount <= 0 || frameCount <= 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		JobSystem jobs;
+		jobs.Initialise(threadCount);
+
+		DrawBenchmark benchmark;
+		benchmark.Initialise(drawCount, meshCount, &jobs);
+
+		if (traceFileName)
+		{
+			Profiler::BeginCapture();
+		}
+
+		std::printf("Recording %d draws of %d meshes for %d frames.\n\n", drawCount, meshCount, frameCount);
+		std::printf("Lists  Frame (us)  Speedup  Requested  Forwarded   Elided  Device calls  Mapped (KB)\n");
+
+		const int maxListCount = jobs.GetThreadCount();
+		double singleListTime = 0.0;
+		for (int listCount = 1;; listCount = std::min(listCount * 2, maxListCount))
+		{
+			// One frame first, so the lists and scratch memory have grown to size before timing.
+			benchmark.RecordFrame(listCount);
+			benchmark.ResetStats();
+
+			const Clock::time_point start = Clock::now();
+			for (int i = 0; i < frameCount; ++i)
+			{
+				if (!benchmark.RecordFrame(listCount))
+				{
+					std::fprintf(stderr, "Could not record a frame into %d lists.\n", listCount);
+					return 1;
+				}
+			}
+
+			const double frameTime = GetElapsedSeconds(start) / frameCount;
+			if (listCount == 1)
+			{
+				singleListTime = frameTime;
+			}
+
+			// Counted per frame. Executing a list counts as a call of its own.
+			const NullStateTarget& target = benchmark.GetTarget();
+			unsigned long long calls = 0;
+			for (int i = 0; i < int(StateCommand::Count); ++i)
+			{
+				calls += target.GetCount(StateCommand(i));
+			}
+
+			const StateCacheStats stats = benchmark.GetStats();
+			std::printf("%5d  %10.1f  %6.2fx  %9llu  %9llu  %7llu  %12llu  %11.1f\n", listCount, frameTime * 1e6,
+			            singleListTime / frameTime, stats.Requested / frameCount, stats.Forwarded / frameCount,
+			            stats.Elided / frameCount, calls / frameCount,
+			            double(target.GetMappedBytes()) / frameCount / 1024.0);
+
+			if (listCount == maxListCount)
+			{
+				break;
+			}
+		}
+
+		return WriteTrace(traceFileName) ? 0 : 1;
+	}
+}
+
+int main(const int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Profiler::SetThreadName("Main");
+
+	if (std::strcmp(argv[1], "--brdf-header") == 0)
+	{
+		return WriteBrdfHeader(argc, argv);
+	}
+
+	if (std::strcmp(argv[1], "--convert") == 0)
+	{
+		return ConvertEquirect(argc, argv);
+	}
+
+	if (std::strcmp(argv[1], "--benchmark") == 0)
+	{
+		return Benchmark(argc, argv);
+	}
+
+	if (std::strcmp(argv[1], "--draws") == 0)
+	{
+		return BenchmarkDraws(argc, argv);
+	}
+
+	IBLBakeSettings settings;
+	int threadCount = 0;
+	const char* traceFileName = nullptr;
+	if (!ParseBakeOptions(argc, argv, 3, settings, threadCount, traceFileName))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const std::string outputDirectory = std::string(argv[2]) + "/";
+
+	JobSystem jobs;
+	jobs.Initialise(threadCount);
+
+	IBLBaker baker;
+	baker.Initialise(settings, &jobs);
+	std::printf("Baking with %d threads.\n", jobs.GetThreadCount());
+
+	if (traceFileName)
+	{
+		Profiler::BeginCapture();
+	}
+
+	const Clock::time_point totalStart = Clock::now();
+
+	// Load the equirectangular source image.
+	CpuTexture equirect;
+	if (!DDSFile::Load(argv[1], equirect))
+	{
+		std::fprintf(stderr, "Could not load %s.\n", argv[1]);
+		return 1;
+	}
+
+	Clock::time_point start = Clock::now();
+	CpuTexture environment;
+	baker.CreateEnvironmentMap(equirect, environment);
+	std::printf("Environment map: %.3fs\n", GetElapsedSeconds(start));
+
+	start = Clock::now();
+	CpuTexture irradiance;
+	baker.CreateIrradianceMap(environment, irradiance);
+	std::printf("Irradiance map: %.3fs\n", GetElapsedSeconds(start));
+
+	start = Clock::now();
+	CpuTexture preFilter;
+	baker.CreatePreFilterMap(environment, preFilter);
+	std::printf("Pre-filter map: %.3fs\n", GetElapsedSeconds(start));
+
+	start = Clock::now();
+	CpuTexture brdfLut;
+	baker.CreateBrdfLUT(brdfLut);
+	std::printf("BRDF lookup table: %.3fs\n", GetElapsedSeconds(start));
+
+	// Write everything out in the same formats the GPU bake uses.
+	bool result = DDSFile::Save((outputDirectory + "environment_cube.dds").c_str(), environment,
+	                            DDSFormat::R16G16B16A16Float, true);
+	result &= DDSFile::Save((outputDirectory + "irradiance.dds").c_str(), irradiance, DDSFormat::R16G16B16A16Float, true);
+	result &= DDSFile::Save((outputDirectory + "prefilter.dds").c_str(), preFilter, DDSFormat::R16G16B16A16Float, true);
+	result &= DDSFile::Save((outputDirectory + "brdf_lut.dds").c_str(), brdfLut, DDSFormat::R16G16B16A16Float, false);
+	if (!result)
+	{
+		std::fprintf(stderr, "Could not write the baked textures to %s.\n", argv[2]);
+		return 1;
+	}
+
+	std::printf("Total: %.3fs\n", GetElapsedSeconds(totalStart));
+	return WriteTrace(traceFileName) ? 0 : 1;
+}
@@ -129,6 +129,15 @@ namespace
 
 	HANDLE safe_handle(HANDLE h) { return (h == INVALID_HANDLE_VALUE) ? nullptr : h; }
 
+	struct view_closer
+	{
+		void operator()(const uint8_t* p) { if (p) UnmapViewOfFile(p); }
+	};
+
+	typedef
+	public
+	std::unique_ptr<const uint8_t, view_closer> ScopedView;
+
 	template <UINT TNameLength>
 	void SetDebugObjectName(_In_ ID3D11DeviceChild* resource, _In_ const char (&name)[TNameLength])
 	{
@@ -141,9 +150,11 @@ namespace
 	}
 
 	//--------------------------------------------------------------------------------------
+	// Maps the file rather than reading it, so the header is parsed in place and the subresource data handed to
+	// D3D points straight into the view. The view must outlive the texture's creation.
 	HRESULT LoadTextureDataFromFile(
 		_In_z_		       const wchar_t* fileName,
-		      		       std::unique_ptr<uint8_t[]>& ddsData,
+		      		       ScopedView& ddsData,
 		      		       const DDS_HEADER** header,
 		      		       const uint8_t** bitData,
 		      		       size_t* bitSize)
@@ -194,28 +205,23 @@ namespace
 			return E_FAIL;
 		}
 
-		// create enough space for the file data
-		ddsData.reset(new(std::nothrow) uint8_t[fileInfo.EndOfFile.LowPart]);
-		if (!ddsData)
-		{
-			return E_OUTOFMEMORY;
-		}
-
-		// read the data in
-		DWORD BytesRead = 0;
-		if (!ReadFile(hFile.get(),
-		              ddsData.get(),
-		              fileInfo.EndOfFile.LowPart,
-		              &BytesRead,
-		              nullptr
-		))
+		// map the file in. The view keeps its own references to the mapping and the file, so both handles can be
+		// closed once it exists, and the file can't be written to while it is mapped.
+		ScopedHandle hMapping(CreateFileMappingW(hFile.get(),
+		                                         nullptr,
+		                                         PAGE_READONLY,
+		                                         0,
+		                                         0,
+		                                         nullptr));
+		if (!hMapping)
 		{
 			return HRESULT_FROM_WIN32(GetLastError());
 		}
 
-		if (BytesRead < fileInfo.EndOfFile.LowPart)
+		ddsData.reset(static_cast<const uint8_t*>(MapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0)));
+		if (!ddsData)
 		{
-			return E_FAIL;
+			return HRESULT_FROM_WIN32(GetLastError());
 		}
 
 		// DDS files always start with the same magic number ("DDS ")
@@ -1775,7 +1781,7 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(ID3D11Device* d3dDevice,
 	const uint8_t* bitData = nullptr;
 	size_t bitSize = 0;
 
-	std::unique_ptr<uint8_t[]> ddsData;
+	ScopedView ddsData;
 	HRESULT hr = LoadTextureDataFromFile(fileName,
 	                                     ddsData,
 	                                     &header,